@@ -62,6 +62,46 @@ static void CoinSelection(benchmark::State& state)
     }
 }
 
+// Wallet coin selection over the many similar outputs of a staking wallet,
+// with BnB searching its whole budget for a selection with more inputs, then
+// with the knapsack solver.
+static void CoinSelectionStakingOutputs(benchmark::State& state)
+{
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node);
+    CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateDummy());
+    wallet.SetupLegacyScriptPubKeyMan();
+    std::vector<std::unique_ptr<CWalletTx>> wtxs;
+    LOCK(wallet.cs_wallet);
+
+    // Add coins.
+    for (int i = 0; i < 50000; ++i) {
+        addCoin(10 * COIN + (i % 100) * CENT, wallet, wtxs);
+    }
+
+    // Create groups
+    std::vector<OutputGroup> groups;
+    for (const auto& wtx : wtxs) {
+        COutput output(wtx.get(), 0 /* iIn */, 6 * 24 /* nDepthIn */, true /* spendable */, true /* solvable */, true /* safe */);
+        groups.emplace_back(output.GetInputCoin(), 6, false, 0, 0);
+    }
+
+    const CoinEligibilityFilter filter_standard(1, 6, 0);
+    const CoinSelectionParams bnb_params(true, 34, 148, CFeeRate(0), 0);
+    const CoinSelectionParams knapsack_params(false, 34, 148, CFeeRate(0), 0);
+    while (state.KeepRunning()) {
+        std::set<CInputCoin> setCoinsRet;
+        CAmount nValueRet;
+        bool bnb_used;
+        bool success = wallet.SelectCoinsMinConf(10 * (10 * COIN + 99 * CENT), filter_standard, groups, setCoinsRet, nValueRet, bnb_params, bnb_used);
+        assert(success);
+        assert(bnb_used);
+        success = wallet.SelectCoinsMinConf(1000 * COIN + 1, filter_standard, groups, setCoinsRet, nValueRet, knapsack_params, bnb_used);
+        assert(success);
+        assert(nValueRet > 1000 * COIN);
+    }
+}
+
 typedef std::set<CInputCoin> CoinSet;
 static NodeContext testNode;
 static auto testChain = interfaces::MakeChain(testNode);
@@ -112,4 +152,5 @@ static void BnBExhaustion(benchmark::State& state)
 }
 
 BENCHMARK(CoinSelection, 650);
+BENCHMARK(CoinSelectionStakingOutputs, 5);
 BENCHMARK(BnBExhaustion, 650);
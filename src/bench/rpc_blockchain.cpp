@@ -8,6 +8,7 @@
 #include <validation.h>
 #include <streams.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonstream.h>
 
 #include <univalue.h>
 
@@ -30,3 +31,25 @@ static void BlockToJsonVerbose(benchmark::State& state) {
 }
 
 BENCHMARK(BlockToJsonVerbose, 10);
+
+static void BlockToJsonVerboseStream(benchmark::State& state) {
+    CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
+    char a = '\0';
+    stream.write(&a, 1); // Prevent compaction
+
+    CBlock block;
+    stream >> block;
+
+    CBlockIndex blockindex;
+    const uint256 blockHash = block.GetHash();
+    blockindex.phashBlock = &blockHash;
+    blockindex.nBits = 403014710;
+
+    while (state.KeepRunning()) {
+        JSONStreamWriter writer([](const std::string&) { return true; });
+        blockToJSONStream(writer, block, &blockindex, &blockindex, /*verbose*/ true);
+        (void)writer.Finish();
+    }
+}
+
+BENCHMARK(BlockToJsonVerboseStream, 10);
@@ -0,0 +1,93 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <rpc/jsondocument.h>
+#include <rpc/jsonstream.h>
+
+#include <univalue.h>
+
+#include <string>
+
+/** A JSON-RPC batch of createrawtransaction calls, as sent by batch clients */
+static std::string MakeBatchRequest(int count)
+{
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < count; ++i) {
+        UniValue inputs(UniValue::VARR);
+        UniValue input(UniValue::VOBJ);
+        input.pushKV("txid", "4a5e1e4baab89f3a32518a88c31bc87f618f76673e2cc77ab2127b7afdeda33b");
+        input.pushKV("vout", i % 4);
+        inputs.push_back(input);
+        UniValue outputs(UniValue::VOBJ);
+        outputs.pushKV("VHk6e9sPsvWbNuaMpQtbBXbLA2Ubt2JnTK", 0.01 * (i + 1));
+        UniValue params(UniValue::VARR);
+        params.push_back(inputs);
+        params.push_back(outputs);
+        UniValue request(UniValue::VOBJ);
+        request.pushKV("jsonrpc", "1.0");
+        request.pushKV("id", i);
+        request.pushKV("method", "createrawtransaction");
+        request.pushKV("params", params);
+        batch.push_back(request);
+    }
+    return batch.write();
+}
+
+static void JsonReadUniValue(benchmark::State& state)
+{
+    const std::string json = MakeBatchRequest(1000);
+    while (state.KeepRunning()) {
+        UniValue value;
+        bool ok = value.read(json);
+        assert(ok);
+    }
+}
+
+static void JsonReadDocument(benchmark::State& state)
+{
+    const std::string json = MakeBatchRequest(1000);
+    JSONDocument doc;
+    while (state.KeepRunning()) {
+        bool ok = doc.Parse(json);
+        assert(ok);
+    }
+}
+
+static void JsonReadDocumentToUniValue(benchmark::State& state)
+{
+    const std::string json = MakeBatchRequest(1000);
+    JSONDocument doc;
+    while (state.KeepRunning()) {
+        bool ok = doc.Parse(json);
+        assert(ok);
+        (void)doc.Root().ToUniValue();
+    }
+}
+
+static void JsonWriteUniValue(benchmark::State& state)
+{
+    UniValue value;
+    value.read(MakeBatchRequest(1000));
+    while (state.KeepRunning()) {
+        (void)value.write();
+    }
+}
+
+static void JsonWriteStream(benchmark::State& state)
+{
+    UniValue value;
+    value.read(MakeBatchRequest(1000));
+    while (state.KeepRunning()) {
+        JSONStreamWriter writer([](const std::string&) { return true; });
+        writer.Value(value);
+        (void)writer.Finish();
+    }
+}
+
+BENCHMARK(JsonReadUniValue, 50);
+BENCHMARK(JsonReadDocument, 500);
+BENCHMARK(JsonReadDocumentToUniValue, 100);
+BENCHMARK(JsonWriteUniValue, 100);
+BENCHMARK(JsonWriteStream, 100);
@@ -0,0 +1,28 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <interfaces/chain.h>
+#include <node/context.h>
+#include <wallet/wallet.h>
+
+// Refill the keypool of a fresh HD wallet with 100k keys, half of them on the
+// internal chain.
+static void WalletKeypoolRefill(benchmark::State& state)
+{
+    NodeContext node;
+    std::unique_ptr<interfaces::Chain> chain = interfaces::MakeChain(node);
+
+    while (state.KeepRunning()) {
+        CWallet wallet{chain.get(), WalletLocation(), WalletDatabase::CreateDummy()};
+        wallet.SetMinVersion(FEATURE_LATEST);
+        LegacyScriptPubKeyMan& keyman = *wallet.GetOrCreateLegacyScriptPubKeyMan();
+        keyman.SetHDSeed(keyman.GenerateNewSeed());
+        bool ok = keyman.TopUp(50000);
+        assert(ok);
+        assert(keyman.GetKeyPoolSize() == 100000);
+    }
+}
+
+BENCHMARK(WalletKeypoolRefill, 1);
@@ -11,6 +11,7 @@
 #include <script/standard.h>
 #include <serialize.h>
 #include <streams.h>
+#include <undo.h>
 #include <univalue.h>
 #include <util/system.h>
 #include <util/strencodings.h>
@@ -175,7 +176,7 @@ void ScriptPubKeyToUniv(const CScript& scriptPubKey,
     out.pushKV("addresses", a);
 }
 
-void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex, int serialize_flags)
+void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry, bool include_hex, int serialize_flags, const CTxUndo* txundo)
 {
     entry.pushKV("txid", tx.GetHash().GetHex());
     entry.pushKV("hash", tx.GetWitnessHash().GetHex());
@@ -186,6 +187,12 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
     entry.pushKV("weight", GetTransactionWeight(tx));
     entry.pushKV("locktime", (int64_t)tx.nLockTime);
 
+    // Spent outputs are only known if the caller has the undo data of a
+    // confirmed, non-coinbase transaction
+    const bool have_prevouts = txundo && !tx.IsCoinBase() && txundo->vprevout.size() == tx.vin.size();
+    CAmount amt_total_in = 0;
+    CAmount amt_total_out = 0;
+
     UniValue vin(UniValue::VARR);
     for (unsigned int i = 0; i < tx.vin.size(); i++) {
         const CTxIn& txin = tx.vin[i];
@@ -206,6 +213,19 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
                 }
                 in.pushKV("txinwitness", txinwitness);
             }
+            if (have_prevouts) {
+                const Coin& prev_coin = txundo->vprevout[i];
+                amt_total_in += prev_coin.out.nValue;
+                UniValue p(UniValue::VOBJ);
+                p.pushKV("generated", bool(prev_coin.fCoinBase));
+                p.pushKV("coinstake", prev_coin.fCoinStake);
+                p.pushKV("height", (int64_t)prev_coin.nHeight);
+                p.pushKV("value", ValueFromAmount(prev_coin.out.nValue));
+                UniValue o_script_pub_key(UniValue::VOBJ);
+                ScriptPubKeyToUniv(prev_coin.out.scriptPubKey, o_script_pub_key, true);
+                p.pushKV("scriptPubKey", o_script_pub_key);
+                in.pushKV("prevout", p);
+            }
         }
         in.pushKV("sequence", (int64_t)txin.nSequence);
         vin.push_back(in);
@@ -220,6 +240,7 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
 
         out.pushKV("value", ValueFromAmount(txout.nValue));
         out.pushKV("n", (int64_t)i);
+        amt_total_out += txout.nValue;
 
         UniValue o(UniValue::VOBJ);
         ScriptPubKeyToUniv(txout.scriptPubKey, o, true);
@@ -228,6 +249,11 @@ void TxToUniv(const CTransaction& tx, const uint256& hashBlock, UniValue& entry,
     }
     entry.pushKV("vout", vout);
 
+    // A coinstake pays out more than it spends, it has no fee
+    if (have_prevouts && !tx.IsCoinStake()) {
+        entry.pushKV("fee", ValueFromAmount(amt_total_in - amt_total_out));
+    }
+
     if (!hashBlock.IsNull())
         entry.pushKV("blockhash", hashBlock.GetHex());
 
@@ -7,6 +7,8 @@
 #include <chainparams.h>
 #include <crypto/hmac_sha256.h>
 #include <httpserver.h>
+#include <rpc/jsondocument.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <ui_interface.h>
@@ -28,6 +30,15 @@
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+/** Bodies larger than this are queued with low priority without looking at them */
+static const size_t MAX_CLASSIFY_BODY_SIZE = 1024 * 1024;
+
+/** Methods that may keep a worker busy for a long time */
+static const std::set<std::string> SLOW_RPC_METHODS{
+    "dumptxoutset", "dumpwallet", "gettxoutsetinfo", "importaddress", "importmulti", "importprivkey",
+    "importpubkey", "importwallet", "rescanblockchain", "scantxoutset", "verifychain",
+};
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -90,6 +101,21 @@ static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const Uni
     req->WriteReply(nStatus, strReply);
 }
 
+/** Send the successful reply to a single request. Large results are serialized
+ * and sent to the client in chunks instead of being rendered into one string.
+ */
+static void JSONResultReply(HTTPRequest* req, const UniValue& result, const UniValue& id)
+{
+    req->WriteHeader("Content-Type", "application/json");
+    JSONStreamWriter writer([req](const std::string& chunk) { return req->WriteReplyChunk(HTTP_OK, chunk); });
+    writer.BeginObject();
+    writer.Pair("result", result);
+    writer.Pair("error", NullUniValue);
+    writer.Pair("id", id);
+    writer.EndObject();
+    req->WriteReply(HTTP_OK, writer.Finish() + "\n");
+}
+
 //This function checks username and password against -rpcauth
 //entries from config file.
 static bool multiUserAuthorized(std::string strUserPass)
@@ -151,6 +177,109 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+static HTTPPriority RPCMethodPriority(const std::string& name)
+{
+    if (SLOW_RPC_METHODS.count(name)) return HTTPPriority::LOW;
+    return tableRPC.isParallelSafe(name) ? HTTPPriority::HIGH : HTTPPriority::NORMAL;
+}
+
+static bool IsJSONSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/** Queue cheap reads ahead of wallet and other calls, and those ahead of long
+ * scans. A batch gets the lowest priority of its calls.
+ *
+ * This runs on the event thread for every request, so the body is not
+ * parsed: only its nesting and the "method" members of the request objects
+ * are scanned. Anything unexpected gets NORMAL priority; the handler
+ * reports the errors. */
+HTTPPriority JSONRPCRequestPriority(const char* body, size_t size)
+{
+    static const std::string METHOD_KEY{"method"};
+    const char* p = body;
+    const char* const end = body + size;
+    while (p < end && IsJSONSpace(*p)) ++p;
+    if (p == end || (*p != '{' && *p != '[')) return HTTPPriority::NORMAL;
+    // A single request is the top level object, a batch holds them in an array
+    const int request_depth = *p == '[' ? 2 : 1;
+
+    HTTPPriority priority = HTTPPriority::HIGH;
+    int depth = 0;
+    bool has_method = false;
+    bool expect_method = false;
+    while (p < end) {
+        const char c = *p++;
+        if (IsJSONSpace(c) || c == ',') continue;
+        if (c == '"') {
+            const char* const str_begin = p;
+            bool escaped = false;
+            while (p < end && *p != '"') {
+                if (*p == '\\') {
+                    escaped = true;
+                    ++p;
+                }
+                ++p;
+            }
+            if (p >= end) return HTTPPriority::NORMAL;
+            const char* const str_end = p++;
+            if (depth != request_depth) {
+                // A batch element that is not an object
+                if (depth < request_depth) priority = std::max(priority, HTTPPriority::NORMAL);
+                continue;
+            }
+            if (expect_method) {
+                expect_method = false;
+                has_method = true;
+                priority = std::max(priority, escaped ? HTTPPriority::NORMAL : RPCMethodPriority(std::string(str_begin, str_end)));
+                continue;
+            }
+            while (p < end && IsJSONSpace(*p)) ++p;
+            if (p < end && *p == ':') {
+                ++p;
+                expect_method = METHOD_KEY.compare(0, std::string::npos, str_begin, str_end - str_begin) == 0;
+            }
+            continue;
+        }
+        if (depth == request_depth && expect_method) {
+            // The method is not a string
+            expect_method = false;
+            has_method = true;
+            priority = std::max(priority, HTTPPriority::NORMAL);
+        }
+        if (c == '{' || c == '[') {
+            if (++depth == request_depth) {
+                if (c != '{') priority = std::max(priority, HTTPPriority::NORMAL);
+                has_method = false;
+            }
+        } else if (c == '}' || c == ']') {
+            if (depth == request_depth && !has_method) priority = std::max(priority, HTTPPriority::NORMAL);
+            if (--depth == 0) return priority;
+        } else if (depth < request_depth) {
+            // A batch element that is not an object
+            priority = std::max(priority, HTTPPriority::NORMAL);
+        }
+    }
+    return HTTPPriority::NORMAL;
+}
+
+static HTTPPriority HTTPReq_JSONRPCPriority(HTTPRequest* req, const std::string &)
+{
+    // Runs on the event thread: leave requests the handler is going to
+    // reject to it, and never let a body throw here.
+    if (req->GetRequestMethod() != HTTPRequest::POST) return HTTPPriority::NORMAL;
+    std::pair<bool, std::string> authHeader = req->GetHeader("authorization");
+    std::string user;
+    if (!authHeader.first || !RPCAuthorized(authHeader.second, user)) return HTTPPriority::NORMAL;
+
+    size_t size;
+    const char* body = req->PeekBody(size);
+    if (!body) return HTTPPriority::NORMAL;
+    if (size > MAX_CLASSIFY_BODY_SIZE) return HTTPPriority::LOW;
+    return JSONRPCRequestPriority(body, size);
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -168,6 +297,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 
     JSONRPCRequest jreq;
     jreq.peerAddr = req->GetPeer().ToString();
+    jreq.queueTime = req->GetQueueTime();
     if (!RPCAuthorized(authHeader.second, jreq.authUser)) {
         LogPrintf("ThreadRPCServer incorrect password attempt from %s\n", jreq.peerAddr);
 
@@ -182,10 +312,14 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
     }
 
     try {
-        // Parse request
-        UniValue valRequest;
-        if (!valRequest.read(req->ReadBody()))
+        // Parse request. The document refers into the body, so it is only
+        // peeked at; the body stays in place until the reply.
+        size_t size;
+        const char* body = req->PeekBody(size);
+        JSONDocument doc;
+        if (!doc.Parse(body ? body : "", size))
             throw JSONRPCError(RPC_PARSE_ERROR, "Parse error");
+        const JSONValue valRequest = doc.Root();
 
         // Set the URI
         jreq.URI = req->GetURI();
@@ -208,18 +342,18 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
             UniValue result = tableRPC.execute(jreq);
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            JSONResultReply(req, result, jreq.id);
+            return true;
 
         // array of requests
         } else if (valRequest.isArray()) {
             if (user_has_whitelist) {
-                for (unsigned int reqIdx = 0; reqIdx < valRequest.size(); reqIdx++) {
-                    if (!valRequest[reqIdx].isObject()) {
+                for (const JSONValue& request : valRequest.getValues()) {
+                    if (!request.isObject()) {
                         throw JSONRPCError(RPC_INVALID_REQUEST, "Invalid Request object");
                     } else {
-                        const UniValue& request = valRequest[reqIdx].get_obj();
                         // Parse method
-                        std::string strMethod = find_value(request, "method").get_str();
+                        std::string strMethod = request["method"].get_str();
                         if (!g_rpc_whitelist[jreq.authUser].count(strMethod)) {
                             LogPrintf("RPC User %s not allowed to call method %s\n", jreq.authUser, strMethod);
                             req->WriteReply(HTTP_FORBIDDEN);
@@ -228,7 +362,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            strReply = JSONRPCExecBatch(jreq, valRequest);
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
@@ -294,9 +428,9 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, HTTPReq_JSONRPCPriority);
     if (g_wallet_init_interface.HasWalletSupport()) {
-        RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC);
+        RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC, HTTPReq_JSONRPCPriority);
     }
     struct event_base* eventBase = EventBase();
     assert(eventBase);
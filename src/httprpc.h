@@ -5,6 +5,7 @@
 #ifndef BITCOIN_HTTPRPC_H
 #define BITCOIN_HTTPRPC_H
 
+#include <httpserver.h>
 
 /** Start HTTP RPC subsystem.
  * Precondition; HTTP and RPC has been started.
@@ -18,6 +19,9 @@ void InterruptHTTPRPC();
  */
 void StopHTTPRPC();
 
+/** Work queue lane of a JSON-RPC request or batch body */
+HTTPPriority JSONRPCRequestPriority(const char* body, size_t size);
+
 /** Start HTTP REST subsystem.
  * Precondition; HTTP and RPC has been started.
  */
@@ -9,6 +9,7 @@
 #include <util/threadnames.h>
 #include <util/system.h>
 #include <util/strencodings.h>
+#include <util/time.h>
 #include <netbase.h>
 #include <rpc/protocol.h> // For HTTP status codes
 #include <shutdown.h>
@@ -16,10 +17,12 @@
 #include <ui_interface.h>
 
 #include <deque>
+#include <list>
 #include <memory>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
+#include <thread>
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -41,17 +44,33 @@
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
+/** Bytes of a chunked reply that may be waiting to be sent before the worker producing it blocks */
+static const size_t MAX_CHUNKED_REPLY_PENDING = 1024 * 1024;
+
+/** Progress of a chunked reply, shared between the worker producing it and the event thread sending it */
+struct HTTPChunkedReply
+{
+    Mutex cs;
+    std::condition_variable cond;
+    //! Bytes queued for the event thread that have not been handed to libevent yet
+    size_t queued GUARDED_BY(cs){0};
+    //! Bytes handed to libevent that have not been written to the socket yet
+    size_t unsent GUARDED_BY(cs){0};
+    //! The connection went away before the reply was finished
+    bool closed GUARDED_BY(cs){false};
+};
 
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure
 {
 public:
     HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, const HTTPRequestHandler& _func):
-        req(std::move(_req)), path(_path), func(_func)
+        req(std::move(_req)), path(_path), func(_func), queued(GetTimeMicros())
     {
     }
     void operator()() override
     {
+        req->m_queue_time = GetTimeMicros() - queued;
         func(req.get(), path);
     }
 
@@ -60,60 +79,141 @@ public:
 private:
     std::string path;
     HTTPRequestHandler func;
+    int64_t queued;
 };
 
-/** Simple work queue for distributing work over multiple threads.
- * Work items are simply callable objects.
+/** Work queue for distributing work over a pool of threads.
+ * Work items are simply callable objects, queued in one of several lanes.
+ * Lanes are served in priority order, and each lane may only occupy a limited
+ * number of workers at once. The pool starts with min_threads workers and
+ * grows up to max_threads while no worker is idle; workers above the minimum
+ * exit after having been idle for a while.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
+    struct Lane {
+        std::deque<std::unique_ptr<WorkItem>> queue;
+        size_t active{0};
+        size_t max_active{0};
+    };
+
     /** Mutex protects entire object */
     Mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
-    bool running;
+    Lane lanes[HTTP_PRIORITY_COUNT] GUARDED_BY(cs);
+    bool running GUARDED_BY(cs);
     size_t maxDepth;
+    const int min_threads;
+    const int max_threads;
+    int num_threads GUARDED_BY(cs){0};
+    int num_idle GUARDED_BY(cs){0};
+    int next_worker_num GUARDED_BY(cs){0};
+    std::list<std::thread> threads GUARDED_BY(cs);
+    //! Workers that exited after being idle, to be joined
+    std::vector<std::thread::id> exited GUARDED_BY(cs);
+
+    void StartWorker() EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        for (const std::thread::id& id : exited) {
+            for (auto it = threads.begin(); it != threads.end(); ++it) {
+                if (it->get_id() == id) {
+                    it->join();
+                    threads.erase(it);
+                    break;
+                }
+            }
+        }
+        exited.clear();
+        ++num_threads;
+        threads.emplace_back(&WorkQueue::Run, this, next_worker_num++);
+    }
+
+    /** Take the next item from the highest priority lane that may use another worker */
+    bool Pick(std::unique_ptr<WorkItem>& item, int& lane) EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        for (lane = 0; lane < HTTP_PRIORITY_COUNT; ++lane) {
+            Lane& l = lanes[lane];
+            if (!l.queue.empty() && l.active < l.max_active) {
+                item = std::move(l.queue.front());
+                l.queue.pop_front();
+                ++l.active;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Thread function */
+    void Run(int worker_num)
+    {
+        util::ThreadRename(strprintf("httpworker.%i", worker_num));
+        int lane = -1;
+        bool timed_out = false;
+        while (true) {
+            std::unique_ptr<WorkItem> i;
+            {
+                WAIT_LOCK(cs, lock);
+                if (lane >= 0) {
+                    --lanes[lane].active;
+                    // The lane may have been at its cap, leaving queued items behind
+                    if (!lanes[lane].queue.empty()) cond.notify_one();
+                }
+                ++num_idle;
+                while (true) {
+                    if (running && Pick(i, lane)) break;
+                    if (!running || (timed_out && num_threads > min_threads)) {
+                        --num_idle;
+                        --num_threads;
+                        if (running) exited.push_back(std::this_thread::get_id());
+                        return;
+                    }
+                    timed_out = cond.wait_for(lock, std::chrono::seconds(HTTP_WORKER_IDLE_TIMEOUT)) == std::cv_status::timeout;
+                }
+                --num_idle;
+                timed_out = false;
+            }
+            (*i)();
+        }
+    }
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : running(true),
-                                 maxDepth(_maxDepth)
+    WorkQueue(size_t _maxDepth, int _min_threads, int _max_threads) : running(true),
+                                 maxDepth(_maxDepth),
+                                 min_threads(_min_threads),
+                                 max_threads(std::max(_min_threads, _max_threads))
     {
+        lanes[int(HTTPPriority::HIGH)].max_active = max_threads;
+        lanes[int(HTTPPriority::NORMAL)].max_active = std::max(1, max_threads / 2);
+        lanes[int(HTTPPriority::LOW)].max_active = std::max(1, max_threads / 4);
     }
     /** Precondition: worker threads have all stopped (they have been joined).
      */
     ~WorkQueue()
     {
     }
+    /** Start the minimum number of workers */
+    void Start()
+    {
+        LOCK(cs);
+        while (num_threads < min_threads) StartWorker();
+    }
     /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
+    bool Enqueue(WorkItem* item, HTTPPriority priority)
     {
         LOCK(cs);
-        if (queue.size() >= maxDepth) {
+        Lane& lane = lanes[int(priority)];
+        if (lane.queue.size() >= maxDepth) {
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        lane.queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        if (running && num_idle == 0 && num_threads < max_threads && lane.active < lane.max_active) {
+            StartWorker();
+        }
         cond.notify_one();
         return true;
     }
-    /** Thread function */
-    void Run()
-    {
-        while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty())
-                    cond.wait(lock);
-                if (!running)
-                    break;
-                i = std::move(queue.front());
-                queue.pop_front();
-            }
-            (*i)();
-        }
-    }
     /** Interrupt and exit loops */
     void Interrupt()
     {
@@ -121,17 +221,40 @@ public:
         running = false;
         cond.notify_all();
     }
+    /** Wait for all workers to exit. Call after Interrupt(). */
+    void Join()
+    {
+        std::list<std::thread> to_join;
+        WITH_LOCK(cs, to_join.swap(threads); exited.clear());
+        for (std::thread& thread : to_join) {
+            thread.join();
+        }
+    }
+    void GetInfo(HTTPWorkQueueInfo& info)
+    {
+        LOCK(cs);
+        info.threads = num_threads;
+        info.idle_threads = num_idle;
+        info.min_threads = min_threads;
+        info.max_threads = max_threads;
+        for (int i = 0; i < HTTP_PRIORITY_COUNT; ++i) {
+            info.lanes[i].queued = lanes[i].queue.size();
+            info.lanes[i].active = lanes[i].active;
+            info.lanes[i].max_active = lanes[i].max_active;
+        }
+    }
 };
 
 struct HTTPPathHandler
 {
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
 };
 
 /** HTTP module state */
@@ -262,9 +385,16 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
+        // Small replies on kept-alive connections must not wait for the
+        // client's delayed ACK before going out
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn && evhttp_connection_get_bufferevent(conn)) {
+            SetSocketNoDelay(bufferevent_getfd(evhttp_connection_get_bufferevent(conn)));
+        }
+        const HTTPPriority priority = i->classifier ? i->classifier(hreq.get(), path) : HTTPPriority::NORMAL;
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
         assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        if (workQueue->Enqueue(item.get(), priority))
             item.release(); /* if true, queue took ownership */
         else {
             LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
@@ -335,13 +465,6 @@ static bool HTTPBindAddresses(struct evhttp* http)
     return !boundSockets.empty();
 }
 
-/** Simple wrapper to set thread name and run work queue */
-static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue, int worker_num)
-{
-    util::ThreadRename(strprintf("httpworker.%i", worker_num));
-    queue->Run();
-}
-
 /** libevent event log callback */
 static void libevent_log_cb(int severity, const char *msg)
 {
@@ -397,9 +520,11 @@ bool InitHTTPServer()
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
     int workQueueDepth = std::max((long)gArgs.GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
+    int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    int rpcMaxThreads = std::max((long)gArgs.GetArg("-rpcmaxthreads", std::max(DEFAULT_HTTP_MAX_THREADS, rpcThreads)), (long)rpcThreads);
+    LogPrintf("HTTP: creating work queue of depth %d per lane for %d to %d worker threads\n", workQueueDepth, rpcThreads, rpcMaxThreads);
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth, rpcThreads, rpcMaxThreads);
     // transfer ownership to eventBase/HTTP via .release()
     eventBase = base_ctr.release();
     eventHTTP = http_ctr.release();
@@ -421,18 +546,12 @@ bool UpdateHTTPServerLogging(bool enable) {
 }
 
 static std::thread threadHTTP;
-static std::vector<std::thread> g_thread_http_workers;
 
 void StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
     threadHTTP = std::thread(ThreadHTTP, eventBase);
-
-    for (int i = 0; i < rpcThreads; i++) {
-        g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i);
-    }
+    workQueue->Start();
 }
 
 void InterruptHTTPServer()
@@ -451,10 +570,7 @@ void StopHTTPServer()
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
     if (workQueue) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
-        for (auto& thread: g_thread_http_workers) {
-            thread.join();
-        }
-        g_thread_http_workers.clear();
+        workQueue->Join();
         delete workQueue;
         workQueue = nullptr;
     }
@@ -479,6 +595,26 @@ void StopHTTPServer()
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
+bool GetHTTPWorkQueueInfo(HTTPWorkQueueInfo& info)
+{
+    if (!workQueue) return false;
+    workQueue->GetInfo(info);
+    return true;
+}
+
+std::string HTTPPriorityString(HTTPPriority priority)
+{
+    switch (priority) {
+    case HTTPPriority::HIGH:
+        return "high";
+    case HTTPPriority::NORMAL:
+        return "normal";
+    case HTTPPriority::LOW:
+        return "low";
+    }
+    assert(false);
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
@@ -555,6 +691,17 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+const char* HTTPRequest::PeekBody(size_t& size)
+{
+    size = 0;
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return nullptr;
+    size = evbuffer_get_length(buf);
+    // Makes the buffer contiguous, so the pullup in ReadBody() is free
+    return (const char*)evbuffer_pullup(buf, size);
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -562,6 +709,40 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/** Re-enable reading from the socket. This is the second part of the libevent
+ * workaround in http_request_cb.
+ */
+static void http_reenable_read(struct evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
+/** Called by libevent when all chunks queued so far have been written to the socket */
+static void http_chunk_sent_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPChunkedReply* chunked = static_cast<HTTPChunkedReply*>(arg);
+    LOCK(chunked->cs);
+    chunked->unsent = 0;
+    chunked->cond.notify_all();
+}
+
+/** Called by libevent when the connection of a chunked reply is closed */
+static void http_chunked_close_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPChunkedReply* chunked = static_cast<HTTPChunkedReply*>(arg);
+    LOCK(chunked->cs);
+    chunked->closed = true;
+    chunked->cond.notify_all();
+}
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
@@ -570,6 +751,32 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
     assert(!replySent && req);
+    if (m_chunked) {
+        // Send the remainder as last chunk and terminate the chunked reply
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        evbuffer_add(evb, strReply.data(), strReply.size());
+        auto req_copy = req;
+        std::shared_ptr<HTTPChunkedReply> chunked = m_chunked;
+        HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, chunked, evb]{
+            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+            if (conn) {
+                // The connection outlives this reply when kept alive
+                evhttp_connection_set_closecb(conn, nullptr, nullptr);
+                if (evbuffer_get_length(evb) > 0) {
+                    evhttp_send_reply_chunk(req_copy, evb);
+                }
+            }
+            evbuffer_free(evb);
+            // Also frees the request if the connection is already gone
+            evhttp_send_reply_end(req_copy);
+            if (conn) http_reenable_read(req_copy);
+        });
+        ev->trigger(nullptr);
+        replySent = true;
+        req = nullptr; // transferred back to main thread
+        return;
+    }
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
@@ -580,23 +787,74 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
-        }
+        http_reenable_read(req_copy);
     });
     ev->trigger(nullptr);
     replySent = true;
     req = nullptr; // transferred back to main thread
 }
 
+bool HTTPRequest::WriteReplyChunk(int nStatus, const std::string& chunk)
+{
+    assert(!replySent && req);
+    const bool start = !m_chunked;
+    if (start) {
+        m_chunked = std::make_shared<HTTPChunkedReply>();
+        // Headers go out with the first chunk
+        if (ShutdownRequested()) {
+            WriteHeader("Connection", "close");
+        }
+    } else {
+        // Apply backpressure: wait for the client to catch up with earlier chunks
+        WAIT_LOCK(m_chunked->cs, lock);
+        while (!m_chunked->closed && m_chunked->queued + m_chunked->unsent > MAX_CHUNKED_REPLY_PENDING) {
+            if (ShutdownRequested()) return false;
+            m_chunked->cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        if (m_chunked->closed) return false;
+    }
+    if (chunk.empty() && !start) return true;
+    {
+        LOCK(m_chunked->cs);
+        m_chunked->queued += chunk.size();
+    }
+
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, chunk.data(), chunk.size());
+    auto req_copy = req;
+    std::shared_ptr<HTTPChunkedReply> chunked = m_chunked;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, chunked, evb, start, nStatus]{
+        {
+            LOCK(chunked->cs);
+            const size_t size = evbuffer_get_length(evb);
+            chunked->queued -= size;
+            chunked->unsent += size;
+        }
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (!conn) {
+            // Client went away; the request is freed once the reply is ended
+            http_chunked_close_cb(nullptr, chunked.get());
+        } else {
+            if (start) {
+                evhttp_send_reply_start(req_copy, nStatus, nullptr);
+                evhttp_connection_set_closecb(conn, http_chunked_close_cb, chunked.get());
+            }
+            if (evbuffer_get_length(evb) > 0) {
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+                evhttp_send_reply_chunk_with_cb(req_copy, evb, http_chunk_sent_cb, chunked.get());
+#else
+                evhttp_send_reply_chunk(req_copy, evb);
+                http_chunk_sent_cb(conn, chunked.get());
+#endif
+            }
+        }
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+    return true;
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -637,10 +895,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod() const
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
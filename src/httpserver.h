@@ -5,17 +5,23 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
-#include <string>
 #include <functional>
+#include <memory>
+#include <stdint.h>
+#include <string>
 
 static const int DEFAULT_HTTP_THREADS=4;
+static const int DEFAULT_HTTP_MAX_THREADS=16;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+//! Seconds a worker above the -rpcthreads minimum may stay idle before it exits
+static const int HTTP_WORKER_IDLE_TIMEOUT=60;
 
 struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPChunkedReply;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -35,13 +41,43 @@ void StopHTTPServer();
  * libevent doesn't support debug logging.*/
 bool UpdateHTTPServerLogging(bool enable);
 
+/** Work queue lanes. Each lane has its own queue and a cap on the number of
+ * workers it may occupy, so slow requests cannot starve cheap ones.
+ */
+enum class HTTPPriority {
+    HIGH,   //!< Cheap reads
+    NORMAL, //!< Wallet and other state changing requests
+    LOW,    //!< Long running scans
+};
+static const int HTTP_PRIORITY_COUNT = 3;
+std::string HTTPPriorityString(HTTPPriority priority);
+
+/** Snapshot of the work queue for diagnostics */
+struct HTTPWorkQueueInfo
+{
+    int threads{0};
+    int idle_threads{0};
+    int min_threads{0};
+    int max_threads{0};
+    struct Lane {
+        size_t queued{0};
+        size_t active{0};
+        size_t max_active{0};
+    } lanes[HTTP_PRIORITY_COUNT];
+};
+/** Fill in the work queue state. Returns false if the HTTP server is not initialized. */
+bool GetHTTPWorkQueueInfo(HTTPWorkQueueInfo& info);
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Picks the work queue lane of a request. Runs on the event thread, so it must be quick. */
+typedef std::function<HTTPPriority(HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Requests are queued with NORMAL priority unless a classifier
+ * is given.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -58,6 +94,12 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    //! State shared with the event thread once a chunked reply has been started
+    std::shared_ptr<HTTPChunkedReply> m_chunked;
+    //! Microseconds the request waited in the work queue
+    int64_t m_queue_time{0};
+
+    friend class HTTPWorkItem;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -97,6 +139,15 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Access the request body without consuming it, e.g. to classify the
+     * request before it is queued. The pointer is valid until ReadBody().
+     */
+    const char* PeekBody(size_t& size);
+
+    /** Microseconds the request waited in the work queue before a worker picked it up */
+    int64_t GetQueueTime() const { return m_queue_time; }
+
     /**
      * Write output header.
      *
@@ -111,8 +162,21 @@ public:
      *
      * @note Can be called only once. As this will give the request back to the
      * main thread, do not call any other HTTPRequest methods after calling this.
+     * If a chunked reply was started with WriteReplyChunk, strReply is sent as
+     * its last chunk and nStatus is ignored.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write part of the HTTP reply body using chunked transfer encoding.
+     * The first call sends nStatus and the headers, later calls ignore nStatus.
+     * Blocks while too much earlier output is still waiting to be sent, so the
+     * memory held for a reply is bounded regardless of its total size.
+     * Returns false if the client went away and further output is pointless.
+     *
+     * @note Finish the reply with WriteReply.
+     */
+    bool WriteReplyChunk(int nStatus, const std::string& chunk);
 };
 
 /** Event handler closure.
@@ -0,0 +1,357 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+
+#include <chainparams.h>
+#include <crypto/sha256.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+/* The index database stores four kinds of records, all keyed by the SHA256 of
+ * the script they belong to, followed by the big-endian height of the block the
+ * record was created in so that the history of a script is read in order:
+ *
+ * - [DB_OUTPUT, script hash, height, txid, vout] -> amount, for each output.
+ * - [DB_SPENT, script hash, height, txid, vout] -> spending txid, vin and height,
+ *   for each spent output. The height is that of the output.
+ * - [DB_SPEND, script hash, height, txid, vin] -> prevout and amount, for each input.
+ * - [DB_UNSPENT, script hash, height, txid, vout] -> amount, for each output
+ *   that is not spent, so unspent outputs are read without the history.
+ *
+ * Spends are kept apart from the outputs they spend, so every record but the
+ * unspent ones is written knowing only the block and its undo data. That
+ * allows blocks to be indexed in any order, which the initial sync uses to
+ * index blocks in parallel. The parallel sync only erases unspent records,
+ * and writes those of its blocks in one pass once they are all indexed.
+ */
+constexpr char DB_OUTPUT = 'o';
+constexpr char DB_SPENT = 'u';
+constexpr char DB_SPEND = 's';
+constexpr char DB_UNSPENT = 'n';
+
+//! Size of the batches written by the pass over all outputs after a parallel sync
+constexpr size_t UNSPENT_BATCH_SIZE = 16 << 20;
+
+std::unique_ptr<AddressIndex> g_address_index;
+
+namespace {
+
+struct DBKey {
+    char prefix;
+    uint256 script_hash;
+    int height;
+    uint256 txid;
+    uint32_t n;
+
+    DBKey() : prefix(0), height(0), n(0) {}
+    DBKey(char prefix_in, const uint256& script_hash_in, int height_in, const uint256& txid_in, uint32_t n_in) :
+        prefix(prefix_in), script_hash(script_hash_in), height(height_in), txid(txid_in), n(n_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, prefix);
+        s << script_hash;
+        ser_writedata32be(s, height);
+        s << txid;
+        ser_writedata32be(s, n);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        prefix = ser_readdata8(s);
+        s >> script_hash;
+        height = ser_readdata32be(s);
+        s >> txid;
+        n = ser_readdata32be(s);
+    }
+
+    //! Order of the records of two outputs, the order of their keys but for the prefix
+    int CompareOutput(const DBKey& other) const
+    {
+        if (int cmp = script_hash.Compare(other.script_hash)) return cmp;
+        if (height != other.height) return height < other.height ? -1 : 1;
+        if (int cmp = txid.Compare(other.txid)) return cmp;
+        if (n != other.n) return n < other.n ? -1 : 1;
+        return 0;
+    }
+};
+
+struct DBSpentValue {
+    COutPoint spent_by;
+    int spent_height;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(spent_by);
+        READWRITE(spent_height);
+    }
+};
+
+struct DBSpendValue {
+    COutPoint prevout;
+    CAmount amount;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(prevout);
+        READWRITE(amount);
+    }
+};
+
+/** Scripts that can never be spent from carry no history worth indexing */
+bool IsIndexed(const CScript& script)
+{
+    return !script.empty() && !script.IsUnspendable();
+}
+
+} // namespace
+
+/**
+ * Access to the address index database (indexes/addressindex/)
+ */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+uint256 AddressIndex::GetScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockUndo& block_undo, const CBlockIndex* pindex)
+{
+    CDBBatch batch(*m_db);
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& tx_undo = block_undo.vtxundo.at(i - 1);
+            for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin = tx_undo.vprevout.at(j);
+                if (!IsIndexed(coin.out.scriptPubKey)) continue;
+                const COutPoint& prevout = tx.vin[j].prevout;
+                const uint256 script_hash = GetScriptHash(coin.out.scriptPubKey);
+                batch.Write(DBKey(DB_SPENT, script_hash, coin.nHeight, prevout.hash, prevout.n),
+                            DBSpentValue{COutPoint(txid, j), pindex->nHeight});
+                batch.Write(DBKey(DB_SPEND, script_hash, pindex->nHeight, txid, j),
+                            DBSpendValue{prevout, coin.out.nValue});
+                batch.Erase(DBKey(DB_UNSPENT, script_hash, coin.nHeight, prevout.hash, prevout.n));
+            }
+        }
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (!IsIndexed(out.scriptPubKey)) continue;
+            const uint256 script_hash = GetScriptHash(out.scriptPubKey);
+            batch.Write(DBKey(DB_OUTPUT, script_hash, pindex->nHeight, txid, j), out.nValue);
+            // Blocks after an interrupted parallel sync may have indexed the
+            // spend already.
+            if (!m_bulk_syncing && !m_db->Exists(DBKey(DB_SPENT, script_hash, pindex->nHeight, txid, j))) {
+                batch.Write(DBKey(DB_UNSPENT, script_hash, pindex->nHeight, txid, j), out.nValue);
+            }
+        }
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::EraseBlock(const CBlock& block, const CBlockUndo& block_undo, const CBlockIndex* pindex)
+{
+    // In reverse order, so that outputs spent within the block are erased
+    // after the spend made them unspent again
+    CDBBatch batch(*m_db);
+    for (size_t i = block.vtx.size(); i-- > 0;) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+        for (uint32_t j = 0; j < tx.vout.size(); ++j) {
+            const CTxOut& out = tx.vout[j];
+            if (!IsIndexed(out.scriptPubKey)) continue;
+            const uint256 script_hash = GetScriptHash(out.scriptPubKey);
+            batch.Erase(DBKey(DB_OUTPUT, script_hash, pindex->nHeight, txid, j));
+            batch.Erase(DBKey(DB_UNSPENT, script_hash, pindex->nHeight, txid, j));
+        }
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& tx_undo = block_undo.vtxundo.at(i - 1);
+            for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+                const Coin& coin = tx_undo.vprevout.at(j);
+                if (!IsIndexed(coin.out.scriptPubKey)) continue;
+                const COutPoint& prevout = tx.vin[j].prevout;
+                const uint256 script_hash = GetScriptHash(coin.out.scriptPubKey);
+                batch.Erase(DBKey(DB_SPENT, script_hash, coin.nHeight, prevout.hash, prevout.n));
+                batch.Erase(DBKey(DB_SPEND, script_hash, pindex->nHeight, txid, j));
+                batch.Write(DBKey(DB_UNSPENT, script_hash, coin.nHeight, prevout.hash, prevout.n), coin.out.nValue);
+            }
+        }
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::WriteUnspentOutputs(const CThreadInterrupt& interrupt)
+{
+    // Both kinds of records are in output order, so the outputs are walked
+    // alongside the spent records instead of looking each of them up.
+    std::unique_ptr<CDBIterator> output_it(m_db->NewIterator());
+    std::unique_ptr<CDBIterator> spent_it(m_db->NewIterator());
+    output_it->Seek(DBKey(DB_OUTPUT, uint256(), 0, uint256(), 0));
+    spent_it->Seek(DBKey(DB_SPENT, uint256(), 0, uint256(), 0));
+    DBKey key;
+    DBKey spent_key;
+    bool have_spent = spent_it->Valid() && spent_it->GetKey(spent_key) && spent_key.prefix == DB_SPENT;
+
+    CDBBatch batch(*m_db);
+    for (; output_it->Valid() && !interrupt; output_it->Next()) {
+        if (!output_it->GetKey(key) || key.prefix != DB_OUTPUT) break;
+        while (have_spent && spent_key.CompareOutput(key) < 0) {
+            spent_it->Next();
+            have_spent = spent_it->Valid() && spent_it->GetKey(spent_key) && spent_key.prefix == DB_SPENT;
+        }
+        if (have_spent && spent_key.CompareOutput(key) == 0) continue;
+        CAmount amount;
+        if (!output_it->GetValue(amount)) {
+            return error("%s: unable to read value in %s at key (%c, %d)", __func__, GetName(), DB_OUTPUT, key.height);
+        }
+        batch.Write(DBKey(DB_UNSPENT, key.script_hash, key.height, key.txid, key.n), amount);
+        if (batch.SizeEstimate() > UNSPENT_BATCH_SIZE) {
+            if (!m_db->WriteBatch(batch)) return false;
+            batch.Clear();
+        }
+    }
+    return m_db->WriteBatch(batch);
+}
+
+void AddressIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    // Rewind right away, so the history of a script does not include a block
+    // that is no longer in the chain.
+    RewindDisconnectedBlock(pindex);
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+    return WriteBlock(block, block_undo, pindex);
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    // The blocks being disconnected are still on disk, read them back to find
+    // the records they created.
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        CBlockUndo block_undo;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params) || !UndoReadFromDisk(block_undo, pindex)) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!EraseBlock(block, block_undo, pindex)) {
+            return false;
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool AddressIndex::BulkSync(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt)
+{
+    const CBlockIndex* const start = pindex;
+    m_bulk_syncing = true;
+    const bool synced = SyncBlocksInParallel(pindex, stop, interrupt);
+    m_bulk_syncing = false;
+    if (!synced || pindex == start) return synced;
+
+    LogPrintf("Writing unspent outputs of %s\n", GetName());
+    if (!WriteUnspentOutputs(interrupt)) return false;
+    // Index the blocks again next time, so the pass is made again too
+    if (interrupt) pindex = start;
+    return true;
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::FindOutputs(const uint256& script_hash, int start_height, int end_height, size_t limit,
+                               std::vector<AddressOutput>& outputs) const
+{
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBKey key;
+    for (db_it->Seek(DBKey(DB_OUTPUT, script_hash, start_height, uint256(), 0)); db_it->Valid() && outputs.size() < limit; db_it->Next()) {
+        if (!db_it->GetKey(key) || key.prefix != DB_OUTPUT || key.script_hash != script_hash || key.height > end_height) {
+            break;
+        }
+        AddressOutput output;
+        output.height = key.height;
+        output.outpoint = COutPoint(key.txid, key.n);
+        if (!db_it->GetValue(output.amount)) {
+            return error("%s: unable to read value in %s at key (%c, %d)", __func__, GetName(), DB_OUTPUT, key.height);
+        }
+        DBSpentValue spent;
+        if (m_db->Read(DBKey(DB_SPENT, script_hash, key.height, key.txid, key.n), spent)) {
+            output.spent_by = spent.spent_by;
+            output.spent_height = spent.spent_height;
+        }
+        outputs.push_back(std::move(output));
+    }
+    return true;
+}
+
+bool AddressIndex::FindUnspentOutputs(const uint256& script_hash, size_t limit, std::vector<AddressOutput>& outputs) const
+{
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBKey key;
+    for (db_it->Seek(DBKey(DB_UNSPENT, script_hash, 0, uint256(), 0)); db_it->Valid() && outputs.size() < limit; db_it->Next()) {
+        if (!db_it->GetKey(key) || key.prefix != DB_UNSPENT || key.script_hash != script_hash) {
+            break;
+        }
+        AddressOutput output;
+        output.height = key.height;
+        output.outpoint = COutPoint(key.txid, key.n);
+        if (!db_it->GetValue(output.amount)) {
+            return error("%s: unable to read value in %s at key (%c, %d)", __func__, GetName(), DB_UNSPENT, key.height);
+        }
+        outputs.push_back(std::move(output));
+    }
+    return true;
+}
+
+bool AddressIndex::FindSpends(const uint256& script_hash, int start_height, int end_height, size_t limit,
+                              std::vector<AddressSpend>& spends) const
+{
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    DBKey key;
+    for (db_it->Seek(DBKey(DB_SPEND, script_hash, start_height, uint256(), 0)); db_it->Valid() && spends.size() < limit; db_it->Next()) {
+        if (!db_it->GetKey(key) || key.prefix != DB_SPEND || key.script_hash != script_hash || key.height > end_height) {
+            break;
+        }
+        DBSpendValue value;
+        if (!db_it->GetValue(value)) {
+            return error("%s: unable to read value in %s at key (%c, %d)", __func__, GetName(), DB_SPEND, key.height);
+        }
+        spends.push_back(AddressSpend{key.height, key.txid, key.n, value.prevout, value.amount});
+    }
+    return true;
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <script/script.h>
+#include <uint256.h>
+
+#include <atomic>
+#include <vector>
+
+class CBlockUndo;
+
+static const bool DEFAULT_ADDRESSINDEX = false;
+
+/** An output paying to an indexed script, and the input spending it if any */
+struct AddressOutput
+{
+    int height;
+    COutPoint outpoint;
+    CAmount amount;
+    //! Spending transaction and input index, null while unspent
+    COutPoint spent_by;
+    int spent_height{-1};
+
+    bool IsSpent() const { return !spent_by.IsNull(); }
+};
+
+/** An input spending from an indexed script */
+struct AddressSpend
+{
+    int height;
+    uint256 txid;
+    uint32_t vin;
+    COutPoint prevout;
+    CAmount amount;
+};
+
+/**
+ * AddressIndex records the transaction history of every script in the active
+ * chain: for each scriptPubKey the outputs paying to it, by which input they
+ * were spent, and the inputs spending from it. Entries are keyed by the SHA256
+ * of the script followed by the block height, so the history of a script can
+ * be read for a range of heights.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    //! Set while blocks are indexed out of order, which leaves the unspent records to WriteUnspentOutputs
+    std::atomic<bool> m_bulk_syncing{false};
+
+    bool WriteBlock(const CBlock& block, const CBlockUndo& block_undo, const CBlockIndex* pindex);
+    bool EraseBlock(const CBlock& block, const CBlockUndo& block_undo, const CBlockIndex* pindex);
+
+    //! Write the unspent records of all outputs without a spent record
+    bool WriteUnspentOutputs(const CThreadInterrupt& interrupt);
+
+protected:
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    bool BulkSync(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Hash under which the history of a script is indexed.
+    static uint256 GetScriptHash(const CScript& script);
+
+    /// Look up the outputs paying to a script that were created at heights
+    /// start_height to end_height, in order of height. Stops after limit results.
+    bool FindOutputs(const uint256& script_hash, int start_height, int end_height, size_t limit,
+                     std::vector<AddressOutput>& outputs) const;
+
+    /// Look up the outputs paying to a script that are not spent in the
+    /// active chain, in order of height. Stops after limit results.
+    bool FindUnspentOutputs(const uint256& script_hash, size_t limit, std::vector<AddressOutput>& outputs) const;
+
+    /// Look up the inputs spending from a script at heights start_height to
+    /// end_height, in order of height. Stops after limit results.
+    bool FindSpends(const uint256& script_hash, int start_height, int end_height, size_t limit,
+                    std::vector<AddressSpend>& spends) const;
+};
+
+/// The global address index. May be null.
+extern std::unique_ptr<AddressIndex> g_address_index;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
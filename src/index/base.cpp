@@ -11,10 +11,21 @@
 #include <validation.h>
 #include <warnings.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 constexpr char DB_BEST_BLOCK = 'B';
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
 constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+//! Blocks closer to the tip than this are left to the block by block sync,
+//! which handles reorganizations
+constexpr int BULK_SYNC_MIN_DEPTH = 100;
+//! Number of blocks each thread indexes at a time in SyncBlocksInParallel
+constexpr int BULK_SYNC_CHUNK_SIZE = 500;
+//! Maximum number of threads of SyncBlocksInParallel
+constexpr int MAX_BULK_SYNC_THREADS = 8;
 
 template<typename... Args>
 static void FatalError(const char* fmt, const Args&... args)
@@ -91,15 +102,42 @@ void BaseIndex::ThreadSync()
     if (!m_synced) {
         auto& consensus_params = Params().GetConsensus();
 
+        const CBlockIndex* bulk_stop = nullptr;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* tip = ::ChainActive().Tip();
+            if (tip && tip->nHeight > BULK_SYNC_MIN_DEPTH && (!pindex || ::ChainActive().Contains(pindex))) {
+                bulk_stop = tip->GetAncestor(tip->nHeight - BULK_SYNC_MIN_DEPTH);
+            }
+        }
+        if (bulk_stop && (!pindex || pindex->nHeight < bulk_stop->nHeight)) {
+            const CBlockIndex* bulk_start = pindex;
+            if (!BulkSync(pindex, bulk_stop, m_interrupt)) {
+                FatalError("%s: Failed to sync index %s up to height %d",
+                           __func__, GetName(), bulk_stop->nHeight);
+                return;
+            }
+            // Indexes without a bulk sync, or one interrupted early, leave
+            // pindex alone. A null best block must not be committed, as its
+            // locator is the chain tip's.
+            if (pindex && pindex != bulk_start) {
+                m_best_block_index = pindex;
+                // No need to handle errors in Commit. See rationale below.
+                Commit();
+            }
+        }
+
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
         while (true) {
             if (m_interrupt) {
-                m_best_block_index = pindex;
-                // No need to handle errors in Commit. If it fails, the error will be already be
-                // logged. The best way to recover is to continue, as index cannot be corrupted by
-                // a missed commit to disk for an advanced index state.
-                Commit();
+                if (pindex) {
+                    m_best_block_index = pindex;
+                    // No need to handle errors in Commit. If it fails, the error will be already be
+                    // logged. The best way to recover is to continue, as index cannot be corrupted by
+                    // a missed commit to disk for an advanced index state.
+                    Commit();
+                }
                 return;
             }
 
@@ -156,6 +194,70 @@ void BaseIndex::ThreadSync()
     }
 }
 
+bool BaseIndex::SyncBlocksInParallel(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt)
+{
+    const int start_height = pindex ? pindex->nHeight + 1 : 0;
+    const int num_chunks = (stop->nHeight - start_height) / BULK_SYNC_CHUNK_SIZE + 1;
+    const int num_threads = std::max(1, std::min({GetNumCores(), MAX_BULK_SYNC_THREADS, num_chunks}));
+    LogPrintf("Syncing %s with block chain from height %d to %d using %d threads\n",
+              GetName(), start_height, stop->nHeight, num_threads);
+
+    std::atomic<int> next_chunk{0};
+    std::atomic<bool> failed{false};
+    //! Written by the thread indexing the chunk, read after all threads are joined
+    std::vector<char> chunk_done(num_chunks, false);
+
+    auto worker = [&]() {
+        const Consensus::Params& consensus_params = Params().GetConsensus();
+        while (!interrupt && !failed) {
+            const int chunk = next_chunk++;
+            if (chunk >= num_chunks) break;
+            const int chunk_start = start_height + chunk * BULK_SYNC_CHUNK_SIZE;
+            const int chunk_end = std::min(chunk_start + BULK_SYNC_CHUNK_SIZE - 1, stop->nHeight);
+
+            std::vector<const CBlockIndex*> chunk_blocks(chunk_end - chunk_start + 1);
+            const CBlockIndex* walk = stop->GetAncestor(chunk_end);
+            for (auto it = chunk_blocks.rbegin(); it != chunk_blocks.rend(); ++it) {
+                *it = walk;
+                walk = walk->pprev;
+            }
+            bool complete = true;
+            for (const CBlockIndex* block_index : chunk_blocks) {
+                if (interrupt) {
+                    complete = false;
+                    break;
+                }
+                CBlock block;
+                if (!ReadBlockFromDisk(block, block_index, consensus_params) || !WriteBlock(block, block_index)) {
+                    LogPrintf("%s: Failed to index block %s\n", __func__, block_index->GetBlockHash().ToString());
+                    failed = true;
+                    return;
+                }
+            }
+            chunk_done[chunk] = complete;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (failed) return false;
+
+    // Blocks of chunks after the first incomplete one get indexed again by the
+    // next sync, which rewrites the same records.
+    int done = 0;
+    while (done < num_chunks && chunk_done[done]) ++done;
+    if (done > 0) {
+        pindex = stop->GetAncestor(std::min(start_height + done * BULK_SYNC_CHUNK_SIZE - 1, stop->nHeight));
+    }
+    return true;
+}
+
 bool BaseIndex::Commit()
 {
     CDBBatch batch(GetDB());
@@ -230,6 +332,19 @@ void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const
     }
 }
 
+void BaseIndex::RewindDisconnectedBlock(const CBlockIndex* pindex)
+{
+    if (!m_synced) {
+        return;
+    }
+
+    const CBlockIndex* best_block_index = m_best_block_index.load();
+    if (best_block_index == pindex && !Rewind(pindex, pindex->pprev)) {
+        FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                   __func__, GetName());
+    }
+}
+
 void BaseIndex::ChainStateFlushed(const CBlockLocator& locator)
 {
     if (!m_synced) {
@@ -82,6 +82,22 @@ protected:
     /// be an ancestor of the current best block.
     virtual bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip);
 
+    /// Index the blocks of the active chain after pindex up to stop in one go,
+    /// for indexes whose entries do not depend on the previous block's. Called
+    /// by the sync thread before it catches up block by block. On return pindex
+    /// must be the last block up to which all blocks are indexed. The default
+    /// indexes nothing.
+    virtual bool BulkSync(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt) { return true; }
+
+    /// BulkSync implementation for indexes whose WriteBlock only depends on the
+    /// block and may run concurrently: writes chunks of blocks on several threads.
+    bool SyncBlocksInParallel(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt);
+
+    /// BlockDisconnected implementation for indexes that must not serve data of
+    /// a disconnected block until the next block is connected: rewinds the
+    /// index right away if pindex is its best block.
+    void RewindDisconnectedBlock(const CBlockIndex* pindex);
+
     virtual DB& GetDB() const = 0;
 
     /// Get the name of the index for display in logs.
@@ -0,0 +1,240 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+
+#include <arith_uint256.h>
+#include <consensus/consensus.h>
+#include <consensus/validation.h>
+#include <undo.h>
+#include <util/check.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <algorithm>
+
+/* The index database stores the statistics of each block under its height, as
+ * [DB_BLOCK_HEIGHT, uint32 (BE)] -> (block hash, BlockStats). The height is
+ * big-endian so that ranges of blocks are read sequentially.
+ *
+ * Entries of blocks that were disconnected are left in place until a block at
+ * the same height is connected and are recognized by their block hash. Entries
+ * only depend on the block and its undo data, so blocks are indexed in
+ * parallel during the initial sync.
+ */
+constexpr char DB_BLOCK_HEIGHT = 't';
+
+std::unique_ptr<BlockStatsIndex> g_block_stats_index;
+
+// outpoint (needed for the utxo index) + nHeight + fCoinBase
+static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+
+namespace {
+
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BLOCK_HEIGHT);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_BLOCK_HEIGHT) {
+            throw std::ios_base::failure("Invalid format for block stats index DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+template<typename T>
+T CalculateTruncatedMedian(std::vector<T>& scores)
+{
+    size_t size = scores.size();
+    if (size == 0) {
+        return 0;
+    }
+
+    std::sort(scores.begin(), scores.end());
+    if (size % 2 == 0) {
+        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
+    } else {
+        return scores[size / 2];
+    }
+}
+
+} // namespace
+
+BlockStats ComputeBlockStats(const CBlock& block, const CBlockUndo& block_undo)
+{
+    BlockStats stats;
+    CAmount minfee = MAX_MONEY;
+    CAmount minfeerate = MAX_MONEY;
+    int64_t mintxsize = MAX_BLOCK_SERIALIZED_SIZE;
+    std::vector<CAmount> fee_array;
+    std::vector<int64_t> txsize_array;
+
+    stats.txs = block.vtx.size();
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        stats.outs += tx.vout.size();
+
+        CAmount tx_total_out = 0;
+        for (const CTxOut& out : tx.vout) {
+            tx_total_out += out.nValue;
+            stats.utxo_size_inc += GetSerializeSize(out, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+        }
+
+        if (tx.IsCoinBase()) {
+            continue;
+        }
+
+        stats.ins += tx.vin.size(); // Don't count coinbase's fake input
+        stats.total_out += tx_total_out; // Don't count coinbase reward
+
+        const int64_t tx_size = tx.GetTotalSize();
+        txsize_array.push_back(tx_size);
+        stats.maxtxsize = std::max(stats.maxtxsize, tx_size);
+        mintxsize = std::min(mintxsize, tx_size);
+        stats.total_size += tx_size;
+
+        const int64_t weight = GetTransactionWeight(tx);
+        stats.total_weight += weight;
+
+        CAmount tx_total_in = 0;
+        arith_uint256 coin_age = 0;
+        const CTxUndo& tx_undo = block_undo.vtxundo.at(i - 1);
+        for (const Coin& coin : tx_undo.vprevout) {
+            const CTxOut& prevoutput = coin.out;
+
+            tx_total_in += prevoutput.nValue;
+            stats.utxo_size_inc -= GetSerializeSize(prevoutput, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
+            if (tx.IsCoinStake() && tx.nTime > coin.nTime) {
+                coin_age += arith_uint256(prevoutput.nValue) * (tx.nTime - coin.nTime);
+            }
+        }
+
+        if (tx.IsCoinStake()) {
+            stats.stake_reward = tx_total_out - tx_total_in;
+            stats.coin_age = (coin_age / COIN / (24 * 60 * 60)).GetLow64();
+            continue;
+        }
+
+        const CAmount txfee = tx_total_in - tx_total_out;
+        CHECK_NONFATAL(MoneyRange(txfee));
+        fee_array.push_back(txfee);
+        stats.maxfee = std::max(stats.maxfee, txfee);
+        minfee = std::min(minfee, txfee);
+        stats.totalfee += txfee;
+        ++stats.fee_txs;
+
+        // New feerate uses satoshis per virtual byte instead of per serialized byte
+        const CAmount feerate = weight ? (txfee * WITNESS_SCALE_FACTOR) / weight : 0;
+        stats.maxfeerate = std::max(stats.maxfeerate, feerate);
+        minfeerate = std::min(minfeerate, feerate);
+    }
+
+    stats.minfee = minfee == MAX_MONEY ? 0 : minfee;
+    stats.minfeerate = minfeerate == MAX_MONEY ? 0 : minfeerate;
+    stats.mintxsize = mintxsize == MAX_BLOCK_SERIALIZED_SIZE ? 0 : mintxsize;
+    stats.medianfee = CalculateTruncatedMedian(fee_array);
+    stats.mediantxsize = CalculateTruncatedMedian(txsize_array);
+    return stats;
+}
+
+/**
+ * Access to the block stats index database (indexes/blockstats/)
+ */
+class BlockStatsIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+BlockStatsIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "blockstats", n_cache_size, f_memory, f_wipe)
+{}
+
+BlockStatsIndex::BlockStatsIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BlockStatsIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+BlockStatsIndex::~BlockStatsIndex() {}
+
+bool BlockStatsIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+    BlockStats stats;
+    try {
+        stats = ComputeBlockStats(block, block_undo);
+    } catch (const NonFatalCheckError& e) {
+        return error("%s: unable to compute stats of block %s: %s", __func__, pindex->GetBlockHash().ToString(), e.what());
+    }
+    return m_db->Write(DBHeightKey(pindex->nHeight), std::make_pair(pindex->GetBlockHash(), stats));
+}
+
+bool BlockStatsIndex::BulkSync(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt)
+{
+    return SyncBlocksInParallel(pindex, stop, interrupt);
+}
+
+BaseIndex::DB& BlockStatsIndex::GetDB() const { return *m_db; }
+
+bool BlockStatsIndex::LookupStats(const CBlockIndex* block_index, BlockStats& stats) const
+{
+    std::pair<uint256, BlockStats> value;
+    if (!m_db->Read(DBHeightKey(block_index->nHeight), value) || value.first != block_index->GetBlockHash()) {
+        return false;
+    }
+    stats = std::move(value.second);
+    return true;
+}
+
+bool BlockStatsIndex::LookupStatsRange(int start_height, const CBlockIndex* stop_index, std::vector<BlockStats>& stats) const
+{
+    if (start_height < 0 || start_height > stop_index->nHeight) {
+        return error("%s: invalid range %d to %d", __func__, start_height, stop_index->nHeight);
+    }
+
+    stats.resize(stop_index->nHeight - start_height + 1);
+    std::vector<uint256> hashes(stats.size());
+
+    DBHeightKey key;
+    std::pair<uint256, BlockStats> value;
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+    db_it->Seek(DBHeightKey(start_height));
+    for (int height = start_height; height <= stop_index->nHeight; ++height) {
+        if (!db_it->Valid() || !db_it->GetKey(key) || key.height != height) {
+            return false;
+        }
+        if (!db_it->GetValue(value)) {
+            return error("%s: unable to read value in %s at key (%c, %d)", __func__, GetName(), DB_BLOCK_HEIGHT, height);
+        }
+        const size_t i = height - start_height;
+        hashes[i] = value.first;
+        stats[i] = std::move(value.second);
+        db_it->Next();
+    }
+
+    // Entries of disconnected blocks may not have been overwritten yet
+    for (const CBlockIndex* block_index = stop_index;
+         block_index && block_index->nHeight >= start_height;
+         block_index = block_index->pprev) {
+        if (hashes[block_index->nHeight - start_height] != block_index->GetBlockHash()) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BLOCKSTATSINDEX_H
+#define BITCOIN_INDEX_BLOCKSTATSINDEX_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <serialize.h>
+
+#include <vector>
+
+class CBlockUndo;
+
+static const bool DEFAULT_BLOCKSTATSINDEX = false;
+
+/**
+ * Statistics of a block that need its transactions and undo data to compute.
+ * Fees, sizes and weights leave out the coinbase, fees also leave out the
+ * coinstake, whose outputs carry the stake reward instead.
+ */
+struct BlockStats
+{
+    int64_t txs{0};
+    int64_t ins{0};
+    int64_t outs{0};
+    CAmount total_out{0};
+    CAmount totalfee{0};
+    CAmount minfee{0};
+    CAmount maxfee{0};
+    CAmount medianfee{0};
+    CAmount minfeerate{0};
+    CAmount maxfeerate{0};
+    int64_t total_size{0};
+    int64_t mintxsize{0};
+    int64_t maxtxsize{0};
+    int64_t mediantxsize{0};
+    int64_t total_weight{0};
+    int64_t utxo_size_inc{0};
+    //! Number of transactions paying a fee (all but the coinbase and coinstake)
+    int64_t fee_txs{0};
+    //! Value created by the coinstake: its outputs minus its inputs
+    CAmount stake_reward{0};
+    //! Coin age consumed by the coinstake, in coin-days
+    uint64_t coin_age{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(VARINT_MODE(txs, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(ins, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(outs, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(total_out, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(totalfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(minfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(maxfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(medianfee, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(minfeerate, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(maxfeerate, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(total_size, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(mintxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(maxtxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(mediantxsize, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(total_weight, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(utxo_size_inc);
+        READWRITE(VARINT_MODE(fee_txs, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT_MODE(stake_reward, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(VARINT(coin_age));
+    }
+};
+
+/** Compute the statistics of a block from the block and its undo data.
+ * Throws NonFatalCheckError if the undo data gives a fee out of range. */
+BlockStats ComputeBlockStats(const CBlock& block, const CBlockUndo& block_undo);
+
+/**
+ * BlockStatsIndex keeps the BlockStats of every block in the active chain,
+ * computed once when the block is connected, so statistics over ranges of
+ * blocks are served without reading blocks and undo data from disk.
+ */
+class BlockStatsIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool BulkSync(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "blockstatsindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit BlockStatsIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~BlockStatsIndex() override;
+
+    /// Look up the statistics of a block in the active chain. Returns false if
+    /// the block is not indexed.
+    bool LookupStats(const CBlockIndex* block_index, BlockStats& stats) const;
+
+    /// Look up the statistics of the blocks from start_height to stop_index,
+    /// which must be in the active chain. Returns false if any of them is not
+    /// indexed.
+    bool LookupStatsRange(int start_height, const CBlockIndex* stop_index, std::vector<BlockStats>& stats) const;
+};
+
+/// The global block statistics index. May be null.
+extern std::unique_ptr<BlockStatsIndex> g_block_stats_index;
+
+#endif // BITCOIN_INDEX_BLOCKSTATSINDEX_H
@@ -0,0 +1,149 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/spentindex.h>
+
+#include <chainparams.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+/* The index database stores one record per spent output:
+ *
+ * [DB_SPENT, txid, vout] -> spending txid, vin, height and the spent Coin.
+ *
+ * The Coin is kept in the compressed form of the UTXO set, so a record costs
+ * about as much as the output did in the chainstate. Records only depend on
+ * the block and its undo data, so blocks are indexed in parallel during the
+ * initial sync.
+ */
+constexpr char DB_SPENT = 's';
+
+std::unique_ptr<SpentIndex> g_spent_index;
+
+namespace {
+
+struct DBVal {
+    COutPoint spent_by;
+    int height;
+    Coin prevout;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(spent_by);
+        READWRITE(VARINT_MODE(height, VarIntMode::NONNEGATIVE_SIGNED));
+        READWRITE(prevout);
+    }
+};
+
+} // namespace
+
+/**
+ * Access to the spent index database (indexes/spentindex/)
+ */
+class SpentIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+};
+
+SpentIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "spentindex", n_cache_size, f_memory, f_wipe)
+{}
+
+SpentIndex::SpentIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<SpentIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+SpentIndex::~SpentIndex() {}
+
+void SpentIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    // Rewind right away, so no output is reported spent by a transaction that
+    // is no longer in the chain.
+    RewindDisconnectedBlock(pindex);
+}
+
+bool SpentIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block spends nothing.
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+
+    CDBBatch batch(*m_db);
+    for (size_t i = 1; i < block.vtx.size(); ++i) {
+        const CTransaction& tx = *block.vtx[i];
+        const CTxUndo& tx_undo = block_undo.vtxundo.at(i - 1);
+        for (uint32_t j = 0; j < tx.vin.size(); ++j) {
+            batch.Write(std::make_pair(DB_SPENT, tx.vin[j].prevout),
+                        DBVal{COutPoint(tx.GetHash(), j), pindex->nHeight, tx_undo.vprevout.at(j)});
+        }
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool SpentIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        for (size_t i = 1; i < block.vtx.size(); ++i) {
+            for (const CTxIn& txin : block.vtx[i]->vin) {
+                batch.Erase(std::make_pair(DB_SPENT, txin.prevout));
+            }
+        }
+    }
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool SpentIndex::BulkSync(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt)
+{
+    return SyncBlocksInParallel(pindex, stop, interrupt);
+}
+
+BaseIndex::DB& SpentIndex::GetDB() const { return *m_db; }
+
+bool SpentIndex::FindSpent(const COutPoint& outpoint, SpentIndexEntry& entry) const
+{
+    DBVal value;
+    if (!m_db->Read(std::make_pair(DB_SPENT, outpoint), value)) {
+        return false;
+    }
+    entry.spent_by = value.spent_by;
+    entry.height = value.height;
+    entry.prevout = std::move(value.prevout);
+    return true;
+}
+
+bool SpentIndex::FindPrevouts(const CTransaction& tx, CTxUndo& tx_undo) const
+{
+    if (tx.IsCoinBase()) return false;
+
+    tx_undo.vprevout.clear();
+    tx_undo.vprevout.reserve(tx.vin.size());
+    DBVal value;
+    for (const CTxIn& txin : tx.vin) {
+        // If tx is not in the active chain, its prevouts may be spent by
+        // another transaction
+        if (!m_db->Read(std::make_pair(DB_SPENT, txin.prevout), value) || value.spent_by.hash != tx.GetHash()) {
+            return false;
+        }
+        tx_undo.vprevout.push_back(std::move(value.prevout));
+    }
+    return true;
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_SPENTINDEX_H
+#define BITCOIN_INDEX_SPENTINDEX_H
+
+#include <coins.h>
+#include <index/base.h>
+
+class CTxUndo;
+
+static const bool DEFAULT_SPENTINDEX = false;
+
+/** The input spending an output, and the output it spent */
+struct SpentIndexEntry
+{
+    //! Spending transaction and input index
+    COutPoint spent_by;
+    //! Height of the block containing the spending transaction
+    int height{0};
+    //! The spent output as it was in the UTXO set
+    Coin prevout;
+};
+
+/**
+ * SpentIndex records, for every output spent in the active chain, which input
+ * spent it at what height, together with the output's value and script. The
+ * records are taken from the block undo data when blocks are connected, so
+ * input values and fees of historical transactions can be looked up without
+ * reading previous transactions or undo files.
+ */
+class SpentIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    bool BulkSync(const CBlockIndex*& pindex, const CBlockIndex* stop, const CThreadInterrupt& interrupt) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "spentindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit SpentIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~SpentIndex() override;
+
+    /// Look up the input spending an outpoint. Returns false if the outpoint is
+    /// unspent or unknown.
+    bool FindSpent(const COutPoint& outpoint, SpentIndexEntry& entry) const;
+
+    /// Look up the outputs spent by all inputs of a confirmed transaction, in
+    /// the form of its undo data. Returns false if any of them is not indexed.
+    bool FindPrevouts(const CTransaction& tx, CTxUndo& tx_undo) const;
+};
+
+/// The global spent index. May be null.
+extern std::unique_ptr<SpentIndex> g_spent_index;
+
+#endif // BITCOIN_INDEX_SPENTINDEX_H
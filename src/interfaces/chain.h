@@ -5,6 +5,7 @@
 #ifndef BITCOIN_INTERFACES_CHAIN_H
 #define BITCOIN_INTERFACES_CHAIN_H
 
+#include <blockfilter.h>           // For GCSFilter::ElementSet
 #include <optional.h>               // For Optional and nullopt
 #include <primitives/transaction.h> // For CTransactionRef
 
@@ -131,6 +132,11 @@ public:
         int64_t* time = nullptr,
         int64_t* max_time = nullptr) = 0;
 
+    //! Return whether the BIP 158 basic filter of a block matches any of the
+    //! elements, or nothing if the block filter index is not enabled or has
+    //! not indexed the block.
+    virtual Optional<bool> blockFilterMatchesAny(const uint256& block_hash, const GCSFilter::ElementSet& filter_set) = 0;
+
     //! Look up unspent output information. Returns coins in the mempool and in
     //! the current chain UTXO set. Iterates through all the keys in the map and
     //! populates the values.
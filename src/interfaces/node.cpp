@@ -9,6 +9,7 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <init.h>
+#include <miner.h>
 #include <interfaces/chain.h>
 #include <interfaces/handler.h>
 #include <interfaces/wallet.h>
@@ -169,6 +170,21 @@ public:
     int64_t getTotalBytesSent() override { return m_context.connman ? m_context.connman->GetTotalBytesSent() : 0; }
     size_t getMempoolSize() override { return m_context.mempool ? m_context.mempool->size() : 0; }
     size_t getMempoolDynamicUsage() override { return m_context.mempool ? m_context.mempool->DynamicMemoryUsage() : 0; }
+    MiningStats getMiningStats() override
+    {
+        MiningStats stats;
+        stats.mining = IsMining();
+        stats.staking = IsStaking();
+        stats.hashes_per_min = g_mining_metrics.hashes_per_min;
+        stats.kernel_hashes = g_mining_metrics.kernel_hashes;
+        stats.search_interval = g_mining_metrics.search_interval;
+        stats.last_search_time = g_mining_metrics.last_search_time;
+        stats.modifier_time = g_mining_metrics.modifier_time;
+        stats.stake_weight = g_mining_metrics.stake_weight;
+        stats.network_stake_weight = g_mining_metrics.network_stake_weight;
+        stats.stake_target_spacing = Params().GetConsensus().nStakeTargetSpacing;
+        return stats;
+    }
     bool getHeaderTip(int& height, int64_t& block_time) override
     {
         LOCK(::cs_main);
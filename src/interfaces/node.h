@@ -34,6 +34,7 @@ enum class WalletCreationStatus;
 namespace interfaces {
 class Handler;
 class Wallet;
+struct MiningStats;
 
 //! Top-level interface for a bitcoin node (bitcoind process).
 class Node
@@ -141,6 +142,9 @@ public:
     //! Get mempool dynamic usage.
     virtual size_t getMempoolDynamicUsage() = 0;
 
+    //! Get mining and staking activity, without taking any lock.
+    virtual MiningStats getMiningStats() = 0;
+
     //! Get header tip height and time.
     virtual bool getHeaderTip(int& height, int64_t& block_time) = 0;
 
@@ -257,6 +261,26 @@ public:
     virtual NodeContext* context() { return nullptr; }
 };
 
+//! Mining and staking activity of the node.
+struct MiningStats
+{
+    bool mining = false;
+    bool staking = false;
+    //! Proof-of-work hashrate, in hashes per minute
+    double hashes_per_min = 0;
+    //! Stake kernels hashed since startup
+    uint64_t kernel_hashes = 0;
+    int64_t search_interval = 0;
+    int64_t last_search_time = 0;
+    //! Block time of the block that generated the current stake modifier
+    int64_t modifier_time = 0;
+    //! Stake weights of the staking wallets and of the network, in coin-days
+    uint64_t stake_weight = 0;
+    double network_stake_weight = 0;
+    //! Target seconds between proof-of-stake blocks
+    int64_t stake_target_spacing = 0;
+};
+
 //! Return implementation of Node interface.
 std::unique_ptr<Node> MakeNode();
 
@@ -155,8 +155,10 @@ public:
     //! Get transaction information.
     virtual WalletTx getWalletTx(const uint256& txid) = 0;
 
-    //! Get list of all wallet transactions.
-    virtual std::vector<WalletTx> getWalletTxs() = 0;
+    //! Get up to count wallet transactions positioned before order_pos in the
+    //! wallet (nOrderPos), newest first. Pass the order_pos of the last
+    //! transaction returned to get the next ones.
+    virtual std::vector<WalletTx> getWalletTxsBefore(int64_t order_pos, size_t count) = 0;
 
     //! Try to get updated status for a particular transaction, if possible without blocking.
     virtual bool tryGetTxStatus(const uint256& txid,
@@ -181,7 +183,7 @@ public:
     //! Get balances.
     virtual WalletBalances getBalances() = 0;
 
-    //! Get balances if possible without waiting for chain and wallet locks.
+    //! Get balances if possible without waiting for the wallet lock.
     virtual bool tryGetBalances(WalletBalances& balances,
         int& num_blocks,
         bool force,
@@ -333,6 +335,7 @@ struct WalletTx
     std::map<std::string, std::string> value_map;
     bool is_coinbase;
     bool is_coinstake;
+    int64_t order_pos;
 };
 
 //! Updated transaction status.
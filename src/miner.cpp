@@ -14,6 +14,7 @@
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <crypto/scrypt.h>
+#include <index/txindex.h>
 #include <net.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
@@ -34,7 +35,7 @@
 
 #include "openssl/sha.h"
 
-int64_t nLastCoinStakeSearchInterval = 0;
+MiningMetrics g_mining_metrics;
 int64_t UpdateTime(CBlockHeader* pblock)
 {
     int64_t nOldTime = pblock->nTime;
@@ -124,10 +125,14 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
         pblock->nBits = GetNextWorkRequired(pindexPrev, chainparams.GetConsensus());
 
     // if coinstake available add coinstake tx
-    static int64_t nLastCoinStakeSearchTime = GetAdjustedTime();  // only initialized at startup
-
     if (pwallet && fPos)  // attemp to find a coinstake
     {
+        AssertLockHeld(pwallet->cs_wallet);
+        // Each wallet is searched from where its previous search ended
+        int64_t& nLastCoinStakeSearchTime = pwallet->m_last_coin_stake_search_time;
+        if (nLastCoinStakeSearchTime == 0)
+            nLastCoinStakeSearchTime = GetAdjustedTime();
+
         *pfPoSCancel = true;
         CMutableTransaction txCoinStake;
         int64_t nSearchTime = txCoinStake.nTime; // search to current time
@@ -144,7 +149,8 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
                     *pfPoSCancel = false;
                 }
             }
-            nLastCoinStakeSearchInterval = nSearchTime - nLastCoinStakeSearchTime;
+            g_mining_metrics.search_interval = nSearchTime - nLastCoinStakeSearchTime;
+            g_mining_metrics.last_search_time = nSearchTime;
             nLastCoinStakeSearchTime = nSearchTime;
         }
         if (*pfPoSCancel)
@@ -482,7 +488,6 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
 //////////////////////////////////////////////////////////////////////////////
 ////////////////////// Verium/Vericoin Miner ////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////
-double hashrate = 0.;
 bool fGenerateVerium = false;
 bool fGenerateVericoin = false;
 static int64_t timeElapsed = 30000;
@@ -597,7 +602,7 @@ bool CheckWork(CBlock* pblock)
 
 void updateHashrate(double nHashrate)
 {
-    hashrate = nHashrate;
+    g_mining_metrics.hashes_per_min = nHashrate;
 }
 
 void Miner(std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* mempool)
@@ -710,7 +715,7 @@ void Miner(std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* memp
                             nHPSTimerStart = GetTimeMillis();
                             nHashCounter = 0;
                             updateHashrate(dHashesPerMin);
-                            LogPrintf("Total local hashrate: %6.0f hashes/min\n", hashrate);
+                            LogPrintf("Total local hashrate: %6.0f hashes/min\n", dHashesPerMin);
                         }
                     }
                 }
@@ -740,7 +745,7 @@ void Miner(std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* memp
     catch (boost::thread_interrupted)
     {
         free(scratchbuf);
-        hashrate = 0;
+        updateHashrate(0);
         LogPrintf("Miner terminated\n");
         fGenerateVerium = false;
         throw;
@@ -798,24 +803,100 @@ static bool ProcessBlockFound(const CBlock* pblock, const CChainParams& chainpar
     return true;
 }
 
-void Staker(std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* mempool)
+/** Search the coins of one wallet for a kernel and, if one is found, sign
+ * and process the block. Returns whether a block was found. */
+static bool StakeWithWallet(const std::shared_ptr<CWallet>& pwallet, unsigned int& nExtraNonce, CTxMemPool* mempool)
 {
-    SetThreadPriority(THREAD_PRIORITY_LOWEST);
-    util::ThreadRename("vericoin-staking");
+    bool fPoSCancel = false;
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
 
-    // Each thread has it's own nonce
-    OutputType output_type = pwallet->m_default_change_type != OutputType::CHANGE_AUTO ? pwallet->m_default_change_type : pwallet->m_default_address_type;
-    ReserveDestination reservedest(pwallet.get(), output_type);
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
 
-    CTxDestination dest;
-    bool ret = reservedest.GetReservedDestination(dest, true);
-    if (!ret)
+        // The coinbase of a proof-of-stake block pays nothing, so no
+        // destination of the wallet is needed for it
+        pblocktemplate = BlockAssembler(*mempool, Params()).CreateNewBlock(CScript(), true, pwallet.get(), &fPoSCancel);
+    }
+    ++pwallet->m_stake_searches;
+
+    if (!pblocktemplate.get())
     {
-        fGenerateVericoin = false;
+        if (!fPoSCancel)
+            LogPrintf("Staking: failed to create block for wallet %s\n", pwallet->GetName());
+        return false;
+    }
+
+    CBlock *pblock = &pblocktemplate->block;
+
+    // ppcoin: if proof-of-stake block found then process block
+    if (!pblock->IsProofOfStake())
+        return false;
+
+    // The tip may have moved since the round started, the coinbase must
+    // commit to the height of the block the template builds on
+    const CBlockIndex* pindexPrev = WITH_LOCK(cs_main, return LookupBlockIndex(pblock->hashPrevBlock));
+    if (!pindexPrev)
+        return false;
+    IncrementExtraNonce(pblock, pindexPrev, nExtraNonce);
+
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        if (!SignBlock(*pblock, *pwallet))
+        {
+            LogPrintf("Staking(): failed to sign PoS block\n");
+            return false;
+        }
+    }
+    LogPrintf("Staking : proof-of-stake block found %s by wallet %s\n", pblock->GetHash().ToString(), pwallet->GetName());
+
+    if (!ProcessBlockFound(pblock, Params()))
+        return false;
+    ++pwallet->m_stakes_found;
+    return true;
+}
+
+/** Seconds between refreshes of the stake weight of the staking wallets */
+static const int64_t STAKE_WEIGHT_METRICS_INTERVAL = 10 * 60;
+
+/** Publish the staking metrics that depend on the tip and on the staking wallets */
+static void UpdateStakingMetrics(CBlockIndex* pindexPrev, int64_t& nLastWeightTime)
+{
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = pindexPrev;
+        while (pindex->pprev && !pindex->GeneratedStakeModifier())
+            pindex = pindex->pprev;
+        g_mining_metrics.modifier_time = pindex->GetBlockTime();
+        if (pindexPrev->pprev)
+            g_mining_metrics.network_stake_weight = GetAverageStakeWeight(pindexPrev->pprev);
+    }
+
+    // Coin-day weights grow slowly while computing them reads every staked
+    // coin from the transaction index, so they are refreshed less often
+    if (!g_txindex || GetTime() - nLastWeightTime < STAKE_WEIGHT_METRICS_INTERVAL)
         return;
+    nLastWeightTime = GetTime();
+
+    uint64_t nWeight = 0;
+    for (const std::shared_ptr<CWallet>& pwallet : GetWallets())
+    {
+        if (!pwallet->m_staking_enabled || pwallet->IsLocked())
+            continue;
+        uint64_t nWalletWeight = 0;
+        LOCK2(cs_main, pwallet->cs_wallet);
+        if (pwallet->GetStakeWeight(nWalletWeight))
+            nWeight += nWalletWeight;
     }
+    g_mining_metrics.stake_weight = nWeight;
+}
+
+void Staker(CConnman* connman, CTxMemPool* mempool)
+{
+    SetThreadPriority(THREAD_PRIORITY_LOWEST);
+    util::ThreadRename("vericoin-staking");
 
     unsigned int nExtraNonce = 0;
+    int64_t nLastWeightTime = 0;
     try
     {
         while (fGenerateVericoin)
@@ -827,59 +908,28 @@ void Staker(std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* mem
                 if (!fGenerateVericoin)
                     return;
             }
-            while (pwallet->IsLocked()) {
-                LogPrintf("Staking inactive because wallet is lock...\n");
-                UninterruptibleSleep(std::chrono::milliseconds{5000});
-                if (!fGenerateVericoin)
-                    return;
-            }
 
-            CBlockIndex* pindexPrev = ::ChainActive().Tip();
-            bool fPoSCancel = false;
-            CScript scriptPubKey = GetScriptForDestination(dest);
-            std::unique_ptr<CBlockTemplate> pblocktemplate;
-
-            {
-                LOCK2(cs_main, pwallet->cs_wallet);
-
-                pblocktemplate = BlockAssembler(*mempool, Params()).CreateNewBlock(scriptPubKey, true, pwallet.get(), &fPoSCancel);
-            }
-
-            if (!pblocktemplate.get())
+            // Search the coins of every loaded wallet, the first one finding
+            // a kernel signs the block
+            CBlockIndex* pindexPrev = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+            bool fBlockFound = false;
+            for (const std::shared_ptr<CWallet>& pwallet : GetWallets())
             {
-                if (fPoSCancel == true)
-                {
-                    UninterruptibleSleep(std::chrono::milliseconds{25000});
+                if (!fGenerateVericoin)
+                    return;
+                if (!pwallet->m_staking_enabled || pwallet->IsLocked())
                     continue;
-                }
-
-                LogPrintf("Staking: Keypool ran out, please call keypoolrefill before restarting the staking thread\n");
-                fGenerateVericoin = false;
-		        return;
-            }
-
-            CBlock *pblock = &pblocktemplate->block;
-            IncrementExtraNonce(pblock, pindexPrev, nExtraNonce);
-
-            // ppcoin: if proof-of-stake block found then process block
-            if (pblock->IsProofOfStake())
-            {
+                if (StakeWithWallet(pwallet, nExtraNonce, mempool))
                 {
-                    LOCK2(cs_main, pwallet->cs_wallet);
-                    if (!SignBlock(*pblock, *pwallet))
-                    {
-                        LogPrintf("Staking(): failed to sign PoS block\n");
-                        continue;
-                    }
+                    fBlockFound = true;
+                    break;
                 }
-                LogPrintf("Staking : proof-of-stake block found %s\n", pblock->GetHash().ToString());
-
-                ProcessBlockFound(pblock, Params());
-                reservedest.KeepDestination();
+            }
+            UpdateStakingMetrics(pindexPrev, nLastWeightTime);
 
-                // Rest for ~3 minutes after successful block to preserve close quick
+            // Rest for ~3 minutes after successful block to preserve close quick
+            if (fBlockFound)
                 UninterruptibleSleep(std::chrono::seconds(60 + GetRand(4)));
-            }
 
             UninterruptibleSleep(std::chrono::milliseconds{25000});
         }
@@ -901,10 +951,10 @@ void Staker(std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* mem
 
 bool IsStaking()
 {
-    return fGenerateVerium;
+    return fGenerateVericoin;
 }
 
-void GenerateVericoin(bool fGenerate, std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* mempool)
+void GenerateVericoin(bool fGenerate, CConnman* connman, CTxMemPool* mempool)
 {
     fGenerateVericoin = fGenerate;
     static boost::thread_group* stakerThreads = NULL;
@@ -920,5 +970,5 @@ void GenerateVericoin(bool fGenerate, std::shared_ptr<CWallet> pwallet, CConnman
         return;
 
     stakerThreads = new boost::thread_group();
-    stakerThreads->create_thread(std::bind(&Staker, pwallet, connman, mempool));
+    stakerThreads->create_thread(std::bind(&Staker, connman, mempool));
 }
@@ -11,6 +11,7 @@
 #include <txmempool.h>
 #include <validation.h>
 
+#include <atomic>
 #include <memory>
 #include <stdint.h>
 
@@ -22,7 +23,29 @@ class CChainParams;
 class CScript;
 class CWallet;
 
-extern int64_t nLastCoinStakeSearchInterval;
+/**
+ * Activity of the miner and staker threads. They publish it through atomics,
+ * so readers such as the GUI poll it often without contending for any lock.
+ */
+struct MiningMetrics
+{
+    //! Local proof-of-work hashrate, in hashes per minute
+    std::atomic<double> hashes_per_min{0};
+    //! Number of stake kernels hashed since startup
+    std::atomic<uint64_t> kernel_hashes{0};
+    //! Seconds covered by the last coinstake search
+    std::atomic<int64_t> search_interval{0};
+    //! Time of the last coinstake search
+    std::atomic<int64_t> last_search_time{0};
+    //! Block time of the block that generated the current stake modifier
+    std::atomic<int64_t> modifier_time{0};
+    //! Combined stake weight of the staking wallets, in coin-days
+    std::atomic<uint64_t> stake_weight{0};
+    //! Average stake weight of the network, in coin-days
+    std::atomic<double> network_stake_weight{0};
+};
+
+extern MiningMetrics g_mining_metrics;
 
 namespace Consensus { struct Params; };
 
@@ -208,12 +231,11 @@ int64_t UpdateTime(CBlockHeader* pblock);
 void SHA256Transform(void* pstate, void* pinput, const void* pinit);
 
 void GenerateVerium(bool fGenerate, std::shared_ptr<CWallet> pwallet, int nThreads, CConnman* connman, CTxMemPool* mempool);
-void GenerateVericoin(bool fGenerate, std::shared_ptr<CWallet> pwallet, CConnman* connman, CTxMemPool* mempool);
+/** Start or stop staking with the coins of all loaded wallets that have staking enabled */
+void GenerateVericoin(bool fGenerate, CConnman* connman, CTxMemPool* mempool);
 bool IsMining();
 bool IsStaking();
 
-extern double hashrate;
-
 namespace boost {
     class thread_group;
 } // namespace boost
@@ -16,6 +16,7 @@
 #include <netbase.h>
 #include <util/system.h>
 
+#include <limits>
 #include <stdint.h>
 
 #include <QDebug>
@@ -37,14 +38,29 @@ ClientModel::ClientModel(interfaces::Node& node, OptionsModel *_optionsModel, QO
     cachedBestHeaderTime = -1;
     peerTableModel = new PeerTableModel(m_node, this);
     banTableModel = new BanTableModel(m_node, this);
+    // peers connecting or disconnecting are shown without waiting for the next refresh
+    connect(this, &ClientModel::numConnectionsChanged, peerTableModel, &PeerTableModel::refresh);
 
     QTimer* timer = new QTimer;
     timer->setInterval(MODEL_UPDATE_DELAY);
-    connect(timer, &QTimer::timeout, [this] {
+    // only emit values that changed, so that an idle node does not repaint the views
+    size_t mempool_size = 0, mempool_usage = std::numeric_limits<size_t>::max();
+    int64_t bytes_recv = -1, bytes_sent = -1;
+    connect(timer, &QTimer::timeout, [this, mempool_size, mempool_usage, bytes_recv, bytes_sent]() mutable {
         // no locking required at this point
         // the following calls will acquire the required lock
-        Q_EMIT mempoolSizeChanged(m_node.getMempoolSize(), m_node.getMempoolDynamicUsage());
-        Q_EMIT bytesChanged(m_node.getTotalBytesRecv(), m_node.getTotalBytesSent());
+        const size_t new_mempool_size = m_node.getMempoolSize(), new_mempool_usage = m_node.getMempoolDynamicUsage();
+        if (new_mempool_size != mempool_size || new_mempool_usage != mempool_usage) {
+            mempool_size = new_mempool_size;
+            mempool_usage = new_mempool_usage;
+            Q_EMIT mempoolSizeChanged(mempool_size, mempool_usage);
+        }
+        const int64_t new_bytes_recv = m_node.getTotalBytesRecv(), new_bytes_sent = m_node.getTotalBytesSent();
+        if (new_bytes_recv != bytes_recv || new_bytes_sent != bytes_sent) {
+            bytes_recv = new_bytes_recv;
+            bytes_sent = new_bytes_sent;
+            Q_EMIT bytesChanged(bytes_recv, bytes_sent);
+        }
     });
     connect(m_thread, &QThread::finished, timer, &QObject::deleteLater);
     connect(m_thread, &QThread::started, [timer] { timer->start(); });
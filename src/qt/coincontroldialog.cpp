@@ -11,6 +11,7 @@
 
 #include <qt/addresstablemodel.h>
 #include <qt/bitcoinunits.h>
+#include <qt/coincontrolmodel.h>
 #include <qt/guiutil.h>
 #include <qt/optionsmodel.h>
 #include <qt/platformstyle.h>
@@ -26,29 +27,22 @@
 #include <QCheckBox>
 #include <QCursor>
 #include <QDialogButtonBox>
-#include <QFlags>
-#include <QIcon>
 #include <QSettings>
-#include <QTreeWidget>
+#include <QTreeView>
 
 QList<CAmount> CoinControlDialog::payAmounts;
 bool CoinControlDialog::fSubtractFeeFromAmount = false;
 
-bool CCoinControlWidgetItem::operator<(const QTreeWidgetItem &other) const {
-    int column = treeWidget()->sortColumn();
-    if (column == CoinControlDialog::COLUMN_AMOUNT || column == CoinControlDialog::COLUMN_DATE || column == CoinControlDialog::COLUMN_CONFIRMATIONS)
-        return data(column, Qt::UserRole).toLongLong() < other.data(column, Qt::UserRole).toLongLong();
-    return QTreeWidgetItem::operator<(other);
-}
-
 CoinControlDialog::CoinControlDialog(CCoinControl& coin_control, WalletModel* _model, const PlatformStyle *_platformStyle, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::CoinControlDialog),
     m_coin_control(coin_control),
     model(_model),
+    coinModel(new CoinControlModel(coin_control, _model, _platformStyle, this)),
     platformStyle(_platformStyle)
 {
     ui->setupUi(this);
+    ui->treeWidget->setModel(coinModel);
 
     // context menu actions
     QAction *copyAddressAction = new QAction(tr("Copy address"), this);
@@ -107,7 +101,10 @@ CoinControlDialog::CoinControlDialog(CCoinControl& coin_control, WalletModel* _m
     connect(ui->radioListMode, &QRadioButton::toggled, this, &CoinControlDialog::radioListMode);
 
     // click on checkbox
-    connect(ui->treeWidget, &QTreeWidget::itemChanged, this, &CoinControlDialog::viewItemChanged);
+    connect(coinModel, &CoinControlModel::selectionChanged, this, [this] {
+        CoinControlDialog::updateLabels(coinModel->selectedInputs(), m_coin_control, model, this);
+    });
+    connect(coinModel, &CoinControlModel::loaded, this, &CoinControlDialog::coinsLoaded);
 
     // click on header
     ui->treeWidget->header()->setSectionsClickable(true);
@@ -119,15 +116,17 @@ CoinControlDialog::CoinControlDialog(CCoinControl& coin_control, WalletModel* _m
     // (un)select all
     connect(ui->pushButtonSelectAll, &QPushButton::clicked, this, &CoinControlDialog::buttonSelectAllClicked);
 
-    ui->treeWidget->setColumnWidth(COLUMN_CHECKBOX, 84);
-    ui->treeWidget->setColumnWidth(COLUMN_AMOUNT, 110);
-    ui->treeWidget->setColumnWidth(COLUMN_LABEL, 190);
-    ui->treeWidget->setColumnWidth(COLUMN_ADDRESS, 320);
-    ui->treeWidget->setColumnWidth(COLUMN_DATE, 130);
-    ui->treeWidget->setColumnWidth(COLUMN_CONFIRMATIONS, 110);
+    ui->treeWidget->setColumnWidth(CoinControlModel::Checkbox, 84);
+    ui->treeWidget->setColumnWidth(CoinControlModel::Amount, 110);
+    ui->treeWidget->setColumnWidth(CoinControlModel::Label, 190);
+    ui->treeWidget->setColumnWidth(CoinControlModel::Address, 320);
+    ui->treeWidget->setColumnWidth(CoinControlModel::Date, 130);
+    ui->treeWidget->setColumnWidth(CoinControlModel::Confirmations, 110);
+    ui->treeWidget->setAlternatingRowColors(!ui->radioTreeMode->isChecked());
+    coinModel->setTreeMode(ui->radioTreeMode->isChecked());
 
     // default view is sorted by amount desc
-    sortView(COLUMN_AMOUNT, Qt::DescendingOrder);
+    sortView(CoinControlModel::Amount, Qt::DescendingOrder);
 
     // restore list mode and sortorder as a convenience feature
     QSettings settings;
@@ -136,9 +135,13 @@ CoinControlDialog::CoinControlDialog(CCoinControl& coin_control, WalletModel* _m
     if (settings.contains("nCoinControlSortColumn") && settings.contains("nCoinControlSortOrder"))
         sortView(settings.value("nCoinControlSortColumn").toInt(), (static_cast<Qt::SortOrder>(settings.value("nCoinControlSortOrder").toInt())));
 
+    // the coins are loaded in the background, until then the previous
+    // selection is shown in the labels
+    ui->treeWidget->setEnabled(false);
+    ui->pushButtonSelectAll->setEnabled(false);
     if(_model->getOptionsModel() && _model->getAddressTableModel())
     {
-        updateView();
+        coinModel->load();
         updateLabelLocked();
         CoinControlDialog::updateLabels(m_coin_control, _model, this);
     }
@@ -164,38 +167,31 @@ void CoinControlDialog::buttonBoxClicked(QAbstractButton* button)
 // (un)select all
 void CoinControlDialog::buttonSelectAllClicked()
 {
-    Qt::CheckState state = Qt::Checked;
-    for (int i = 0; i < ui->treeWidget->topLevelItemCount(); i++)
-    {
-        if (ui->treeWidget->topLevelItem(i)->checkState(COLUMN_CHECKBOX) != Qt::Unchecked)
-        {
-            state = Qt::Unchecked;
-            break;
-        }
-    }
-    ui->treeWidget->setEnabled(false);
-    for (int i = 0; i < ui->treeWidget->topLevelItemCount(); i++)
-            if (ui->treeWidget->topLevelItem(i)->checkState(COLUMN_CHECKBOX) != state)
-                ui->treeWidget->topLevelItem(i)->setCheckState(COLUMN_CHECKBOX, state);
+    coinModel->selectAll(coinModel->selectedInputs().quantity == 0);
+}
+
+// all coins are loaded
+void CoinControlDialog::coinsLoaded()
+{
+    expandPartiallySelected();
     ui->treeWidget->setEnabled(true);
-    if (state == Qt::Unchecked)
-        m_coin_control.UnSelectAll(); // just to be sure
-    CoinControlDialog::updateLabels(m_coin_control, model, this);
+    ui->pushButtonSelectAll->setEnabled(true);
+    updateLabelLocked();
 }
 
 // context menu
 void CoinControlDialog::showMenu(const QPoint &point)
 {
-    QTreeWidgetItem *item = ui->treeWidget->itemAt(point);
-    if(item)
+    QModelIndex index = ui->treeWidget->indexAt(point);
+    if(index.isValid())
     {
-        contextMenuItem = item;
+        contextMenuIndex = index;
 
         // disable some items (like Copy Transaction ID, lock, unlock) for tree roots in context menu
-        if (item->data(COLUMN_ADDRESS, TxHashRole).toString().length() == 64) // transaction hash is 64 characters (this means it is a child node, so it is not a parent node in tree mode)
+        if (!index.data(CoinControlModel::TxHashRole).isNull()) // this means it is a coin, so it is not a parent node in tree mode
         {
             copyTransactionHashAction->setEnabled(true);
-            if (model->wallet().isLockedCoin(COutPoint(uint256S(item->data(COLUMN_ADDRESS, TxHashRole).toString().toStdString()), item->data(COLUMN_ADDRESS, VOutRole).toUInt())))
+            if (coinModel->isLocked(index))
             {
                 lockAction->setEnabled(false);
                 unlockAction->setEnabled(true);
@@ -221,53 +217,44 @@ void CoinControlDialog::showMenu(const QPoint &point)
 // context menu action: copy amount
 void CoinControlDialog::copyAmount()
 {
-    GUIUtil::setClipboard(BitcoinUnits::removeSpaces(contextMenuItem->text(COLUMN_AMOUNT)));
+    GUIUtil::setClipboard(BitcoinUnits::removeSpaces(contextMenuIndex.sibling(contextMenuIndex.row(), CoinControlModel::Amount).data().toString()));
 }
 
 // context menu action: copy label
 void CoinControlDialog::copyLabel()
 {
-    if (ui->radioTreeMode->isChecked() && contextMenuItem->text(COLUMN_LABEL).length() == 0 && contextMenuItem->parent())
-        GUIUtil::setClipboard(contextMenuItem->parent()->text(COLUMN_LABEL));
-    else
-        GUIUtil::setClipboard(contextMenuItem->text(COLUMN_LABEL));
+    QModelIndex index = contextMenuIndex.sibling(contextMenuIndex.row(), CoinControlModel::Label);
+    if (ui->radioTreeMode->isChecked() && index.data().toString().length() == 0 && index.parent().isValid())
+        index = index.parent().sibling(index.parent().row(), CoinControlModel::Label);
+    GUIUtil::setClipboard(index.data().toString());
 }
 
 // context menu action: copy address
 void CoinControlDialog::copyAddress()
 {
-    if (ui->radioTreeMode->isChecked() && contextMenuItem->text(COLUMN_ADDRESS).length() == 0 && contextMenuItem->parent())
-        GUIUtil::setClipboard(contextMenuItem->parent()->text(COLUMN_ADDRESS));
-    else
-        GUIUtil::setClipboard(contextMenuItem->text(COLUMN_ADDRESS));
+    QModelIndex index = contextMenuIndex.sibling(contextMenuIndex.row(), CoinControlModel::Address);
+    if (ui->radioTreeMode->isChecked() && index.data().toString().length() == 0 && index.parent().isValid())
+        index = index.parent().sibling(index.parent().row(), CoinControlModel::Address);
+    GUIUtil::setClipboard(index.data().toString());
 }
 
 // context menu action: copy transaction id
 void CoinControlDialog::copyTransactionHash()
 {
-    GUIUtil::setClipboard(contextMenuItem->data(COLUMN_ADDRESS, TxHashRole).toString());
+    GUIUtil::setClipboard(contextMenuIndex.data(CoinControlModel::TxHashRole).toString());
 }
 
 // context menu action: lock coin
 void CoinControlDialog::lockCoin()
 {
-    if (contextMenuItem->checkState(COLUMN_CHECKBOX) == Qt::Checked)
-        contextMenuItem->setCheckState(COLUMN_CHECKBOX, Qt::Unchecked);
-
-    COutPoint outpt(uint256S(contextMenuItem->data(COLUMN_ADDRESS, TxHashRole).toString().toStdString()), contextMenuItem->data(COLUMN_ADDRESS, VOutRole).toUInt());
-    model->wallet().lockCoin(outpt);
-    contextMenuItem->setDisabled(true);
-    contextMenuItem->setIcon(COLUMN_CHECKBOX, platformStyle->SingleColorIcon(":/icons/lock_closed"));
+    coinModel->setLocked(contextMenuIndex, true);
     updateLabelLocked();
 }
 
 // context menu action: unlock coin
 void CoinControlDialog::unlockCoin()
 {
-    COutPoint outpt(uint256S(contextMenuItem->data(COLUMN_ADDRESS, TxHashRole).toString().toStdString()), contextMenuItem->data(COLUMN_ADDRESS, VOutRole).toUInt());
-    model->wallet().unlockCoin(outpt);
-    contextMenuItem->setDisabled(false);
-    contextMenuItem->setIcon(COLUMN_CHECKBOX, QIcon());
+    coinModel->setLocked(contextMenuIndex, false);
     updateLabelLocked();
 }
 
@@ -318,14 +305,14 @@ void CoinControlDialog::sortView(int column, Qt::SortOrder order)
 {
     sortColumn = column;
     sortOrder = order;
-    ui->treeWidget->sortItems(column, order);
+    coinModel->sort(column, order);
     ui->treeWidget->header()->setSortIndicator(sortColumn, sortOrder);
 }
 
 // treeview: clicked on header
 void CoinControlDialog::headerSectionClicked(int logicalIndex)
 {
-    if (logicalIndex == COLUMN_CHECKBOX) // click on most left column -> do nothing
+    if (logicalIndex == CoinControlModel::Checkbox) // click on most left column -> do nothing
     {
         ui->treeWidget->header()->setSortIndicator(sortColumn, sortOrder);
     }
@@ -336,7 +323,7 @@ void CoinControlDialog::headerSectionClicked(int logicalIndex)
         else
         {
             sortColumn = logicalIndex;
-            sortOrder = ((sortColumn == COLUMN_LABEL || sortColumn == COLUMN_ADDRESS) ? Qt::AscendingOrder : Qt::DescendingOrder); // if label or address then default => asc, else default => desc
+            sortOrder = ((sortColumn == CoinControlModel::Label || sortColumn == CoinControlModel::Address) ? Qt::AscendingOrder : Qt::DescendingOrder); // if label or address then default => asc, else default => desc
         }
 
         sortView(sortColumn, sortOrder);
@@ -347,41 +334,34 @@ void CoinControlDialog::headerSectionClicked(int logicalIndex)
 void CoinControlDialog::radioTreeMode(bool checked)
 {
     if (checked && model)
-        updateView();
+    {
+        ui->treeWidget->setAlternatingRowColors(false);
+        coinModel->setTreeMode(true);
+        expandPartiallySelected();
+    }
 }
 
 // toggle list mode
 void CoinControlDialog::radioListMode(bool checked)
 {
     if (checked && model)
-        updateView();
+    {
+        ui->treeWidget->setAlternatingRowColors(true);
+        coinModel->setTreeMode(false);
+    }
 }
 
-// checkbox clicked by user
-void CoinControlDialog::viewItemChanged(QTreeWidgetItem* item, int column)
+// expand all partially selected
+void CoinControlDialog::expandPartiallySelected()
 {
-    if (column == COLUMN_CHECKBOX && item->data(COLUMN_ADDRESS, TxHashRole).toString().length() == 64) // transaction hash is 64 characters (this means it is a child node, so it is not a parent node in tree mode)
-    {
-        COutPoint outpt(uint256S(item->data(COLUMN_ADDRESS, TxHashRole).toString().toStdString()), item->data(COLUMN_ADDRESS, VOutRole).toUInt());
-
-        if (item->checkState(COLUMN_CHECKBOX) == Qt::Unchecked)
-            m_coin_control.UnSelect(outpt);
-        else if (item->isDisabled()) // locked (this happens if "check all" through parent node)
-            item->setCheckState(COLUMN_CHECKBOX, Qt::Unchecked);
-        else
-            m_coin_control.Select(outpt);
-
-        // selection changed -> update labels
-        if (ui->treeWidget->isEnabled()) // do not update on every click for (un)select all
-            CoinControlDialog::updateLabels(m_coin_control, model, this);
-    }
+    if (!ui->radioTreeMode->isChecked())
+        return;
 
-    // TODO: Remove this temporary qt5 fix after Qt5.3 and Qt5.4 are no longer used.
-    //       Fixed in Qt5.5 and above: https://bugreports.qt.io/browse/QTBUG-43473
-    else if (column == COLUMN_CHECKBOX && item->childCount() > 0)
+    for (int i = 0; i < coinModel->rowCount(); i++)
     {
-        if (item->checkState(COLUMN_CHECKBOX) == Qt::PartiallyChecked && item->child(0)->checkState(COLUMN_CHECKBOX) == Qt::PartiallyChecked)
-            item->setCheckState(COLUMN_CHECKBOX, Qt::Checked);
+        QModelIndex index = coinModel->index(i, CoinControlModel::Checkbox);
+        if (index.data(Qt::CheckStateRole).toInt() == Qt::PartiallyChecked)
+            ui->treeWidget->expand(index);
     }
 }
 
@@ -403,32 +383,7 @@ void CoinControlDialog::updateLabels(CCoinControl& m_coin_control, WalletModel *
     if (!model)
         return;
 
-    // nPayAmount
-    CAmount nPayAmount = 0;
-    bool fDust = false;
-    CMutableTransaction txDummy;
-    for (const CAmount &amount : CoinControlDialog::payAmounts)
-    {
-        nPayAmount += amount;
-
-        if (amount > 0)
-        {
-            // Assumes a p2pkh script size
-            CTxOut txout(amount, CScript() << std::vector<unsigned char>(24, 0));
-            txDummy.vout.push_back(txout);
-            fDust |= IsDust(txout, model->node().getDustRelayFee());
-        }
-    }
-
-    CAmount nAmount             = 0;
-    CAmount nPayFee             = 0;
-    CAmount nAfterFee           = 0;
-    CAmount nChange             = 0;
-    unsigned int nBytes         = 0;
-    unsigned int nBytesInputs   = 0;
-    unsigned int nQuantity      = 0;
-    bool fWitness               = false;
-
+    CoinControlInputs inputs;
     std::vector<COutPoint> vCoinControl;
     m_coin_control.ListSelected(vCoinControl);
 
@@ -445,35 +400,47 @@ void CoinControlDialog::updateLabels(CCoinControl& m_coin_control, WalletModel *
             continue;
         }
 
-        // Quantity
-        nQuantity++;
+        bool witness;
+        inputs.quantity++;
+        inputs.amount += out.txout.nValue;
+        inputs.bytes += CoinControlModel::estimateInputSize(model->wallet(), out.txout, witness);
+        if (witness) inputs.witness++;
+    }
 
-        // Amount
-        nAmount += out.txout.nValue;
+    CoinControlDialog::updateLabels(inputs, m_coin_control, model, dialog);
+}
 
-        // Bytes
-        CTxDestination address;
-        int witnessversion = 0;
-        std::vector<unsigned char> witnessprogram;
-        if (out.txout.scriptPubKey.IsWitnessProgram(witnessversion, witnessprogram))
-        {
-            nBytesInputs += (32 + 4 + 1 + (107 / WITNESS_SCALE_FACTOR) + 4);
-            fWitness = true;
-        }
-        else if(ExtractDestination(out.txout.scriptPubKey, address))
+void CoinControlDialog::updateLabels(const CoinControlInputs& inputs, CCoinControl& m_coin_control, WalletModel *model, QDialog* dialog)
+{
+    if (!model)
+        return;
+
+    // nPayAmount
+    CAmount nPayAmount = 0;
+    bool fDust = false;
+    CMutableTransaction txDummy;
+    for (const CAmount &amount : CoinControlDialog::payAmounts)
+    {
+        nPayAmount += amount;
+
+        if (amount > 0)
         {
-            CPubKey pubkey;
-            PKHash *pkhash = boost::get<PKHash>(&address);
-            if (pkhash && model->wallet().getPubKey(out.txout.scriptPubKey, CKeyID(*pkhash), pubkey))
-            {
-                nBytesInputs += (pubkey.IsCompressed() ? 148 : 180);
-            }
-            else
-                nBytesInputs += 148; // in all error cases, simply assume 148 here
+            // Assumes a p2pkh script size
+            CTxOut txout(amount, CScript() << std::vector<unsigned char>(24, 0));
+            txDummy.vout.push_back(txout);
+            fDust |= IsDust(txout, model->node().getDustRelayFee());
         }
-        else nBytesInputs += 148;
     }
 
+    CAmount nAmount             = inputs.amount;
+    CAmount nPayFee             = 0;
+    CAmount nAfterFee           = 0;
+    CAmount nChange             = 0;
+    unsigned int nBytes         = 0;
+    unsigned int nBytesInputs   = inputs.bytes;
+    unsigned int nQuantity      = inputs.quantity;
+    bool fWitness               = inputs.witness > 0;
+
     // calculation
     if (nQuantity > 0)
     {
@@ -585,134 +552,3 @@ void CoinControlDialog::updateLabels(CCoinControl& m_coin_control, WalletModel *
     if (label)
         label->setVisible(nChange < 0);
 }
-
-void CoinControlDialog::updateView()
-{
-    if (!model || !model->getOptionsModel() || !model->getAddressTableModel())
-        return;
-
-    bool treeMode = ui->radioTreeMode->isChecked();
-
-    ui->treeWidget->clear();
-    ui->treeWidget->setEnabled(false); // performance, otherwise updateLabels would be called for every checked checkbox
-    ui->treeWidget->setAlternatingRowColors(!treeMode);
-    QFlags<Qt::ItemFlag> flgCheckbox = Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsUserCheckable;
-    QFlags<Qt::ItemFlag> flgTristate = Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsUserCheckable | Qt::ItemIsTristate;
-
-    int nDisplayUnit = model->getOptionsModel()->getDisplayUnit();
-
-    for (const auto& coins : model->wallet().listCoins()) {
-        CCoinControlWidgetItem* itemWalletAddress{nullptr};
-        QString sWalletAddress = QString::fromStdString(EncodeDestination(coins.first));
-        QString sWalletLabel = model->getAddressTableModel()->labelForAddress(sWalletAddress);
-        if (sWalletLabel.isEmpty())
-            sWalletLabel = tr("(no label)");
-
-        if (treeMode)
-        {
-            // wallet address
-            itemWalletAddress = new CCoinControlWidgetItem(ui->treeWidget);
-
-            itemWalletAddress->setFlags(flgTristate);
-            itemWalletAddress->setCheckState(COLUMN_CHECKBOX, Qt::Unchecked);
-
-            // label
-            itemWalletAddress->setText(COLUMN_LABEL, sWalletLabel);
-
-            // address
-            itemWalletAddress->setText(COLUMN_ADDRESS, sWalletAddress);
-        }
-
-        CAmount nSum = 0;
-        int nChildren = 0;
-        for (const auto& outpair : coins.second) {
-            const COutPoint& output = std::get<0>(outpair);
-            const interfaces::WalletTxOut& out = std::get<1>(outpair);
-            nSum += out.txout.nValue;
-            nChildren++;
-
-            CCoinControlWidgetItem *itemOutput;
-            if (treeMode)    itemOutput = new CCoinControlWidgetItem(itemWalletAddress);
-            else             itemOutput = new CCoinControlWidgetItem(ui->treeWidget);
-            itemOutput->setFlags(flgCheckbox);
-            itemOutput->setCheckState(COLUMN_CHECKBOX,Qt::Unchecked);
-
-            // address
-            CTxDestination outputAddress;
-            QString sAddress = "";
-            if(ExtractDestination(out.txout.scriptPubKey, outputAddress))
-            {
-                sAddress = QString::fromStdString(EncodeDestination(outputAddress));
-
-                // if listMode or change => show bitcoin address. In tree mode, address is not shown again for direct wallet address outputs
-                if (!treeMode || (!(sAddress == sWalletAddress)))
-                    itemOutput->setText(COLUMN_ADDRESS, sAddress);
-            }
-
-            // label
-            if (!(sAddress == sWalletAddress)) // change
-            {
-                // tooltip from where the change comes from
-                itemOutput->setToolTip(COLUMN_LABEL, tr("change from %1 (%2)").arg(sWalletLabel).arg(sWalletAddress));
-                itemOutput->setText(COLUMN_LABEL, tr("(change)"));
-            }
-            else if (!treeMode)
-            {
-                QString sLabel = model->getAddressTableModel()->labelForAddress(sAddress);
-                if (sLabel.isEmpty())
-                    sLabel = tr("(no label)");
-                itemOutput->setText(COLUMN_LABEL, sLabel);
-            }
-
-            // amount
-            itemOutput->setText(COLUMN_AMOUNT, BitcoinUnits::format(nDisplayUnit, out.txout.nValue));
-            itemOutput->setData(COLUMN_AMOUNT, Qt::UserRole, QVariant((qlonglong)out.txout.nValue)); // padding so that sorting works correctly
-
-            // date
-            itemOutput->setText(COLUMN_DATE, GUIUtil::dateTimeStr(out.time));
-            itemOutput->setData(COLUMN_DATE, Qt::UserRole, QVariant((qlonglong)out.time));
-
-            // confirmations
-            itemOutput->setText(COLUMN_CONFIRMATIONS, QString::number(out.depth_in_main_chain));
-            itemOutput->setData(COLUMN_CONFIRMATIONS, Qt::UserRole, QVariant((qlonglong)out.depth_in_main_chain));
-
-            // transaction hash
-            itemOutput->setData(COLUMN_ADDRESS, TxHashRole, QString::fromStdString(output.hash.GetHex()));
-
-            // vout index
-            itemOutput->setData(COLUMN_ADDRESS, VOutRole, output.n);
-
-             // disable locked coins
-            if (model->wallet().isLockedCoin(output))
-            {
-                m_coin_control.UnSelect(output); // just to be sure
-                itemOutput->setDisabled(true);
-                itemOutput->setIcon(COLUMN_CHECKBOX, platformStyle->SingleColorIcon(":/icons/lock_closed"));
-            }
-
-            // set checkbox
-            if (m_coin_control.IsSelected(output))
-                itemOutput->setCheckState(COLUMN_CHECKBOX, Qt::Checked);
-        }
-
-        // amount
-        if (treeMode)
-        {
-            itemWalletAddress->setText(COLUMN_CHECKBOX, "(" + QString::number(nChildren) + ")");
-            itemWalletAddress->setText(COLUMN_AMOUNT, BitcoinUnits::format(nDisplayUnit, nSum));
-            itemWalletAddress->setData(COLUMN_AMOUNT, Qt::UserRole, QVariant((qlonglong)nSum));
-        }
-    }
-
-    // expand all partially selected
-    if (treeMode)
-    {
-        for (int i = 0; i < ui->treeWidget->topLevelItemCount(); i++)
-            if (ui->treeWidget->topLevelItem(i)->checkState(COLUMN_CHECKBOX) == Qt::PartiallyChecked)
-                ui->treeWidget->topLevelItem(i)->setExpanded(true);
-    }
-
-    // sort view
-    sortView(sortColumn, sortOrder);
-    ui->treeWidget->setEnabled(true);
-}
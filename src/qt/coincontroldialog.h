@@ -12,14 +12,16 @@
 #include <QDialog>
 #include <QList>
 #include <QMenu>
+#include <QPersistentModelIndex>
 #include <QPoint>
 #include <QString>
-#include <QTreeWidgetItem>
 
+class CoinControlModel;
 class PlatformStyle;
 class WalletModel;
 
 class CCoinControl;
+struct CoinControlInputs;
 
 namespace Ui {
     class CoinControlDialog;
@@ -27,15 +29,6 @@ namespace Ui {
 
 #define ASYMP_UTF8 "\xE2\x89\x88"
 
-class CCoinControlWidgetItem : public QTreeWidgetItem
-{
-public:
-    explicit CCoinControlWidgetItem(QTreeWidget *parent, int type = Type) : QTreeWidgetItem(parent, type) {}
-    explicit CCoinControlWidgetItem(QTreeWidgetItem *parent, int type = Type) : QTreeWidgetItem(parent, type) {}
-
-    bool operator<(const QTreeWidgetItem &other) const;
-};
-
 
 class CoinControlDialog : public QDialog
 {
@@ -47,6 +40,7 @@ public:
 
     // static because also called from sendcoinsdialog
     static void updateLabels(CCoinControl& m_coin_control, WalletModel*, QDialog*);
+    static void updateLabels(const CoinControlInputs& inputs, CCoinControl& m_coin_control, WalletModel*, QDialog*);
 
     static QList<CAmount> payAmounts;
     static bool fSubtractFeeFromAmount;
@@ -55,11 +49,12 @@ private:
     Ui::CoinControlDialog *ui;
     CCoinControl& m_coin_control;
     WalletModel *model;
+    CoinControlModel *coinModel;
     int sortColumn;
     Qt::SortOrder sortOrder;
 
     QMenu *contextMenu;
-    QTreeWidgetItem *contextMenuItem;
+    QPersistentModelIndex contextMenuIndex;
     QAction *copyTransactionHashAction;
     QAction *lockAction;
     QAction *unlockAction;
@@ -67,25 +62,7 @@ private:
     const PlatformStyle *platformStyle;
 
     void sortView(int, Qt::SortOrder);
-    void updateView();
-
-    enum
-    {
-        COLUMN_CHECKBOX = 0,
-        COLUMN_AMOUNT,
-        COLUMN_LABEL,
-        COLUMN_ADDRESS,
-        COLUMN_DATE,
-        COLUMN_CONFIRMATIONS,
-    };
-
-    enum
-    {
-        TxHashRole = Qt::UserRole,
-        VOutRole
-    };
-
-    friend class CCoinControlWidgetItem;
+    void expandPartiallySelected();
 
 private Q_SLOTS:
     void showMenu(const QPoint &);
@@ -104,7 +81,7 @@ private Q_SLOTS:
     void clipboardChange();
     void radioTreeMode(bool);
     void radioListMode(bool);
-    void viewItemChanged(QTreeWidgetItem*, int);
+    void coinsLoaded();
     void headerSectionClicked(int);
     void buttonBoxClicked(QAbstractButton*);
     void buttonSelectAllClicked();
@@ -0,0 +1,581 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/coincontrolmodel.h>
+
+#include <qt/addresstablemodel.h>
+#include <qt/bitcoinunits.h>
+#include <qt/guiutil.h>
+#include <qt/optionsmodel.h>
+#include <qt/platformstyle.h>
+#include <qt/walletmodel.h>
+
+#include <consensus/consensus.h>
+#include <key_io.h>
+#include <wallet/coincontrol.h>
+
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <set>
+
+namespace {
+
+/** Sort indexes with a stable less-than comparison, in the given order */
+template <typename Less>
+void SortIndexes(std::vector<int>& indexes, Qt::SortOrder order, Less less)
+{
+    if (order == Qt::AscendingOrder) {
+        std::stable_sort(indexes.begin(), indexes.end(), less);
+    } else {
+        std::stable_sort(indexes.begin(), indexes.end(), [&less](int a, int b) { return less(b, a); });
+    }
+}
+
+} // namespace
+
+CoinControlModel::CoinControlModel(CCoinControl& coin_control, WalletModel *wallet_model, const PlatformStyle *platformStyle, QObject *parent) :
+    QAbstractItemModel(parent),
+    m_coin_control(coin_control),
+    m_wallet_model(wallet_model),
+    m_lock_icon(platformStyle->SingleColorIcon(":/icons/lock_closed")),
+    m_thread(new QThread(this)),
+    m_worker(new QObject)
+{
+    m_columns << QString() << tr("Amount") << tr("Received with label") << tr("Received with address") << tr("Date") << tr("Confirmations");
+
+    m_worker->moveToThread(m_thread);
+    m_thread->start();
+}
+
+CoinControlModel::~CoinControlModel()
+{
+    // Waits for a load in progress, which refers to this model
+    m_thread->quit();
+    m_thread->wait();
+    delete m_worker;
+}
+
+unsigned int CoinControlModel::estimateInputSize(interfaces::Wallet& wallet, const CTxOut& txout, bool& witness)
+{
+    CTxDestination address;
+    int witnessversion = 0;
+    std::vector<unsigned char> witnessprogram;
+    witness = txout.scriptPubKey.IsWitnessProgram(witnessversion, witnessprogram);
+    if (witness)
+        return 32 + 4 + 1 + (107 / WITNESS_SCALE_FACTOR) + 4;
+
+    if (ExtractDestination(txout.scriptPubKey, address))
+    {
+        CPubKey pubkey;
+        PKHash *pkhash = boost::get<PKHash>(&address);
+        if (pkhash && wallet.getPubKey(txout.scriptPubKey, CKeyID(*pkhash), pubkey))
+            return pubkey.IsCompressed() ? 148 : 180;
+    }
+    return 148; // in all error cases, simply assume 148 here
+}
+
+void CoinControlModel::load()
+{
+    // Filled in the worker thread, then handed over to the GUI thread at once
+    auto coins = std::make_shared<std::vector<Coin>>();
+    auto groups = std::make_shared<std::vector<Group>>();
+    QTimer::singleShot(0, m_worker, [this, coins, groups] {
+        interfaces::Wallet& wallet = m_wallet_model->wallet();
+        for (const auto& entry : wallet.listCoins()) {
+            Group group;
+            group.address = QString::fromStdString(EncodeDestination(entry.first));
+            for (const auto& outpair : entry.second) {
+                Coin coin;
+                coin.outpoint = std::get<0>(outpair);
+                coin.out = std::get<1>(outpair);
+                CTxDestination destination;
+                if (ExtractDestination(coin.out.txout.scriptPubKey, destination)) {
+                    coin.address = QString::fromStdString(EncodeDestination(destination));
+                }
+                coin.input_size = estimateInputSize(wallet, coin.out.txout, coin.witness);
+                coin.locked = wallet.isLockedCoin(coin.outpoint);
+                coin.group = groups->size();
+                group.amount += coin.out.txout.nValue;
+                group.coins.push_back(coins->size());
+                coins->push_back(std::move(coin));
+            }
+            groups->push_back(std::move(group));
+        }
+        QTimer::singleShot(0, this, [this, coins, groups] {
+            setCoins(std::move(*coins), std::move(*groups));
+        });
+    });
+}
+
+void CoinControlModel::setCoins(std::vector<Coin> coins, std::vector<Group> groups)
+{
+    beginResetModel();
+    m_coins = std::move(coins);
+    m_groups = std::move(groups);
+    for (Group& group : m_groups) {
+        group.label = m_wallet_model->getAddressTableModel()->labelForAddress(group.address);
+        if (group.label.isEmpty())
+            group.label = tr("(no label)");
+    }
+
+    // Keep the previous selection. Coins that are locked or no longer
+    // available are unselected, as they could not be unselected in the view.
+    std::vector<COutPoint> selected;
+    m_coin_control.ListSelected(selected);
+    const std::set<COutPoint> previously_selected(selected.begin(), selected.end());
+    m_coin_control.UnSelectAll();
+    m_inputs = CoinControlInputs();
+    for (size_t i = 0; i < m_coins.size(); ++i) {
+        if (!m_coins[i].locked && previously_selected.count(m_coins[i].outpoint)) {
+            selectCoin(i, true);
+        }
+    }
+
+    m_group_order.resize(m_groups.size());
+    std::iota(m_group_order.begin(), m_group_order.end(), 0);
+    m_coin_order.resize(m_coins.size());
+    std::iota(m_coin_order.begin(), m_coin_order.end(), 0);
+    sortRows();
+    m_loaded = true;
+    endResetModel();
+
+    Q_EMIT loaded();
+    Q_EMIT selectionChanged();
+}
+
+void CoinControlModel::setTreeMode(bool tree_mode)
+{
+    if (tree_mode == m_tree_mode)
+        return;
+
+    beginResetModel();
+    m_tree_mode = tree_mode;
+    for (Group& group : m_groups) {
+        group.shown = 0;
+    }
+    sortRows();
+    endResetModel();
+}
+
+bool CoinControlModel::selectCoin(int coin_index, bool select)
+{
+    const Coin& coin = m_coins[coin_index];
+    if (m_coin_control.IsSelected(coin.outpoint) == select)
+        return false;
+
+    Group& group = m_groups[coin.group];
+    if (select) {
+        m_coin_control.Select(coin.outpoint);
+        m_inputs.quantity++;
+        m_inputs.amount += coin.out.txout.nValue;
+        m_inputs.bytes += coin.input_size;
+        if (coin.witness) m_inputs.witness++;
+        group.selected++;
+    } else {
+        m_coin_control.UnSelect(coin.outpoint);
+        m_inputs.quantity--;
+        m_inputs.amount -= coin.out.txout.nValue;
+        m_inputs.bytes -= coin.input_size;
+        if (coin.witness) m_inputs.witness--;
+        group.selected--;
+    }
+    return true;
+}
+
+void CoinControlModel::emitCheckStateChanged(int group)
+{
+    if (!m_tree_mode)
+        return;
+
+    const QModelIndex parent = groupIndex(group, Checkbox);
+    Q_EMIT dataChanged(parent, parent);
+    if (m_groups[group].shown > 0) {
+        Q_EMIT dataChanged(index(0, Checkbox, parent), index(m_groups[group].shown - 1, Checkbox, parent));
+    }
+}
+
+void CoinControlModel::selectAll(bool select)
+{
+    bool changed = false;
+    for (size_t i = 0; i < m_coins.size(); ++i) {
+        if (select && m_coins[i].locked)
+            continue;
+        changed |= selectCoin(i, select);
+    }
+    if (!changed)
+        return;
+
+    Q_EMIT dataChanged(index(0, Checkbox), index(rowCount() - 1, Checkbox));
+    if (m_tree_mode) {
+        for (size_t group = 0; group < m_groups.size(); ++group) {
+            if (m_groups[group].shown == 0)
+                continue;
+            const QModelIndex parent = groupIndex(group, Checkbox);
+            Q_EMIT dataChanged(index(0, Checkbox, parent), index(m_groups[group].shown - 1, Checkbox, parent));
+        }
+    }
+    Q_EMIT selectionChanged();
+}
+
+bool CoinControlModel::isLocked(const QModelIndex &index) const
+{
+    return index.isValid() && !isGroup(index) && m_coins[coinAt(index)].locked;
+}
+
+void CoinControlModel::setLocked(const QModelIndex &index, bool locked)
+{
+    if (!index.isValid() || isGroup(index))
+        return;
+
+    const int coin_index = coinAt(index);
+    Coin& coin = m_coins[coin_index];
+    if (coin.locked == locked)
+        return;
+
+    bool unselected = false;
+    if (locked) {
+        unselected = selectCoin(coin_index, false);
+        m_wallet_model->wallet().lockCoin(coin.outpoint);
+    } else {
+        m_wallet_model->wallet().unlockCoin(coin.outpoint);
+    }
+    coin.locked = locked;
+
+    Q_EMIT dataChanged(coinIndex(coin_index, Checkbox), coinIndex(coin_index, Confirmations));
+    if (unselected) {
+        emitCheckStateChanged(coin.group);
+        Q_EMIT selectionChanged();
+    }
+}
+
+bool CoinControlModel::isGroup(const QModelIndex &index) const
+{
+    return index.isValid() && m_tree_mode && index.internalId() == 0;
+}
+
+int CoinControlModel::groupAt(const QModelIndex &index) const
+{
+    if (isGroup(index))
+        return m_group_order[index.row()];
+    return m_coins[coinAt(index)].group;
+}
+
+int CoinControlModel::coinAt(const QModelIndex &index) const
+{
+    if (m_tree_mode)
+        return m_groups[index.internalId() - 1].coins[index.row()];
+    return m_coin_order[index.row()];
+}
+
+QModelIndex CoinControlModel::groupIndex(int group, int column) const
+{
+    return createIndex(m_group_row[group], column, quintptr(0));
+}
+
+QModelIndex CoinControlModel::coinIndex(int coin, int column) const
+{
+    const int row = m_coin_row[coin];
+    if (row < 0)
+        return QModelIndex();
+    return createIndex(row, column, quintptr(m_tree_mode ? m_coins[coin].group + 1 : 0));
+}
+
+QString CoinControlModel::coinLabel(const Coin& coin) const
+{
+    const Group& group = m_groups[coin.group];
+    if (coin.address != group.address)
+        return tr("(change)");
+    // In tree mode the label of the address is not shown again for its own outputs
+    return m_tree_mode ? QString() : group.label;
+}
+
+QString CoinControlModel::coinAddress(const Coin& coin) const
+{
+    if (m_tree_mode && coin.address == m_groups[coin.group].address)
+        return QString();
+    return coin.address;
+}
+
+bool CoinControlModel::lessThan(const Coin& a, const Coin& b) const
+{
+    switch (m_sort_column) {
+    case Amount:
+        return a.out.txout.nValue < b.out.txout.nValue;
+    case Label:
+        return coinLabel(a) < coinLabel(b);
+    case Address:
+        return coinAddress(a) < coinAddress(b);
+    case Date:
+        return a.out.time < b.out.time;
+    case Confirmations:
+        return a.out.depth_in_main_chain < b.out.depth_in_main_chain;
+    }
+    return false;
+}
+
+void CoinControlModel::sortGroup(Group& group)
+{
+    SortIndexes(group.coins, m_sort_order, [this](int a, int b) { return lessThan(m_coins[a], m_coins[b]); });
+}
+
+void CoinControlModel::sortRows()
+{
+    if (m_tree_mode) {
+        SortIndexes(m_group_order, m_sort_order, [this](int a, int b) -> bool {
+            const Group& x = m_groups[a];
+            const Group& y = m_groups[b];
+            switch (m_sort_column) {
+            case Amount:
+                return x.amount < y.amount;
+            case Label:
+                return x.label < y.label;
+            case Address:
+                return x.address < y.address;
+            }
+            return false;
+        });
+        // The coins of addresses that were never expanded are sorted when they are
+        for (Group& group : m_groups) {
+            if (group.shown > 0) sortGroup(group);
+        }
+    } else {
+        SortIndexes(m_coin_order, m_sort_order, [this](int a, int b) { return lessThan(m_coins[a], m_coins[b]); });
+    }
+    updateRows();
+}
+
+void CoinControlModel::updateRows()
+{
+    m_group_row.assign(m_groups.size(), -1);
+    for (size_t row = 0; row < m_group_order.size(); ++row) {
+        m_group_row[m_group_order[row]] = row;
+    }
+
+    m_coin_row.assign(m_coins.size(), -1);
+    if (m_tree_mode) {
+        for (const Group& group : m_groups) {
+            for (int row = 0; row < group.shown; ++row) {
+                m_coin_row[group.coins[row]] = row;
+            }
+        }
+    } else {
+        for (size_t row = 0; row < m_coin_order.size(); ++row) {
+            m_coin_row[m_coin_order[row]] = row;
+        }
+    }
+}
+
+void CoinControlModel::sort(int column, Qt::SortOrder order)
+{
+    m_sort_column = column;
+    m_sort_order = order;
+
+    Q_EMIT layoutAboutToBeChanged();
+    // Remember what the persistent indexes (selection, expanded addresses)
+    // refer to, as their rows change
+    const QModelIndexList from = persistentIndexList();
+    std::vector<std::pair<bool, int>> targets;
+    for (const QModelIndex& index : from) {
+        const bool group = isGroup(index);
+        targets.emplace_back(group, group ? groupAt(index) : coinAt(index));
+    }
+
+    sortRows();
+
+    QModelIndexList to;
+    for (int i = 0; i < from.size(); ++i) {
+        to << (targets[i].first ? groupIndex(targets[i].second, from[i].column()) : coinIndex(targets[i].second, from[i].column()));
+    }
+    changePersistentIndexList(from, to);
+    Q_EMIT layoutChanged();
+}
+
+QModelIndex CoinControlModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (row < 0 || column < 0 || column >= m_columns.size() || row >= rowCount(parent))
+        return QModelIndex();
+    // Coins shown under an address refer to it by its index plus one
+    return createIndex(row, column, quintptr(parent.isValid() ? groupAt(parent) + 1 : 0));
+}
+
+QModelIndex CoinControlModel::parent(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.internalId() == 0)
+        return QModelIndex();
+    return groupIndex(index.internalId() - 1, Checkbox);
+}
+
+int CoinControlModel::rowCount(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return m_tree_mode ? m_groups.size() : m_coins.size();
+    if (parent.column() != Checkbox || !isGroup(parent))
+        return 0;
+    return m_groups[groupAt(parent)].shown;
+}
+
+int CoinControlModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return m_columns.size();
+}
+
+bool CoinControlModel::hasChildren(const QModelIndex &parent) const
+{
+    if (!parent.isValid())
+        return rowCount() > 0;
+    // Addresses have coins before they are shown
+    return parent.column() == Checkbox && isGroup(parent);
+}
+
+bool CoinControlModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.column() != Checkbox || !isGroup(parent))
+        return false;
+    const Group& group = m_groups[groupAt(parent)];
+    return group.shown < (int)group.coins.size();
+}
+
+void CoinControlModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    Group& group = m_groups[groupAt(parent)];
+    sortGroup(group);
+    beginInsertRows(parent, 0, group.coins.size() - 1);
+    group.shown = group.coins.size();
+    for (int row = 0; row < group.shown; ++row) {
+        m_coin_row[group.coins[row]] = row;
+    }
+    endInsertRows();
+}
+
+QVariant CoinControlModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const int unit = m_wallet_model->getOptionsModel()->getDisplayUnit();
+    if (isGroup(index)) {
+        const Group& group = m_groups[groupAt(index)];
+        switch (role) {
+        case Qt::DisplayRole:
+            switch (index.column()) {
+            case Checkbox:
+                return "(" + QString::number(group.coins.size()) + ")";
+            case Amount:
+                return BitcoinUnits::format(unit, group.amount);
+            case Label:
+                return group.label;
+            case Address:
+                return group.address;
+            }
+            break;
+        case Qt::CheckStateRole:
+            if (index.column() == Checkbox) {
+                if (group.selected == 0)
+                    return Qt::Unchecked;
+                return group.selected == (int)group.coins.size() ? Qt::Checked : Qt::PartiallyChecked;
+            }
+            break;
+        }
+        return QVariant();
+    }
+
+    const Coin& coin = m_coins[coinAt(index)];
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case Amount:
+            return BitcoinUnits::format(unit, coin.out.txout.nValue);
+        case Label:
+            return coinLabel(coin);
+        case Address:
+            return coinAddress(coin);
+        case Date:
+            return GUIUtil::dateTimeStr(coin.out.time);
+        case Confirmations:
+            return QString::number(coin.out.depth_in_main_chain);
+        }
+        break;
+    case Qt::ToolTipRole:
+        if (index.column() == Label && coin.address != m_groups[coin.group].address) {
+            // tooltip from where the change comes from
+            const Group& group = m_groups[coin.group];
+            return tr("change from %1 (%2)").arg(group.label).arg(group.address);
+        }
+        break;
+    case Qt::DecorationRole:
+        if (index.column() == Checkbox && coin.locked)
+            return m_lock_icon;
+        break;
+    case Qt::CheckStateRole:
+        if (index.column() == Checkbox)
+            return m_coin_control.IsSelected(coin.outpoint) ? Qt::Checked : Qt::Unchecked;
+        break;
+    case TxHashRole:
+        return QString::fromStdString(coin.outpoint.hash.GetHex());
+    case VOutRole:
+        return coin.outpoint.n;
+    }
+    return QVariant();
+}
+
+bool CoinControlModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.column() != Checkbox || role != Qt::CheckStateRole)
+        return false;
+
+    const bool select = static_cast<Qt::CheckState>(value.toInt()) != Qt::Unchecked;
+    if (isGroup(index)) {
+        const int group = groupAt(index);
+        bool changed = false;
+        for (const int coin : m_groups[group].coins) {
+            if (select && m_coins[coin].locked)
+                continue;
+            changed |= selectCoin(coin, select);
+        }
+        if (!changed)
+            return false;
+        emitCheckStateChanged(group);
+    } else {
+        const int coin = coinAt(index);
+        if (m_coins[coin].locked || !selectCoin(coin, select))
+            return false;
+        Q_EMIT dataChanged(index, index);
+        emitCheckStateChanged(m_coins[coin].group);
+    }
+    Q_EMIT selectionChanged();
+    return true;
+}
+
+QVariant CoinControlModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || section < 0 || section >= m_columns.size())
+        return QVariant();
+    if (role == Qt::DisplayRole)
+        return m_columns[section];
+    if (role == Qt::ToolTipRole && section == Confirmations)
+        return tr("Confirmed");
+    return QVariant();
+}
+
+Qt::ItemFlags CoinControlModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+
+    Qt::ItemFlags flags = Qt::ItemIsSelectable;
+    if (index.column() == Checkbox)
+        flags |= Qt::ItemIsUserCheckable;
+    // Locked coins are disabled
+    if (isGroup(index) || !m_coins[coinAt(index)].locked)
+        flags |= Qt::ItemIsEnabled;
+    return flags;
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_QT_COINCONTROLMODEL_H
+#define BITCOIN_QT_COINCONTROLMODEL_H
+
+#include <amount.h>
+#include <interfaces/wallet.h>
+#include <primitives/transaction.h>
+
+#include <QAbstractItemModel>
+#include <QIcon>
+#include <QStringList>
+
+#include <vector>
+
+class CCoinControl;
+class PlatformStyle;
+class WalletModel;
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+/** Inputs selected with coin control, summed up for the fee and size estimates */
+struct CoinControlInputs
+{
+    unsigned int quantity{0};
+    CAmount amount{0};
+    //! Estimated size of the inputs
+    unsigned int bytes{0};
+    //! Number of inputs spending witness programs
+    unsigned int witness{0};
+};
+
+/** UI model of the spendable coins of a wallet for the coin control dialog,
+    either grouped by the address they were received with (tree mode) or as a
+    flat list.
+
+    The coins are loaded in a background thread. The coins of an address are
+    only sorted and shown once the address is expanded, and the selected
+    inputs are summed up as coins are selected and unselected, so the dialog
+    stays responsive with tens of thousands of coins.
+ */
+class CoinControlModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    explicit CoinControlModel(CCoinControl& coin_control, WalletModel *wallet_model, const PlatformStyle *platformStyle, QObject *parent = nullptr);
+    ~CoinControlModel();
+
+    enum ColumnIndex {
+        Checkbox = 0,
+        Amount = 1,
+        Label = 2,
+        Address = 3,
+        Date = 4,
+        Confirmations = 5
+    };
+
+    enum RoleIndex {
+        /** Transaction hash of a coin, null for an address */
+        TxHashRole = Qt::UserRole,
+        /** Output index of a coin */
+        VOutRole
+    };
+
+    /** Estimate the size of a coin as a transaction input */
+    static unsigned int estimateInputSize(interfaces::Wallet& wallet, const CTxOut& txout, bool& witness);
+
+    /** Load the coins of the wallet in the background, loaded() is emitted when done */
+    void load();
+    bool isLoaded() const { return m_loaded; }
+
+    /** Group the coins by address, or list them */
+    void setTreeMode(bool tree_mode);
+
+    const CoinControlInputs& selectedInputs() const { return m_inputs; }
+
+    /** Select all coins that are not locked, or unselect all coins */
+    void selectAll(bool select);
+
+    bool isLocked(const QModelIndex &index) const;
+    /** Lock or unlock a coin in the wallet, locked coins are unselected */
+    void setLocked(const QModelIndex &index, bool locked);
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &index) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+Q_SIGNALS:
+    /** The coins of the wallet have been loaded */
+    void loaded();
+    /** Coins were selected or unselected */
+    void selectionChanged();
+
+private:
+    struct Coin
+    {
+        COutPoint outpoint;
+        interfaces::WalletTxOut out;
+        //! Address the coin pays to, empty if it has none
+        QString address;
+        unsigned int input_size;
+        bool witness;
+        bool locked;
+        //! Index of the address group of the coin
+        int group;
+    };
+
+    struct Group
+    {
+        QString address;
+        QString label;
+        CAmount amount{0};
+        //! Indexes of the coins of the address, in display order once shown
+        std::vector<int> coins;
+        //! Number of coins shown, zero until the address is expanded
+        int shown{0};
+        //! Number of selected coins
+        int selected{0};
+    };
+
+    CCoinControl& m_coin_control;
+    WalletModel* const m_wallet_model;
+    QStringList m_columns;
+    QIcon m_lock_icon;
+    QThread* const m_thread;
+    QObject* const m_worker;
+
+    bool m_loaded{false};
+    bool m_tree_mode{false};
+    int m_sort_column{Amount};
+    Qt::SortOrder m_sort_order{Qt::DescendingOrder};
+
+    std::vector<Coin> m_coins;
+    std::vector<Group> m_groups;
+    //! Addresses and coins in display order
+    std::vector<int> m_group_order;
+    std::vector<int> m_coin_order;
+    //! Rows of addresses and coins, a coin's row is within its address in tree mode
+    std::vector<int> m_group_row;
+    std::vector<int> m_coin_row;
+    CoinControlInputs m_inputs;
+
+    void setCoins(std::vector<Coin> coins, std::vector<Group> groups);
+    bool isGroup(const QModelIndex &index) const;
+    int groupAt(const QModelIndex &index) const;
+    int coinAt(const QModelIndex &index) const;
+    QModelIndex groupIndex(int group, int column) const;
+    QModelIndex coinIndex(int coin, int column) const;
+    QString coinLabel(const Coin& coin) const;
+    QString coinAddress(const Coin& coin) const;
+    bool lessThan(const Coin& a, const Coin& b) const;
+    void sortGroup(Group& group);
+    void sortRows();
+    void updateRows();
+    /** Select or unselect a coin and update the selected inputs, returns whether it changed */
+    bool selectCoin(int coin, bool select);
+    void emitCheckStateChanged(int group);
+};
+
+#endif // BITCOIN_QT_COINCONTROLMODEL_H
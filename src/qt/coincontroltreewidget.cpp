@@ -4,9 +4,10 @@
 
 #include <qt/coincontroltreewidget.h>
 #include <qt/coincontroldialog.h>
+#include <qt/coincontrolmodel.h>
 
 CoinControlTreeWidget::CoinControlTreeWidget(QWidget *parent) :
-    QTreeWidget(parent)
+    QTreeView(parent)
 {
 
 }
@@ -16,9 +17,10 @@ void CoinControlTreeWidget::keyPressEvent(QKeyEvent *event)
     if (event->key() == Qt::Key_Space) // press spacebar -> select checkbox
     {
         event->ignore();
-        if (this->currentItem()) {
-            int COLUMN_CHECKBOX = 0;
-            this->currentItem()->setCheckState(COLUMN_CHECKBOX, ((this->currentItem()->checkState(COLUMN_CHECKBOX) == Qt::Checked) ? Qt::Unchecked : Qt::Checked));
+        QModelIndex index = this->currentIndex();
+        if (index.isValid()) {
+            index = index.sibling(index.row(), CoinControlModel::Checkbox);
+            this->model()->setData(index, ((index.data(Qt::CheckStateRole).toInt() == Qt::Checked) ? Qt::Unchecked : Qt::Checked), Qt::CheckStateRole);
         }
     }
     else if (event->key() == Qt::Key_Escape) // press esc -> close dialog
@@ -29,6 +31,6 @@ void CoinControlTreeWidget::keyPressEvent(QKeyEvent *event)
     }
     else
     {
-        this->QTreeWidget::keyPressEvent(event);
+        this->QTreeView::keyPressEvent(event);
     }
 }
@@ -10,6 +10,15 @@
 /* Milliseconds between model updates */
 static const int MODEL_UPDATE_DELAY = 250;
 
+/* TransactionTableModel -- Number of wallet transactions loaded at a time */
+static const int TX_FETCH_BATCH_SIZE = 1000;
+
+/* PeerTableModel -- Milliseconds between updates of the peer statistics, peers connecting or disconnecting are shown right away */
+static const int PEER_STATS_UPDATE_DELAY = 1000;
+
+/* WalletTaskExecutor -- Milliseconds before a progress dialog is shown for a wallet operation */
+static const int WALLET_TASK_PROGRESS_DELAY = 500;
+
 /* AskPassphraseDialog -- Maximum passphrase length */
 static const int MAX_PASSPHRASE_SIZE = 1024;
 
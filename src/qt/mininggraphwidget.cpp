@@ -0,0 +1,106 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/mininggraphwidget.h>
+
+#include <clientversion.h>
+#include <qt/clientmodel.h>
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QColor>
+#include <QTimer>
+
+// The miner publishes its hashrate and the staker hashes kernels about every
+// half minute, so shorter samples would only show those steps
+#define SAMPLE_INTERVAL_MSECS   30000
+#define DESIRED_SAMPLES         120
+
+#define XMARGIN                 2
+#define YMARGIN                 2
+
+MiningGraphWidget::MiningGraphWidget(QWidget *parent) :
+    QWidget(parent),
+    timer(nullptr),
+    fMax(0.0),
+    vSamples(),
+    nLastKernelHashes(0),
+    clientModel(nullptr)
+{
+    timer = new QTimer(this);
+    timer->setInterval(SAMPLE_INTERVAL_MSECS);
+    connect(timer, &QTimer::timeout, this, &MiningGraphWidget::updateStats);
+}
+
+void MiningGraphWidget::setClientModel(ClientModel *model)
+{
+    clientModel = model;
+    clear();
+}
+
+void MiningGraphWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+
+    if(fMax <= 0.0 || vSamples.empty()) return;
+
+    int h = height() - YMARGIN * 2, w = width() - XMARGIN * 2;
+    int x = XMARGIN + w;
+    QPainterPath path;
+    path.moveTo(x, YMARGIN + h);
+    for(int i = 0; i < vSamples.size(); ++i) {
+        x = XMARGIN + w - w * i / DESIRED_SAMPLES;
+        int y = YMARGIN + h - (int)(h * vSamples.at(i) / fMax);
+        path.lineTo(x, y);
+    }
+    path.lineTo(x, YMARGIN + h);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillPath(path, QColor(0, 255, 0, 128));
+    painter.setPen(Qt::green);
+    painter.drawPath(path);
+}
+
+void MiningGraphWidget::updateStats()
+{
+    if(!clientModel) return;
+
+    const interfaces::MiningStats stats = clientModel->node().getMiningStats();
+    double rate;
+    if(IsVericoin()) {
+        rate = (stats.kernel_hashes - nLastKernelHashes) * 1000.0 / SAMPLE_INTERVAL_MSECS;
+        nLastKernelHashes = stats.kernel_hashes;
+    } else {
+        rate = stats.mining ? stats.hashes_per_min : 0.0;
+    }
+
+    vSamples.push_front(rate);
+    while(vSamples.size() > DESIRED_SAMPLES) {
+        vSamples.pop_back();
+    }
+
+    fMax = 0.0;
+    for (const double f : vSamples) {
+        if(f > fMax) fMax = f;
+    }
+    update();
+    Q_EMIT statsChanged(stats, rate);
+}
+
+void MiningGraphWidget::clear()
+{
+    timer->stop();
+
+    vSamples.clear();
+    fMax = 0.0;
+
+    if(clientModel) {
+        const interfaces::MiningStats stats = clientModel->node().getMiningStats();
+        nLastKernelHashes = stats.kernel_hashes;
+        Q_EMIT statsChanged(stats, IsVericoin() ? 0.0 : stats.hashes_per_min);
+        timer->start();
+    }
+    update();
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_QT_MININGGRAPHWIDGET_H
+#define BITCOIN_QT_MININGGRAPHWIDGET_H
+
+#include <interfaces/node.h>
+
+#include <QWidget>
+#include <QQueue>
+
+class ClientModel;
+
+QT_BEGIN_NAMESPACE
+class QPaintEvent;
+class QTimer;
+QT_END_NAMESPACE
+
+/** Sparkline of the local hashrate, or of the stake kernels tried per second
+ * when staking, sampled from the lock-free mining metrics of the node. */
+class MiningGraphWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MiningGraphWidget(QWidget *parent = nullptr);
+    void setClientModel(ClientModel *model);
+
+protected:
+    void paintEvent(QPaintEvent *);
+
+public Q_SLOTS:
+    void updateStats();
+    void clear();
+
+Q_SIGNALS:
+    /** Emitted with every sample: the node's mining statistics and the
+     * sampled rate (hashes per minute or stake kernels per second) */
+    void statsChanged(const interfaces::MiningStats& stats, double rate);
+
+private:
+    QTimer *timer;
+    double fMax;
+    QQueue<double> vSamples;
+    quint64 nLastKernelHashes;
+    ClientModel *clientModel;
+};
+
+#endif // BITCOIN_QT_MININGGRAPHWIDGET_H
@@ -110,7 +110,7 @@ PeerTableModel::PeerTableModel(interfaces::Node& node, QObject* parent) :
     // set up timer for auto refresh
     timer = new QTimer(this);
     connect(timer, &QTimer::timeout, this, &PeerTableModel::refresh);
-    timer->setInterval(MODEL_UPDATE_DELAY);
+    timer->setInterval(PEER_STATS_UPDATE_DELAY);
 
     // load initial data
     refresh();
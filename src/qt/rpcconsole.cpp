@@ -14,6 +14,7 @@
 #include <qt/platformstyle.h>
 #include <qt/walletmodel.h>
 #include <chainparams.h>
+#include <clientversion.h>
 #include <interfaces/node.h>
 #include <netbase.h>
 #include <rpc/server.h>
@@ -473,6 +474,20 @@ RPCConsole::RPCConsole(interfaces::Node& node, const PlatformStyle *_platformSty
     connect(ui->fontBiggerButton, &QPushButton::clicked, this, &RPCConsole::fontBigger);
     connect(ui->fontSmallerButton, &QPushButton::clicked, this, &RPCConsole::fontSmaller);
     connect(ui->btnClearTrafficGraph, &QPushButton::clicked, ui->trafficGraph, &TrafficGraphWidget::clear);
+    connect(ui->miningGraph, &MiningGraphWidget::statsChanged, this, &RPCConsole::updateMiningStats);
+
+    // Verium mines and Vericoin stakes, only show what applies
+    if (IsVericoin()) {
+        ui->labelMiningTitle->setText(tr("Staking"));
+        ui->labelMiningRate->setText(tr("Stake kernels tried"));
+    } else {
+        ui->labelStakeSearchInterval->hide();
+        ui->stakeSearchInterval->hide();
+        ui->labelStakeModifierAge->hide();
+        ui->stakeModifierAge->hide();
+        ui->labelExpectedStakeTime->hide();
+        ui->expectedStakeTime->hide();
+    }
 
     // disable the wallet selector by default
     ui->WalletSelector->setVisible(false);
@@ -569,6 +584,7 @@ void RPCConsole::setClientModel(ClientModel *model)
     }
 
     ui->trafficGraph->setClientModel(model);
+    ui->miningGraph->setClientModel(model);
     if (model && clientModel->getPeerTableModel() && clientModel->getBanTableModel()) {
         // Keep up to date with client
         setNumConnections(model->getNumConnections());
@@ -883,6 +899,28 @@ void RPCConsole::setMempoolSize(long numberOfTxs, size_t dynUsage)
         ui->mempoolSize->setText(QString::number(dynUsage/1000000.0, 'f', 2) + " MB");
 }
 
+void RPCConsole::updateMiningStats(const interfaces::MiningStats& stats, double rate)
+{
+    if (!IsVericoin()) {
+        ui->miningStatus->setText(stats.mining ? tr("Mining") : tr("Inactive"));
+        ui->miningRate->setText(tr("%1 hashes/min").arg(rate, 0, 'f', 0));
+        return;
+    }
+
+    ui->miningStatus->setText(stats.staking ? tr("Staking") : tr("Inactive"));
+    ui->miningRate->setText(tr("%1 per second").arg(rate, 0, 'f', 1));
+    ui->stakeSearchInterval->setText(stats.last_search_time ? GUIUtil::formatDurationStr(stats.search_interval) : tr("N/A"));
+    ui->stakeModifierAge->setText(stats.modifier_time ? GUIUtil::formatDurationStr(GetTime() - stats.modifier_time) : tr("N/A"));
+    // Each second the wallets try a share of the network's kernels equal to
+    // their share of the network's stake weight
+    if (stats.staking && stats.stake_weight > 0) {
+        double expected = stats.stake_target_spacing * stats.network_stake_weight / stats.stake_weight;
+        ui->expectedStakeTime->setText(GUIUtil::formatNiceTimeOffset((qint64)expected));
+    } else {
+        ui->expectedStakeTime->setText(tr("N/A"));
+    }
+}
+
 void RPCConsole::on_lineEdit_returnPressed()
 {
     QString cmd = ui->lineEdit->text();
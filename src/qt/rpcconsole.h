@@ -21,6 +21,7 @@ class WalletModel;
 
 namespace interfaces {
     class Node;
+    struct MiningStats;
 }
 
 namespace Ui {
@@ -83,6 +84,8 @@ private Q_SLOTS:
     void on_sldGraphRange_valueChanged(int value);
     /** update traffic statistics */
     void updateTrafficStats(quint64 totalBytesIn, quint64 totalBytesOut);
+    /** update mining and staking statistics */
+    void updateMiningStats(const interfaces::MiningStats& stats, double rate);
     void resizeEvent(QResizeEvent *event);
     void showEvent(QShowEvent *event);
     void hideEvent(QHideEvent *event);
@@ -555,6 +555,7 @@ void SendCoinsDialog::processSendCoinsReturn(const WalletModel::SendCoinsReturn
         msgParams.second = CClientUIInterface::MSG_ERROR;
         break;
     // included to prevent a compiler warning.
+    case WalletModel::TransactionCreationCancelled:
     case WalletModel::OK:
     default:
         return;
@@ -0,0 +1,103 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/test/wallettaskexecutortests.h>
+
+#include <qt/wallettaskexecutor.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include <QApplication>
+#include <QCoreApplication>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QSignalSpy>
+#include <QTimer>
+
+namespace
+{
+//! Number of times CancelProgress looks for the dialog, 10 ms apart
+const int CANCEL_PROGRESS_MAX_RETRIES = 1000;
+
+//! Press the "Cancel" button of the progress dialog once it is shown.
+void CancelProgress(int retries = 0)
+{
+    QTimer::singleShot(10, [retries]() {
+        for (QWidget* widget : QApplication::topLevelWidgets()) {
+            QProgressDialog* dialog = qobject_cast<QProgressDialog*>(widget);
+            if (dialog && dialog->isVisible()) {
+                dialog->findChild<QPushButton*>()->click();
+                return;
+            }
+        }
+        if (retries < CANCEL_PROGRESS_MAX_RETRIES) {
+            CancelProgress(retries + 1);
+        } else {
+            QFAIL("Progress dialog not shown");
+        }
+    });
+}
+} // namespace
+
+void WalletTaskExecutorTests::rethrowTests()
+{
+    WalletTaskExecutor executor;
+    QSignalSpy idle(&executor, &WalletTaskExecutor::idle);
+    bool thrown = false;
+    try {
+        executor.run(nullptr, QString(), [] { throw std::runtime_error("task failed"); });
+    } catch (const std::runtime_error& e) {
+        thrown = true;
+        QCOMPARE(QString(e.what()), QString("task failed"));
+    }
+    QVERIFY(thrown);
+    QVERIFY(!executor.isBusy());
+    QCOMPARE(idle.count(), 1);
+}
+
+void WalletTaskExecutorTests::cancelTests()
+{
+    WalletTaskExecutor executor;
+    QSignalSpy idle(&executor, &WalletTaskExecutor::idle);
+    // The task outlives run() once cancelled, so it only uses shared state.
+    std::shared_ptr<std::atomic<bool>> release = std::make_shared<std::atomic<bool>>(false);
+    std::shared_ptr<std::atomic<bool>> finished = std::make_shared<std::atomic<bool>>(false);
+    CancelProgress();
+    const bool done = executor.run(nullptr, QString("Waiting..."), [release, finished] {
+        while (!*release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        *finished = true;
+    }, true /* cancellable */);
+    QVERIFY(!done);
+    QVERIFY(!*finished);
+    QVERIFY(!executor.isBusy());
+    QCOMPARE(idle.count(), 1);
+
+    // The cancelled task keeps running in the background
+    *release = true;
+    QTRY_VERIFY(*finished);
+}
+
+void WalletTaskExecutorTests::exitTests()
+{
+    // QCoreApplication::exit quits the event loop of run() too. A task that
+    // is not cancellable may use the caller's stack, so run() still waits.
+    WalletTaskExecutor executor;
+    int value = 0;
+    bool done = false;
+    QTimer::singleShot(0, [&executor, &value, &done] {
+        done = executor.run(nullptr, QString("Waiting..."), [&value] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            value = 1;
+        });
+    });
+    QTimer::singleShot(50, [] { QCoreApplication::exit(0); });
+    QCoreApplication::exec();
+    QVERIFY(done);
+    QCOMPARE(value, 1);
+    QVERIFY(!executor.isBusy());
+}
@@ -0,0 +1,21 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_QT_TEST_WALLETTASKEXECUTORTESTS_H
+#define BITCOIN_QT_TEST_WALLETTASKEXECUTORTESTS_H
+
+#include <QObject>
+#include <QTest>
+
+class WalletTaskExecutorTests : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void rethrowTests();
+    void cancelTests();
+    void exitTests();
+};
+
+#endif // BITCOIN_QT_TEST_WALLETTASKEXECUTORTESTS_H
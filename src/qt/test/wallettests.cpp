@@ -15,7 +15,9 @@
 #include <qt/sendcoinsentry.h>
 #include <qt/transactiontablemodel.h>
 #include <qt/transactionview.h>
+#include <qt/walletcontroller.h>
 #include <qt/walletmodel.h>
+#include <qt/wallettaskexecutor.h>
 #include <key_io.h>
 #include <test/util/setup_common.h>
 #include <validation.h>
@@ -32,6 +34,7 @@
 #include <QApplication>
 #include <QCheckBox>
 #include <QPushButton>
+#include <QSignalSpy>
 #include <QTimer>
 #include <QVBoxLayout>
 #include <QTextEdit>
@@ -40,10 +43,13 @@
 
 namespace
 {
+//! Number of times ConfirmSend looks for the dialog, 10 ms apart
+const int CONFIRM_SEND_MAX_RETRIES = 1000;
+
 //! Press "Yes" or "Cancel" buttons in modal send confirmation dialog.
-void ConfirmSend(QString* text = nullptr, bool cancel = false)
+void ConfirmSend(QString* text = nullptr, bool cancel = false, int retries = 0)
 {
-    QTimer::singleShot(0, [text, cancel]() {
+    QTimer::singleShot(retries ? 10 : 0, [text, cancel, retries]() {
         for (QWidget* widget : QApplication::topLevelWidgets()) {
             if (widget->inherits("SendConfirmationDialog")) {
                 SendConfirmationDialog* dialog = qobject_cast<SendConfirmationDialog*>(widget);
@@ -51,8 +57,15 @@ void ConfirmSend(QString* text = nullptr, bool cancel = false)
                 QAbstractButton* button = dialog->button(cancel ? QMessageBox::Cancel : QMessageBox::Yes);
                 button->setEnabled(true);
                 button->click();
+                return;
             }
         }
+        // The dialog is shown once the transaction has been created in the
+        // background, try again
+        if (retries >= CONFIRM_SEND_MAX_RETRIES) {
+            QFAIL("SendConfirmationDialog was not shown");
+        }
+        ConfirmSend(text, cancel, retries + 1);
     });
 }
 
@@ -87,6 +100,27 @@ QModelIndex FindTx(const QAbstractItemModel& model, const uint256& txid)
     return {};
 }
 
+//! Unloading a wallet while one of its operations runs removes the wallet
+//! model once the operation is done.
+void TestDeferredRemoval(interfaces::Node& node, const std::shared_ptr<CWallet>& wallet, const PlatformStyle* platform_style, OptionsModel& options_model)
+{
+    WalletController controller(node, platform_style, &options_model, nullptr);
+    AddWallet(wallet);
+    WalletModel* wallet_model = controller.getOrCreateWallet(interfaces::MakeWallet(wallet));
+    RemoveWallet(wallet);
+    QSignalSpy removed(&controller, &WalletController::walletRemoved);
+
+    // The unload handler is queued, so it runs inside the event loop of run()
+    Q_EMIT wallet_model->unload();
+    bool done = wallet_model->taskExecutor().run(nullptr, QString(), [] {});
+    QVERIFY(done);
+    QCOMPARE(removed.count(), 0);
+    QCOMPARE(controller.getOpenWallets().size(), size_t{1});
+
+    QTRY_COMPARE(removed.count(), 1);
+    QVERIFY(controller.getOpenWallets().empty());
+}
+
 //! Simple qt wallet tests.
 //
 // Test widgets can be debugged interactively calling show() on them and
@@ -224,6 +258,8 @@ void TestGUI(interfaces::Node& node)
     QPushButton* removeRequestButton = receiveCoinsDialog.findChild<QPushButton*>("removeRequestButton");
     removeRequestButton->click();
     QCOMPARE(requestTableModel->rowCount({}), currentRowCount-1);
+
+    TestDeferredRemoval(node, wallet, platformStyle.get(), optionsModel);
 }
 
 } // namespace
@@ -159,6 +159,9 @@ QList<TransactionRecord> TransactionRecord::decomposeTransaction(const interface
         }
     }
 
+    for (TransactionRecord& part : parts) {
+        part.order_pos = wtx.order_pos;
+    }
     return parts;
 }
 
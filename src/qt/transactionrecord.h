@@ -88,13 +88,13 @@ public:
     static const int RecommendedNumConfirmations = 6;
 
     TransactionRecord():
-            hash(), time(0), type(Other), address(""), debit(0), credit(0), idx(0)
+            hash(), time(0), type(Other), address(""), debit(0), credit(0), idx(0), order_pos(0)
     {
     }
 
     TransactionRecord(uint256 _hash, qint64 _time):
             hash(_hash), time(_time), type(Other), address(""), debit(0),
-            credit(0), idx(0)
+            credit(0), idx(0), order_pos(0)
     {
     }
 
@@ -102,7 +102,7 @@ public:
                 Type _type, const std::string &_address,
                 const CAmount& _debit, const CAmount& _credit):
             hash(_hash), time(_time), type(_type), address(_address), debit(_debit), credit(_credit),
-            idx(0)
+            idx(0), order_pos(0)
     {
     }
 
@@ -124,6 +124,9 @@ public:
     /** Subtransaction index, for sort key */
     int idx;
 
+    /** Position of the transaction in the wallet, records are loaded in this order */
+    int64_t order_pos;
+
     /** Status: can change with block chain update */
     TransactionStatus status;
 
@@ -18,6 +18,8 @@
 #include <uint256.h>
 
 #include <algorithm>
+#include <limits>
+#include <map>
 
 #include <QColor>
 #include <QDateTime>
@@ -36,23 +38,6 @@ static int column_alignments[] = {
         Qt::AlignRight|Qt::AlignVCenter /* amount */
     };
 
-// Comparison operator for sort/binary search of model tx list
-struct TxLessThan
-{
-    bool operator()(const TransactionRecord &a, const TransactionRecord &b) const
-    {
-        return a.hash < b.hash;
-    }
-    bool operator()(const TransactionRecord &a, const uint256 &b) const
-    {
-        return a.hash < b;
-    }
-    bool operator()(const uint256 &a, const TransactionRecord &b) const
-    {
-        return a < b.hash;
-    }
-};
-
 // Private implementation
 class TransactionTablePriv
 {
@@ -64,25 +49,55 @@ public:
 
     TransactionTableModel *parent;
 
-    /* Local cache of wallet.
-     * As it is in the same order as the CWallet, by definition
-     * this is sorted by sha256.
+    /* Local cache of the newest transactions of the wallet.
+     * Transactions are loaded on demand, a page at a time, newest first by
+     * their position in the wallet, so this is sorted by descending order_pos.
      */
     QList<TransactionRecord> cachedWallet;
+    /* Position in the wallet of each transaction in cachedWallet, to find its records by binary search */
+    std::map<uint256, int64_t> cachedOrderPos;
+
+    /* Position in the wallet of the oldest transaction loaded so far */
+    int64_t nextOrderPos{std::numeric_limits<int64_t>::max()};
+    /* Whether all transactions of the wallet are loaded */
+    bool fetchedAll{false};
+    /* Whether rows are being inserted by fetchMore */
+    bool fetching{false};
 
-    /* Query entire wallet anew from core.
+    /* Load and decompose the next count transactions of the wallet.
      */
-    void refreshWallet(interfaces::Wallet& wallet)
+    void fetchMore(interfaces::Wallet& wallet, size_t count)
     {
-        qDebug() << "TransactionTablePriv::refreshWallet";
-        cachedWallet.clear();
-        {
-            for (const auto& wtx : wallet.getWalletTxs()) {
-                if (TransactionRecord::showTransaction()) {
-                    cachedWallet.append(TransactionRecord::decomposeTransaction(wtx));
-                }
+        if (fetchedAll) return;
+        const std::vector<interfaces::WalletTx> wtxs = wallet.getWalletTxsBefore(nextOrderPos, count);
+        qDebug() << "TransactionTablePriv::fetchMore: " + QString::number(wtxs.size()) + " transactions";
+        if (wtxs.size() < count) fetchedAll = true;
+        if (wtxs.empty()) return;
+        nextOrderPos = wtxs.back().order_pos;
+
+        QList<TransactionRecord> toInsert;
+        for (const auto& wtx : wtxs) {
+            if (TransactionRecord::showTransaction()) {
+                toInsert.append(TransactionRecord::decomposeTransaction(wtx));
             }
         }
+        if (toInsert.isEmpty()) return;
+
+        fetching = true;
+        parent->beginInsertRows(QModelIndex(), cachedWallet.size(), cachedWallet.size() + toInsert.size() - 1);
+        for (const TransactionRecord& rec : toInsert) {
+            cachedOrderPos[rec.hash] = rec.order_pos;
+        }
+        cachedWallet.append(toInsert);
+        parent->endInsertRows();
+        fetching = false;
+    }
+
+    /* First record in the model of the transaction at order_pos, or of the one after it if it is not in the model */
+    QList<TransactionRecord>::iterator lowerBound(int64_t order_pos)
+    {
+        return std::lower_bound(cachedWallet.begin(), cachedWallet.end(), order_pos,
+            [](const TransactionRecord& rec, int64_t pos) { return rec.order_pos > pos; });
     }
 
     /* Update our model of the wallet incrementally, to synchronize our model of the wallet
@@ -94,11 +109,15 @@ public:
     {
         qDebug() << "TransactionTablePriv::updateWallet: " + QString::fromStdString(hash.ToString()) + " " + QString::number(status);
 
-        // Find bounds of this transaction in model
-        QList<TransactionRecord>::iterator lower = std::lower_bound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
-        QList<TransactionRecord>::iterator upper = std::upper_bound(
-            cachedWallet.begin(), cachedWallet.end(), hash, TxLessThan());
+        // Find bounds of this transaction in model, its records are adjacent
+        QList<TransactionRecord>::iterator lower = cachedWallet.end();
+        QList<TransactionRecord>::iterator upper = cachedWallet.end();
+        const auto cached_pos = cachedOrderPos.find(hash);
+        if (cached_pos != cachedOrderPos.end()) {
+            lower = lowerBound(cached_pos->second);
+            upper = std::upper_bound(lower, cachedWallet.end(), cached_pos->second,
+                [](int64_t pos, const TransactionRecord& rec) { return pos > rec.order_pos; });
+        }
         int lowerIndex = (lower - cachedWallet.begin());
         int upperIndex = (upper - cachedWallet.begin());
         bool inModel = (lower != upper);
@@ -132,11 +151,15 @@ public:
                     qWarning() << "TransactionTablePriv::updateWallet: Warning: Got CT_NEW, but transaction is not in wallet";
                     break;
                 }
+                // Transactions older than the loaded ones are added by fetchMore
+                if (!fetchedAll && wtx.order_pos < nextOrderPos) break;
                 // Added -- insert at the right position
                 QList<TransactionRecord> toInsert =
                         TransactionRecord::decomposeTransaction(wtx);
                 if(!toInsert.isEmpty()) /* only if something to insert */
                 {
+                    lowerIndex = lowerBound(wtx.order_pos) - cachedWallet.begin();
+                    cachedOrderPos[hash] = wtx.order_pos;
                     parent->beginInsertRows(QModelIndex(), lowerIndex, lowerIndex+toInsert.size()-1);
                     int insert_idx = lowerIndex;
                     for (const TransactionRecord &rec : toInsert)
@@ -157,6 +180,7 @@ public:
             // Removed -- remove entire transaction from table
             parent->beginRemoveRows(QModelIndex(), lowerIndex, upperIndex-1);
             cachedWallet.erase(lower, upper);
+            cachedOrderPos.erase(cached_pos);
             parent->endRemoveRows();
             break;
         case CT_UPDATED:
@@ -175,12 +199,18 @@ public:
         return cachedWallet.size();
     }
 
-    TransactionRecord *index(interfaces::Wallet& wallet, int idx)
+    TransactionRecord *index(interfaces::Wallet& wallet, const int cur_num_blocks, int idx)
     {
         if(idx >= 0 && idx < cachedWallet.size())
         {
             TransactionRecord *rec = &cachedWallet[idx];
 
+            // Only query the wallet if blocks came in or the transaction
+            // changed since the status was last updated.
+            if (!rec->statusUpdateNeeded(cur_num_blocks)) {
+                return rec;
+            }
+
             // Get required locks upfront. This avoids the GUI from getting
             // stuck if the core is holding the locks for a longer time - for
             // example, during a wallet rescan.
@@ -223,7 +253,7 @@ TransactionTableModel::TransactionTableModel(const PlatformStyle *_platformStyle
         platformStyle(_platformStyle)
 {
     columns << QString() << QString() << tr("Date") << tr("Type") << tr("Label") << BitcoinUnits::getAmountColumnTitle(walletModel->getOptionsModel()->getDisplayUnit());
-    priv->refreshWallet(walletModel->wallet());
+    priv->fetchMore(walletModel->wallet(), TX_FETCH_BATCH_SIZE);
 
     connect(walletModel->getOptionsModel(), &OptionsModel::displayUnitChanged, this, &TransactionTableModel::updateDisplayUnit);
 
@@ -251,6 +281,22 @@ void TransactionTableModel::updateTransaction(const QString &hash, int status, b
     priv->updateWallet(walletModel->wallet(), updated, status, showTransaction);
 }
 
+bool TransactionTableModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && !priv->fetchedAll;
+}
+
+void TransactionTableModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid()) return;
+    priv->fetchMore(walletModel->wallet(), TX_FETCH_BATCH_SIZE);
+}
+
+bool TransactionTableModel::fetchingMore() const
+{
+    return priv->fetching;
+}
+
 void TransactionTableModel::updateConfirmations()
 {
     // Blocks came in since last poll.
@@ -663,10 +709,10 @@ QVariant TransactionTableModel::headerData(int section, Qt::Orientation orientat
 QModelIndex TransactionTableModel::index(int row, int column, const QModelIndex &parent) const
 {
     Q_UNUSED(parent);
-    TransactionRecord *data = priv->index(walletModel->wallet(), row);
+    TransactionRecord *data = priv->index(walletModel->wallet(), walletModel->getNumBlocks(), row);
     if(data)
     {
-        return createIndex(row, column, priv->index(walletModel->wallet(), row));
+        return createIndex(row, column, data);
     }
     return QModelIndex();
 }
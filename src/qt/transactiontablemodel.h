@@ -81,7 +81,12 @@ public:
     QVariant data(const QModelIndex &index, int role) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
     QModelIndex index(int row, int column, const QModelIndex & parent = QModelIndex()) const;
+    /* Transactions are loaded TX_FETCH_BATCH_SIZE at a time, newest first, as views scroll to them */
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
     bool processingQueuedTransactions() const { return fProcessingQueuedTransactions; }
+    /* Whether the rows being inserted are older transactions loaded by fetchMore */
+    bool fetchingMore() const;
 
 private:
     WalletModel *walletModel;
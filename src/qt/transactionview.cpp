@@ -355,6 +355,12 @@ void TransactionView::exportClicked()
     if (filename.isNull())
         return;
 
+    // Export the whole history, not only the transactions loaded so far
+    TransactionTableModel* ttm = model->getTransactionTableModel();
+    while (ttm->canFetchMore(QModelIndex())) {
+        ttm->fetchMore(QModelIndex());
+    }
+
     CSVModelWriter writer(filename);
 
     // name, column, role
@@ -9,6 +9,7 @@
 #include <qt/guiconstants.h>
 #include <qt/guiutil.h>
 #include <qt/walletmodel.h>
+#include <qt/wallettaskexecutor.h>
 
 #include <interfaces/handler.h>
 #include <interfaces/node.h>
@@ -110,21 +111,25 @@ WalletModel* WalletController::getOrCreateWallet(std::unique_ptr<interfaces::Wal
     wallet_model->setParent(this);
     m_wallets.push_back(wallet_model);
 
-    // WalletModel::startPollBalance needs to be called in a thread managed by
+    // WalletModel::startBalanceUpdates needs to be called in a thread managed by
     // Qt because of startTimer. Considering the current thread can be a RPC
     // thread, better delegate the calling to Qt with Qt::AutoConnection.
-    const bool called = QMetaObject::invokeMethod(wallet_model, "startPollBalance");
+    const bool called = QMetaObject::invokeMethod(wallet_model, "startBalanceUpdates");
     assert(called);
 
     connect(wallet_model, &WalletModel::unload, this, [this, wallet_model] {
-        // Defer removeAndDeleteWallet when no modal widget is active.
+        // Defer removeAndDeleteWallet when no modal widget is active and no
+        // wallet operation is running.
         // TODO: remove this workaround by removing usage of QDiallog::exec.
-        if (QApplication::activeModalWidget()) {
-            connect(qApp, &QApplication::focusWindowChanged, wallet_model, [this, wallet_model]() {
-                if (!QApplication::activeModalWidget()) {
+        if (QApplication::activeModalWidget() || wallet_model->taskExecutor().isBusy()) {
+            auto retry = [this, wallet_model] {
+                if (!QApplication::activeModalWidget() && !wallet_model->taskExecutor().isBusy()) {
                     removeAndDeleteWallet(wallet_model);
                 }
-            }, Qt::QueuedConnection);
+            };
+            connect(qApp, &QApplication::focusWindowChanged, wallet_model, retry, Qt::QueuedConnection);
+            // A wallet operation can end without the focus changing
+            connect(&wallet_model->taskExecutor(), &WalletTaskExecutor::idle, wallet_model, retry, Qt::QueuedConnection);
         } else {
             removeAndDeleteWallet(wallet_model);
         }
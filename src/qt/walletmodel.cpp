@@ -16,6 +16,7 @@
 #include <qt/recentrequeststablemodel.h>
 #include <qt/sendcoinsdialog.h>
 #include <qt/transactiontablemodel.h>
+#include <qt/wallettaskexecutor.h>
 
 #include <interfaces/handler.h>
 #include <interfaces/node.h>
@@ -34,13 +35,14 @@
 
 
 WalletModel::WalletModel(std::unique_ptr<interfaces::Wallet> wallet, interfaces::Node& node, const PlatformStyle *platformStyle, OptionsModel *_optionsModel, QObject *parent) :
-    QObject(parent), m_wallet(std::move(wallet)), m_node(node), optionsModel(_optionsModel), addressTableModel(nullptr),
+    QObject(parent), m_wallet(std::move(wallet)), m_node(node), m_task_executor(new WalletTaskExecutor(this)), optionsModel(_optionsModel), addressTableModel(nullptr),
     transactionTableModel(nullptr),
     recentRequestsTableModel(nullptr),
     cachedEncryptionStatus(Unencrypted),
     cachedNumBlocks(0)
 {
     fHaveWatchOnly = m_wallet->haveWatchOnly();
+    m_tip_height = m_node.getNumBlocks();
     addressTableModel = new AddressTableModel(this);
     transactionTableModel = new TransactionTableModel(platformStyle, this);
     recentRequestsTableModel = new RecentRequestsTableModel(this);
@@ -51,14 +53,26 @@ WalletModel::WalletModel(std::unique_ptr<interfaces::Wallet> wallet, interfaces:
 WalletModel::~WalletModel()
 {
     unsubscribeFromCoreSignals();
+    // Wait for the wallet operations still running before the wallet is released
+    delete m_task_executor;
 }
 
-void WalletModel::startPollBalance()
+void WalletModel::startBalanceUpdates()
 {
-    // This timer will be fired repeatedly to update the balance
-    QTimer* timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, &WalletModel::pollBalanceChanged);
-    timer->start(MODEL_UPDATE_DELAY);
+    // This timer is started by transaction and block tip notifications, so
+    // that bursts of them are coalesced into a single balance update
+    m_balance_timer = new QTimer(this);
+    m_balance_timer->setSingleShot(true);
+    m_balance_timer->setInterval(MODEL_UPDATE_DELAY);
+    connect(m_balance_timer, &QTimer::timeout, this, &WalletModel::pollBalanceChanged);
+    m_balance_timer->start();
+}
+
+void WalletModel::scheduleBalanceUpdate()
+{
+    if (m_balance_timer && !m_balance_timer->isActive()) {
+        m_balance_timer->start();
+    }
 }
 
 void WalletModel::updateStatus()
@@ -79,6 +93,10 @@ void WalletModel::pollBalanceChanged()
     interfaces::WalletBalances new_balances;
     int numBlocks = -1;
     if (!m_wallet->tryGetBalances(new_balances, numBlocks, fForceCheckBalanceChanged, cachedNumBlocks)) {
+        // Try again later if the wallet is busy or has not caught up with the tip yet
+        if (fForceCheckBalanceChanged || cachedNumBlocks < m_tip_height) {
+            scheduleBalanceUpdate();
+        }
         return;
     }
 
@@ -86,6 +104,9 @@ void WalletModel::pollBalanceChanged()
 
     // Balance and number of transactions might have changed
     cachedNumBlocks = numBlocks;
+    if (cachedNumBlocks < m_tip_height) {
+        scheduleBalanceUpdate();
+    }
 
     checkBalanceChanged(new_balances);
     if(transactionTableModel)
@@ -104,6 +125,14 @@ void WalletModel::updateTransaction()
 {
     // Balance and number of transactions might have changed
     fForceCheckBalanceChanged = true;
+    scheduleBalanceUpdate();
+}
+
+void WalletModel::updateTip(int height)
+{
+    // Confirmations and the maturity of coinbases and coinstakes might have changed
+    m_tip_height = height;
+    scheduleBalanceUpdate();
 }
 
 void WalletModel::updateAddressBook(const QString &address, const QString &label,
@@ -168,7 +197,27 @@ WalletModel::SendCoinsReturn WalletModel::prepareTransaction(WalletModelTransact
         return DuplicateAddress;
     }
 
-    CAmount nBalance = m_wallet->getAvailableBalance(coinControl);
+    // Selecting the coins waits for cs_main, so it runs in the background. The
+    // task works on copies, as it is left running if the user cancels.
+    struct Prepared
+    {
+        CAmount balance{0};
+        CTransactionRef tx;
+        int change_pos{-1};
+        CAmount fee{0};
+        std::string fail_reason;
+    };
+    std::shared_ptr<Prepared> prepared = std::make_shared<Prepared>();
+    const bool sign = !wallet().privateKeysDisabled();
+    if (!m_task_executor->run(nullptr, tr("Creating transaction..."), [this, prepared, vecSend, coinControl, total, sign] {
+        prepared->balance = m_wallet->getAvailableBalance(coinControl);
+        if (total > prepared->balance) return;
+        prepared->tx = m_wallet->createTransaction(vecSend, coinControl, sign, prepared->change_pos, prepared->fee, prepared->fail_reason);
+    }, true /* cancellable */)) {
+        return TransactionCreationCancelled;
+    }
+
+    CAmount nBalance = prepared->balance;
 
     if(total > nBalance)
     {
@@ -176,12 +225,12 @@ WalletModel::SendCoinsReturn WalletModel::prepareTransaction(WalletModelTransact
     }
 
     {
-        CAmount nFeeRequired = 0;
-        int nChangePosRet = -1;
-        std::string strFailReason;
+        CAmount nFeeRequired = prepared->fee;
+        int nChangePosRet = prepared->change_pos;
+        std::string strFailReason = prepared->fail_reason;
 
         auto& newTx = transaction.getWtx();
-        newTx = m_wallet->createTransaction(vecSend, coinControl, !wallet().privateKeysDisabled() /* sign */, nChangePosRet, nFeeRequired, strFailReason);
+        newTx = prepared->tx;
         transaction.setTransactionFee(nFeeRequired);
         if (fSubtractFeeFromAmount && newTx)
             transaction.reassignAmounts(nChangePosRet);
@@ -221,7 +270,9 @@ WalletModel::SendCoinsReturn WalletModel::sendCoins(WalletModelTransaction &tran
         }
 
         auto& newTx = transaction.getWtx();
-        wallet().commitTransaction(newTx, {} /* mapValue */, std::move(vOrderForm));
+        m_task_executor->run(nullptr, tr("Sending transaction..."), [this, &newTx, &vOrderForm] {
+            wallet().commitTransaction(newTx, {} /* mapValue */, std::move(vOrderForm));
+        });
 
         CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
         ssTx << *newTx;
@@ -299,7 +350,11 @@ bool WalletModel::setWalletEncrypted(bool encrypted, const SecureString &passphr
     if(encrypted)
     {
         // Encrypt
-        return m_wallet->encryptWallet(passphrase);
+        bool encrypted = false;
+        m_task_executor->run(nullptr, tr("Encrypting wallet..."), [this, &passphrase, &encrypted] {
+            encrypted = m_wallet->encryptWallet(passphrase);
+        });
+        return encrypted;
     }
     else
     {
@@ -318,14 +373,32 @@ bool WalletModel::setWalletLocked(bool locked, const SecureString &passPhrase)
     else
     {
         // Unlock
-        return m_wallet->unlock(passPhrase);
+        bool unlocked = false;
+        m_task_executor->run(nullptr, tr("Unlocking wallet..."), [this, &passPhrase, &unlocked] {
+            unlocked = m_wallet->unlock(passPhrase);
+        });
+        return unlocked;
     }
 }
 
 bool WalletModel::changePassphrase(const SecureString &oldPass, const SecureString &newPass)
 {
-    m_wallet->lock(); // Make sure wallet is locked before attempting pass change
-    return m_wallet->changeWalletPassphrase(oldPass, newPass);
+    bool changed = false;
+    m_task_executor->run(nullptr, tr("Changing passphrase..."), [this, &oldPass, &newPass, &changed] {
+        m_wallet->lock(); // Make sure wallet is locked before attempting pass change
+        changed = m_wallet->changeWalletPassphrase(oldPass, newPass);
+    });
+    return changed;
+}
+
+bool WalletModel::backupWallet(const QString &filename)
+{
+    const std::string path = filename.toLocal8Bit().data();
+    bool backed_up = false;
+    m_task_executor->run(nullptr, tr("Backing up wallet..."), [this, &path, &backed_up] {
+        backed_up = m_wallet->backupWallet(path);
+    });
+    return backed_up;
 }
 
 // Handlers for core signals
@@ -391,6 +464,13 @@ static void NotifyCanGetAddressesChanged(WalletModel* walletmodel)
     assert(invoked);
 }
 
+static void NotifyBlockTip(WalletModel* walletmodel, int height)
+{
+    bool invoked = QMetaObject::invokeMethod(walletmodel, "updateTip", Qt::QueuedConnection,
+                              Q_ARG(int, height));
+    assert(invoked);
+}
+
 void WalletModel::subscribeToCoreSignals()
 {
     // Connect signals to wallet
@@ -401,6 +481,7 @@ void WalletModel::subscribeToCoreSignals()
     m_handler_show_progress = m_wallet->handleShowProgress(std::bind(ShowProgress, this, std::placeholders::_1, std::placeholders::_2));
     m_handler_watch_only_changed = m_wallet->handleWatchOnlyChanged(std::bind(NotifyWatchonlyChanged, this, std::placeholders::_1));
     m_handler_can_get_addrs_changed = m_wallet->handleCanGetAddressesChanged(boost::bind(NotifyCanGetAddressesChanged, this));
+    m_handler_notify_block_tip = m_node.handleNotifyBlockTip(std::bind(NotifyBlockTip, this, std::placeholders::_2));
 }
 
 void WalletModel::unsubscribeFromCoreSignals()
@@ -413,6 +494,7 @@ void WalletModel::unsubscribeFromCoreSignals()
     m_handler_show_progress->disconnect();
     m_handler_watch_only_changed->disconnect();
     m_handler_can_get_addrs_changed->disconnect();
+    m_handler_notify_block_tip->disconnect();
 }
 
 // WalletModel::UnlockContext implementation
@@ -30,6 +30,7 @@ class RecentRequestsTableModel;
 class SendCoinsRecipient;
 class TransactionTableModel;
 class WalletModelTransaction;
+class WalletTaskExecutor;
 
 class CCoinControl;
 class CKeyID;
@@ -65,7 +66,8 @@ public:
         DuplicateAddress,
         TransactionCreationFailed, // Error returned when wallet is still locked
         AbsurdFee,
-        PaymentRequestExpired
+        PaymentRequestExpired,
+        TransactionCreationCancelled
     };
 
     enum EncryptionStatus
@@ -109,6 +111,8 @@ public:
     bool setWalletLocked(bool locked, const SecureString &passPhrase=SecureString());
     bool changePassphrase(const SecureString &oldPass, const SecureString &newPass);
 
+    bool backupWallet(const QString &filename);
+
     // RAI object for unlocking wallet, returned by requestUnlock()
     class UnlockContext
     {
@@ -141,6 +145,8 @@ public:
 
     interfaces::Node& node() const { return m_node; }
     interfaces::Wallet& wallet() const { return *m_wallet; }
+    //! Runs the wallet operations of the GUI that may wait for the node's locks
+    WalletTaskExecutor& taskExecutor() const { return *m_task_executor; }
 
     QString getWalletName() const;
     QString getDisplayName() const;
@@ -148,6 +154,9 @@ public:
     bool isMultiwallet();
 
     AddressTableModel* getAddressTableModel() const { return addressTableModel; }
+
+    //! Height of the block tip, as last notified by the node
+    int getNumBlocks() const { return m_tip_height; }
 private:
     std::unique_ptr<interfaces::Wallet> m_wallet;
     std::unique_ptr<interfaces::Handler> m_handler_unload;
@@ -157,10 +166,16 @@ private:
     std::unique_ptr<interfaces::Handler> m_handler_show_progress;
     std::unique_ptr<interfaces::Handler> m_handler_watch_only_changed;
     std::unique_ptr<interfaces::Handler> m_handler_can_get_addrs_changed;
+    std::unique_ptr<interfaces::Handler> m_handler_notify_block_tip;
     interfaces::Node& m_node;
+    WalletTaskExecutor* const m_task_executor;
 
     bool fHaveWatchOnly;
     bool fForceCheckBalanceChanged{false};
+    //! Single shot timer coalescing the notifications that might change the balance
+    QTimer* m_balance_timer{nullptr};
+    //! Height of the last block tip notified by the node
+    int m_tip_height{0};
 
     // Wallet has an options model for wallet-specific options
     // (transaction fee, for example)
@@ -178,6 +193,7 @@ private:
     void subscribeToCoreSignals();
     void unsubscribeFromCoreSignals();
     void checkBalanceChanged(const interfaces::WalletBalances& new_balances);
+    void scheduleBalanceUpdate();
 
 Q_SIGNALS:
     // Signal that balance in wallet changed
@@ -210,13 +226,15 @@ Q_SIGNALS:
     void canGetAddressesChanged();
 
 public Q_SLOTS:
-    /* Starts a timer to periodically update the balance */
-    void startPollBalance();
+    /* Sets up the timer updating the balance on change notifications, and updates it once */
+    void startBalanceUpdates();
 
     /* Wallet status might have changed */
     void updateStatus();
     /* New transaction, or transaction changed status */
     void updateTransaction();
+    /* New block tip */
+    void updateTip(int height);
     /* New, updated or removed address book entry */
     void updateAddressBook(const QString &address, const QString &label, bool isMine, const QString &purpose, int status);
     /* Watch-only added */
@@ -0,0 +1,129 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/wallettaskexecutor.h>
+
+#include <qt/guiconstants.h>
+#include <qt/guiutil.h>
+#include <sync.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+
+#include <QEventLoop>
+#include <QProgressDialog>
+#include <QThread>
+#include <QTimer>
+
+namespace {
+struct TaskState
+{
+    //! Set by the GUI thread when the task was cancelled, read by the worker
+    std::atomic<bool> cancelled{false};
+    Mutex mutex;
+    std::condition_variable finished_cv;
+    //! Set by the worker once the task has run
+    bool finished GUARDED_BY(mutex){false};
+    std::exception_ptr error GUARDED_BY(mutex);
+    //! Only accessed from the GUI thread
+    QEventLoop* loop{nullptr};
+
+    bool isFinished()
+    {
+        LOCK(mutex);
+        return finished;
+    }
+};
+} // namespace
+
+WalletTaskExecutor::WalletTaskExecutor(QObject *parent)
+    : QObject(parent)
+    , m_thread(new QThread(this))
+    , m_worker(new QObject)
+{
+    m_worker->moveToThread(m_thread);
+    m_thread->start();
+}
+
+WalletTaskExecutor::~WalletTaskExecutor()
+{
+    // Wait for a cancelled task that is still running, it may use the wallet.
+    // No run() is waiting here, so tasks that have not started were
+    // cancelled and are dropped with the worker.
+    m_thread->quit();
+    m_thread->wait();
+    delete m_worker;
+}
+
+bool WalletTaskExecutor::run(QWidget *parent_widget, const QString& label_text, std::function<void()> task, bool cancellable)
+{
+    std::shared_ptr<TaskState> state = std::make_shared<TaskState>();
+
+    QTimer::singleShot(0, m_worker, [this, state, task] {
+        if (state->cancelled) return;
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        {
+            LOCK(state->mutex);
+            state->finished = true;
+            state->error = error;
+        }
+        state->finished_cv.notify_all();
+        QTimer::singleShot(0, this, [state] {
+            if (state->loop) state->loop->quit();
+        });
+    });
+
+    QEventLoop loop;
+    state->loop = &loop;
+    ++m_running;
+
+    // Repaint but hold back user input for a moment, so that quick tasks
+    // don't flash a progress dialog.
+    QTimer::singleShot(WALLET_TASK_PROGRESS_DELAY, &loop, &QEventLoop::quit);
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+
+    if (!state->isFinished()) {
+        QProgressDialog dialog(label_text, cancellable ? tr("Cancel") : QString(), 0, 0, parent_widget);
+        GUIUtil::PolishProgressDialog(&dialog);
+        dialog.setWindowModality(Qt::ApplicationModal);
+        dialog.setMinimumDuration(0);
+        dialog.setAutoClose(false);
+        dialog.setAutoReset(false);
+        if (cancellable) {
+            connect(&dialog, &QProgressDialog::canceled, &loop, [state, &loop] {
+                state->cancelled = true;
+                loop.quit();
+            });
+        }
+        dialog.show();
+        loop.exec();
+    }
+
+    bool finished;
+    std::exception_ptr error;
+    {
+        WAIT_LOCK(state->mutex, lock);
+        // The loop is also quit by QCoreApplication::exit. A task that is not
+        // cancellable may refer to the caller's state, so wait for it.
+        while (!cancellable && !state->finished) {
+            state->finished_cv.wait(lock);
+        }
+        finished = state->finished;
+        error = state->error;
+    }
+    if (!finished) state->cancelled = true;
+
+    state->loop = nullptr;
+    if (--m_running == 0) Q_EMIT idle();
+    if (!finished) return false;
+    if (error) std::rethrow_exception(error);
+    return true;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_QT_WALLETTASKEXECUTOR_H
+#define BITCOIN_QT_WALLETTASKEXECUTOR_H
+
+#include <functional>
+
+#include <QObject>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QThread;
+class QWidget;
+QT_END_NAMESPACE
+
+/** Runs wallet operations that may wait for the node's locks, like sending,
+    encrypting or backing up, in a worker thread of the wallet.
+
+    The caller keeps processing GUI events until the operation is done, so the
+    window stays responsive while validation or a flush holds cs_main. A
+    modal progress dialog is shown if the operation takes a while.
+ */
+class WalletTaskExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WalletTaskExecutor(QObject *parent = nullptr);
+    ~WalletTaskExecutor();
+
+    /** Run task in the worker thread and return once it is done. Exceptions
+        thrown by the task are rethrown here. A task that is not cancellable
+        may refer to the caller's state: run() waits for it even if the event
+        loop is quit from outside, and then returns true.
+
+        If cancellable, the progress dialog has a Cancel button. Cancelling,
+        or quitting the event loop, returns false right away: the task is
+        skipped if it has not started yet, otherwise it runs to completion in
+        the background, so it must not refer to the caller's state.
+     */
+    bool run(QWidget *parent_widget, const QString& label_text, std::function<void()> task, bool cancellable = false);
+
+    //! Whether run() is waiting for a task
+    bool isBusy() const { return m_running > 0; }
+
+Q_SIGNALS:
+    //! Emitted when run() returns and no other run() is waiting
+    void idle();
+
+private:
+    QThread* const m_thread;
+    QObject* const m_worker;
+    int m_running{0};
+};
+
+#endif // BITCOIN_QT_WALLETTASKEXECUTOR_H
@@ -3,17 +3,24 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#if defined(HAVE_CONFIG_H)
+#include <config/bitcoin-config.h>
+#endif
+
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <crypto/common.h>
 #include <httpserver.h>
 #include <index/txindex.h>
 #include <node/context.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
+#include <script/script.h>
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
@@ -26,7 +33,13 @@
 
 #include <univalue.h>
 
+#if ENABLE_ZMQ
+#include <zmq/zmqnotificationinterface.h>
+#include <zmq/zmqpublishnotifier.h>
+#endif
+
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const int32_t MAX_REST_BLOCKRANGE_COUNT = 10000; //allow a max of 10000 blocks to be streamed at once
 
 enum class RetFormat {
     UNDEF,
@@ -126,6 +139,12 @@ static std::string AvailableDataFormatsString()
     return formats;
 }
 
+/** Writer sending its output as chunks of the reply to req */
+static JSONStreamWriter ReplyStreamWriter(HTTPRequest* req)
+{
+    return JSONStreamWriter([req](const std::string& chunk) { return req->WriteReplyChunk(HTTP_OK, chunk); });
+}
+
 static bool CheckWarmup(HTTPRequest* req)
 {
     std::string statusmessage;
@@ -259,10 +278,10 @@ static bool rest_block(HTTPRequest* req,
     }
 
     case RetFormat::JSON: {
-        UniValue objBlock = blockToJSON(block, tip, pblockindex, showTxDetails);
-        std::string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        JSONStreamWriter writer = ReplyStreamWriter(req);
+        blockToJSONStream(writer, block, tip, pblockindex, showTxDetails);
+        req->WriteReply(HTTP_OK, writer.Finish() + "\n");
         return true;
     }
 
@@ -282,6 +301,84 @@ static bool rest_block_notxdetails(HTTPRequest* req, const std::string& strURIPa
     return rest_block(req, strURIPart, false);
 }
 
+/** Append data to out, prefixed with its length as 4 byte little endian integer */
+static void AppendSizedRecord(std::string& out, const std::vector<uint8_t>& data)
+{
+    unsigned char size[4];
+    WriteLE32(size, data.size());
+    out.append((const char*)size, sizeof(size));
+    out.append(data.begin(), data.end());
+}
+
+static bool rest_blockrange(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    const bool with_undo = path.size() == 3 && path[2] == "undo";
+    if (path.size() != 2 && !with_undo)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Use /rest/blockrange/<start>/<count>[/undo].bin");
+
+    int32_t start;
+    if (!ParseInt32(path[0], &start) || start < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + SanitizeString(path[0]));
+    int32_t count;
+    if (!ParseInt32(path[1], &count) || count < 1 || count > MAX_REST_BLOCKRANGE_COUNT)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + SanitizeString(path[1]));
+    if (rf != RetFormat::BINARY)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin)");
+
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
+        const CChain& active_chain = ::ChainActive();
+        if (start > active_chain.Height())
+            return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range");
+        const int32_t end = std::min(active_chain.Height(), start + count - 1);
+        blocks.reserve(end - start + 1);
+        for (int32_t height = start; height <= end; ++height) {
+            const CBlockIndex* pindex = active_chain[height];
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA) || (with_undo && pindex->pprev && !(pindex->nStatus & BLOCK_HAVE_UNDO)))
+                return RESTERR(req, HTTP_NOT_FOUND, strprintf("Block at height %d not available (pruned data)", height));
+            blocks.push_back(pindex);
+        }
+    }
+
+    // Blocks and undo data are sent as stored in the block files, without
+    // deserializing them. Writing a chunk blocks while the client is behind.
+    req->WriteHeader("Content-Type", "application/octet-stream");
+    req->WriteHeader("X-Block-Count", strprintf("%d", blocks.size()));
+    const CMessageHeader::MessageStartChars& message_start = Params().MessageStart();
+    std::string out;
+    std::vector<uint8_t> data;
+    for (const CBlockIndex* pindex : blocks) {
+        // A failed read here can only be a race with pruning; the client sees
+        // fewer records than announced.
+        if (!ReadRawBlockFromDisk(data, pindex, message_start))
+            break;
+        AppendSizedRecord(out, data);
+        if (with_undo) {
+            data.clear();
+            if (pindex->pprev && !ReadRawUndoFromDisk(data, pindex, message_start))
+                break;
+            AppendSizedRecord(out, data);
+        }
+        if (out.size() >= DEFAULT_JSON_STREAM_CHUNK_SIZE) {
+            if (!req->WriteReplyChunk(HTTP_OK, out)) {
+                out.clear();
+                break;
+            }
+            out.clear();
+        }
+    }
+    req->WriteReply(HTTP_OK, out);
+    return true;
+}
+
 // A bit of a hack - dependency on a function defined in rpc/blockchain.cpp
 UniValue getblockchaininfo(const JSONRPCRequest& request);
 
@@ -342,11 +439,10 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
 
     switch (rf) {
     case RetFormat::JSON: {
-        UniValue mempoolObject = MempoolToJSON(*mempool, true);
-
-        std::string strJSON = mempoolObject.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        JSONStreamWriter writer = ReplyStreamWriter(req);
+        MempoolToJSONStream(writer, *mempool);
+        req->WriteReply(HTTP_OK, writer.Finish() + "\n");
         return true;
     }
     default: {
@@ -643,6 +739,91 @@ static bool rest_blockhash_by_height(HTTPRequest* req,
     }
 }
 
+static bool rest_address_history(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 3)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Use /rest/addresshistory/<address>/<start_height>/<end_height>.json");
+
+    CScript script;
+    if (!ParseAddressOrScript(path[0], script))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address or script: " + SanitizeString(path[0]));
+    int32_t start_height;
+    int32_t end_height;
+    if (!ParseInt32(path[1], &start_height) || !ParseInt32(path[2], &end_height) || start_height < 0 || end_height < start_height)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height range: " + SanitizeString(path[1] + "/" + path[2]));
+    if (rf != RetFormat::JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+
+    UniValue result;
+    std::string error;
+    if (!AddressHistoryToJSON(script, start_height, end_height, result, error))
+        return RESTERR(req, HTTP_NOT_FOUND, error);
+
+    req->WriteHeader("Content-Type", "application/json");
+    req->WriteReply(HTTP_OK, result.write() + "\n");
+    return true;
+}
+
+#if ENABLE_ZMQ
+static bool rest_zmq_replay(HTTPRequest* req, const std::string& strURIPart)
+{
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    uint32_t start;
+    if (path.size() != 2 || !ParseUInt32(path[1], &start))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Use /rest/zmq/<topic>/<sequence>.<bin|json>");
+
+    std::vector<CZMQReplayMessage> messages;
+    bool available = false;
+    if (!g_zmq_notification_interface || !g_zmq_notification_interface->GetReplay(path[0], start, messages, available))
+        return RESTERR(req, HTTP_NOT_FOUND, "No replay for topic: " + SanitizeString(path[0]));
+    if (!available)
+        return RESTERR(req, HTTP_NOT_FOUND, strprintf("Messages from sequence %u are no longer kept", start));
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        // Each message is its LE32 sequence number, LE32 body length and body
+        std::string out;
+        unsigned char buf[sizeof(uint32_t)];
+        for (const CZMQReplayMessage& message : messages) {
+            WriteLE32(buf, message.sequence);
+            out.append((const char*)buf, sizeof(buf));
+            WriteLE32(buf, message.body.size());
+            out.append((const char*)buf, sizeof(buf));
+            out.append(message.body);
+        }
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, out);
+        return true;
+    }
+    case RetFormat::JSON: {
+        UniValue result(UniValue::VARR);
+        for (const CZMQReplayMessage& message : messages) {
+            UniValue entry(UniValue::VOBJ);
+            entry.pushKV("sequence", (int64_t)message.sequence);
+            entry.pushKV("hex", HexStr(message.body.begin(), message.body.end()));
+            result.push_back(entry);
+        }
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, result.write() + "\n");
+        return true;
+    }
+    default:
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .json)");
+    }
+}
+#endif // ENABLE_ZMQ
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -656,12 +837,23 @@ static const struct {
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/blockrange/", rest_blockrange},
+      {"/rest/addresshistory/", rest_address_history},
+#if ENABLE_ZMQ
+      {"/rest/zmq/", rest_zmq_replay},
+#endif
 };
 
+/** REST requests are cheap reads, except for block ranges */
+static HTTPPriority rest_priority(HTTPRequest* req, const std::string&)
+{
+    return req->GetURI().compare(0, 16, "/rest/blockrange") == 0 ? HTTPPriority::LOW : HTTPPriority::HIGH;
+}
+
 void StartREST()
 {
     for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
-        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler);
+        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler, rest_priority);
 }
 
 void InterruptREST()
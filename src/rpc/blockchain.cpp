@@ -14,7 +14,11 @@
 #include <core_io.h>
 #include <downloader.h>
 #include <hash.h>
+#include <index/addressindex.h>
 #include <index/blockfilterindex.h>
+#include <index/blockstatsindex.h>
+#include <index/spentindex.h>
+#include <key_io.h>
 #include <miner.h>
 #include <node/coinstats.h>
 #include <node/context.h>
@@ -23,6 +27,7 @@
 #include <policy/policy.h>
 #include <pow.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
@@ -43,6 +48,7 @@
 #include <univalue.h>
 
 #include <condition_variable>
+#include <limits>
 #include <memory>
 #include <mutex>
 
@@ -237,7 +243,16 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
+/** Transaction of a block, with its input values and fee when the spent index has them */
+static void BlockTxToUniv(const CTransaction& tx, UniValue& entry)
+{
+    CTxUndo txundo;
+    const bool have_prevouts = g_spent_index && g_spent_index->FindPrevouts(tx, txundo);
+    TxToUniv(tx, uint256(), entry, true, RPCSerializationFlags(), have_prevouts ? &txundo : nullptr);
+}
+
+/** Block description with the "tx" array left empty when include_txs is false */
+static UniValue blockToJSONImpl(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails, bool include_txs)
 {
     // Serialize passed information without accessing chain state of the active chain!
     AssertLockNotHeld(cs_main); // For performance reasons
@@ -257,10 +272,12 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
     UniValue txs(UniValue::VARR);
     for(const auto& tx : block.vtx)
     {
+        if (!include_txs)
+            break;
         if(txDetails)
         {
             UniValue objTx(UniValue::VOBJ);
-            TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags());
+            BlockTxToUniv(*tx, objTx);
             txs.push_back(objTx);
         }
         else
@@ -295,6 +312,41 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
     return result;
 }
 
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
+{
+    return blockToJSONImpl(block, tip, blockindex, txDetails, /* include_txs */ true);
+}
+
+void blockToJSONStream(JSONStreamWriter& writer, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
+{
+    const UniValue header = blockToJSONImpl(block, tip, blockindex, txDetails, /* include_txs */ false);
+    const std::vector<std::string>& keys = header.getKeys();
+    const std::vector<UniValue>& values = header.getValues();
+
+    writer.BeginObject();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] != "tx") {
+            writer.Pair(keys[i], values[i]);
+            continue;
+        }
+        // Only one transaction is rendered at a time
+        writer.Key("tx");
+        writer.BeginArray();
+        for (const auto& tx : block.vtx) {
+            if (writer.Failed()) break;
+            if (txDetails) {
+                UniValue objTx(UniValue::VOBJ);
+                BlockTxToUniv(*tx, objTx);
+                writer.Value(objTx);
+            } else {
+                writer.Value(tx->GetHash().GetHex());
+            }
+        }
+        writer.EndArray();
+    }
+    writer.EndObject();
+}
+
 static UniValue getblockcount(const JSONRPCRequest& request)
 {
             RPCHelpMan{"getblockcount",
@@ -529,7 +581,7 @@ static UniValue getdifficulty(const JSONRPCRequest& request)
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("proof-of-work",        GetDifficulty(NULL));
     obj.pushKV("proof-of-stake",       GetDifficulty(GetLastBlockIndex(::ChainActive().Tip(), true)));
-    obj.pushKV("search-interval",      (int)nLastCoinStakeSearchInterval);
+    obj.pushKV("search-interval",      (int)g_mining_metrics.search_interval);
 
     return obj;
 }
@@ -637,6 +689,35 @@ UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose)
     }
 }
 
+void MempoolToJSONStream(JSONStreamWriter& writer, const CTxMemPool& pool)
+{
+    std::vector<uint256> vtxid;
+    pool.queryHashes(vtxid);
+
+    writer.BeginObject();
+    for (size_t start = 0; start < vtxid.size() && !writer.Failed(); start += MEMPOOL_STREAM_BATCH_SIZE) {
+        const size_t end = std::min(vtxid.size(), start + MEMPOOL_STREAM_BATCH_SIZE);
+        std::vector<std::pair<std::string, UniValue>> batch;
+        batch.reserve(end - start);
+        {
+            // Don't hold the mempool lock while the output is being written,
+            // which may block on a slow client.
+            LOCK(pool.cs);
+            for (size_t i = start; i < end; ++i) {
+                const auto it = pool.mapTx.find(vtxid[i]);
+                if (it == pool.mapTx.end()) continue; // removed in the meantime
+                UniValue info(UniValue::VOBJ);
+                entryToJSON(pool, info, *it);
+                batch.emplace_back(vtxid[i].ToString(), std::move(info));
+            }
+        }
+        for (const auto& entry : batch) {
+            writer.Pair(entry.first, entry.second);
+        }
+    }
+    writer.EndObject();
+}
+
 static UniValue getrawmempool(const JSONRPCRequest& request)
 {
             RPCHelpMan{"getrawmempool",
@@ -1005,6 +1086,7 @@ static UniValue getblock(const JSONRPCRequest& request)
                         {RPCResult::Type::OBJ, "", "",
                         {
                             {RPCResult::Type::ELISION, "", "The transactions in the format of the getrawtransaction RPC. Different from verbosity = 1 \"tx\" result"},
+                            {RPCResult::Type::NUM, "fee", /* optional */ true, "The transaction fee in " + CURRENCY_UNIT + ", only present if -spentindex is enabled and the transaction is not a coinbase or coinstake"},
                         }},
                     }},
                     {RPCResult::Type::ELISION, "", "Same output as verbosity = 1"},
@@ -1586,37 +1668,84 @@ static UniValue getchaintxstats(const JSONRPCRequest& request)
     return ret;
 }
 
-template<typename T>
-static T CalculateTruncatedMedian(std::vector<T>& scores)
+/** The statistics of a block, from the block stats index if it has them */
+static BlockStats GetBlockStats(const CBlockIndex* pindex)
 {
-    size_t size = scores.size();
-    if (size == 0) {
-        return 0;
+    BlockStats stats;
+    if (g_block_stats_index && g_block_stats_index->LookupStats(pindex, stats)) {
+        return stats;
     }
+    // The genesis block has no undo data
+    return ComputeBlockStats(GetBlockChecked(pindex), pindex->nHeight > 0 ? GetUndoChecked(pindex) : CBlockUndo());
+}
 
-    std::sort(scores.begin(), scores.end());
-    if (size % 2 == 0) {
-        return (scores[size / 2 - 1] + scores[size / 2]) / 2;
-    } else {
-        return scores[size / 2];
+static std::set<std::string> ParseSelectedStats(const UniValue& param)
+{
+    std::set<std::string> stats;
+    if (!param.isNull()) {
+        const UniValue stats_univalue = param.get_array();
+        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
+            const std::string stat = stats_univalue[i].get_str();
+            stats.insert(stat);
+        }
     }
+    return stats;
 }
 
-template<typename T>
-static inline bool SetHasKeys(const std::set<T>& set) {return false;}
-template<typename T, typename Tk, typename... Args>
-static inline bool SetHasKeys(const std::set<T>& set, const Tk& key, const Args&... args)
+/** getblockstats result for a block, with only the selected statistics unless none are */
+static UniValue BlockStatsToJSON(const CBlockIndex* pindex, const BlockStats& stats, const std::set<std::string>& selected)
 {
-    return (set.count(key) != 0) || SetHasKeys(set, args...);
-}
+    UniValue ret_all(UniValue::VOBJ);
+    ret_all.pushKV("avgfee", stats.fee_txs > 0 ? stats.totalfee / stats.fee_txs : 0);
+    ret_all.pushKV("avgfeerate", stats.total_weight ? (stats.totalfee * WITNESS_SCALE_FACTOR) / stats.total_weight : 0); // Unit: sat/vbyte
+    ret_all.pushKV("avgtxsize", (stats.txs > 1) ? stats.total_size / (stats.txs - 1) : 0);
+    ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
+    ret_all.pushKV("height", (int64_t)pindex->nHeight);
+    ret_all.pushKV("ins", stats.ins);
+    ret_all.pushKV("maxfee", stats.maxfee);
+    ret_all.pushKV("maxfeerate", stats.maxfeerate);
+    ret_all.pushKV("maxtxsize", stats.maxtxsize);
+    ret_all.pushKV("medianfee", stats.medianfee);
+    ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
+    ret_all.pushKV("mediantxsize", stats.mediantxsize);
+    ret_all.pushKV("minfee", stats.minfee);
+    ret_all.pushKV("minfeerate", stats.minfeerate);
+    ret_all.pushKV("mintxsize", stats.mintxsize);
+    ret_all.pushKV("outs", stats.outs);
+    ret_all.pushKV("subsidy", GetProofOfWorkReward(0, pindex));
+    ret_all.pushKV("time", pindex->GetBlockTime());
+    ret_all.pushKV("total_out", stats.total_out);
+    ret_all.pushKV("total_size", stats.total_size);
+    ret_all.pushKV("total_weight", stats.total_weight);
+    ret_all.pushKV("totalfee", stats.totalfee);
+    ret_all.pushKV("txs", stats.txs);
+    ret_all.pushKV("utxo_increase", stats.outs - stats.ins);
+    ret_all.pushKV("utxo_size_inc", stats.utxo_size_inc);
+    ret_all.pushKV("stake_reward", stats.stake_reward);
+    ret_all.pushKV("coin_age", stats.coin_age);
+    ret_all.pushKV("kernel_difficulty", pindex->IsProofOfStake() ? GetDifficulty(pindex) : 0.0);
+
+    if (selected.empty()) {
+        return ret_all;
+    }
 
-// outpoint (needed for the utxo index) + nHeight + fCoinBase
-static constexpr size_t PER_UTXO_OVERHEAD = sizeof(COutPoint) + sizeof(uint32_t) + sizeof(bool);
+    UniValue ret(UniValue::VOBJ);
+    for (const std::string& stat : selected) {
+        const UniValue& value = ret_all[stat];
+        if (value.isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s", stat));
+        }
+        ret.pushKV(stat, value);
+    }
+    return ret;
+}
 
 static UniValue getblockstats(const JSONRPCRequest& request)
 {
     RPCHelpMan{"getblockstats",
-                "\nCompute per block statistics for a given window. All amounts are in satoshis.\n",
+                "\nCompute per block statistics for a given window. All amounts are in satoshis.\n"
+                "The statistics are read from the block stats index if enabled with -blockstatsindex.\n"
+                "Fee statistics leave out the coinstake of proof-of-stake blocks.\n",
                 {
                     {"hash_or_height", RPCArg::Type::NUM, RPCArg::Optional::NO, "The block hash or height of the target block", "", {"", "string or numeric"}},
                     {"stats", RPCArg::Type::ARR, /* default */ "all values", "Values to plot (see result below)",
@@ -1654,6 +1783,9 @@ static UniValue getblockstats(const JSONRPCRequest& request)
                 {RPCResult::Type::NUM, "txs", "The number of transactions (including coinbase)"},
                 {RPCResult::Type::NUM, "utxo_increase", "The increase/decrease in the number of unspent outputs"},
                 {RPCResult::Type::NUM, "utxo_size_inc", "The increase/decrease in size for the utxo index (not discounting op_return and similar)"},
+                {RPCResult::Type::NUM, "stake_reward", "The value created by the coinstake (proof-of-stake blocks)"},
+                {RPCResult::Type::NUM, "coin_age", "The coin age consumed by the coinstake in coin-days (proof-of-stake blocks)"},
+                {RPCResult::Type::NUM, "kernel_difficulty", "The difficulty of the stake kernel (proof-of-stake blocks)"},
             }},
                 RPCExamples{
                     HelpExampleCli("getblockstats", "1000 '[\"minfeerate\",\"avgfeerate\"]'")
@@ -1661,175 +1793,117 @@ static UniValue getblockstats(const JSONRPCRequest& request)
                 },
     }.Check(request);
 
-    LOCK(cs_main);
-
-    CBlockIndex* pindex;
-    if (request.params[0].isNum()) {
-        const int height = request.params[0].get_int();
-        const int current_tip = ::ChainActive().Height();
-        if (height < 0) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
-        }
-        if (height > current_tip) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
-        }
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        if (request.params[0].isNum()) {
+            const int height = request.params[0].get_int();
+            const int current_tip = ::ChainActive().Height();
+            if (height < 0) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
+            }
+            if (height > current_tip) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
+            }
 
-        pindex = ::ChainActive()[height];
-    } else {
-        const uint256 hash(ParseHashV(request.params[0], "hash_or_height"));
-        pindex = LookupBlockIndex(hash);
-        if (!pindex) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-        }
-        if (!::ChainActive().Contains(pindex)) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+            pindex = ::ChainActive()[height];
+        } else {
+            const uint256 hash(ParseHashV(request.params[0], "hash_or_height"));
+            pindex = LookupBlockIndex(hash);
+            if (!pindex) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+            }
+            if (!::ChainActive().Contains(pindex)) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+            }
         }
     }
 
     CHECK_NONFATAL(pindex != nullptr);
 
-    std::set<std::string> stats;
-    if (!request.params[1].isNull()) {
-        const UniValue stats_univalue = request.params[1].get_array();
-        for (unsigned int i = 0; i < stats_univalue.size(); i++) {
-            const std::string stat = stats_univalue[i].get_str();
-            stats.insert(stat);
-        }
-    }
-
-    const CBlock block = GetBlockChecked(pindex);
-    const CBlockUndo blockUndo = GetUndoChecked(pindex);
-
-    const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
-    const bool do_mediantxsize = do_all || stats.count("mediantxsize") != 0;
-    const bool do_medianfee = do_all || stats.count("medianfee") != 0;
-    const bool loop_inputs = do_all || do_medianfee ||
-        SetHasKeys(stats, "utxo_size_inc", "totalfee", "avgfee", "avgfeerate", "minfee", "maxfee", "minfeerate", "maxfeerate");
-    const bool loop_outputs = do_all || loop_inputs || stats.count("total_out");
-    const bool do_calculate_size = do_mediantxsize ||
-        SetHasKeys(stats, "total_size", "avgtxsize", "mintxsize", "maxtxsize");
-    const bool do_calculate_weight = do_all || SetHasKeys(stats, "total_weight", "avgfeerate", "avgfeerate", "minfeerate", "maxfeerate");
-
-    CAmount maxfee = 0;
-    CAmount maxfeerate = 0;
-    CAmount minfee = MAX_MONEY;
-    CAmount minfeerate = MAX_MONEY;
-    CAmount total_out = 0;
-    CAmount totalfee = 0;
-    int64_t inputs = 0;
-    int64_t maxtxsize = 0;
-    int64_t mintxsize = MAX_BLOCK_SERIALIZED_SIZE;
-    int64_t outputs = 0;
-    int64_t total_size = 0;
-    int64_t total_weight = 0;
-    int64_t utxo_size_inc = 0;
-    std::vector<CAmount> fee_array;
-    std::vector<std::pair<CAmount, int64_t>> feerate_array;
-    std::vector<int64_t> txsize_array;
-
-    for (size_t i = 0; i < block.vtx.size(); ++i) {
-        const auto& tx = block.vtx.at(i);
-        outputs += tx->vout.size();
-
-        CAmount tx_total_out = 0;
-        if (loop_outputs) {
-            for (const CTxOut& out : tx->vout) {
-                tx_total_out += out.nValue;
-                utxo_size_inc += GetSerializeSize(out, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
-            }
-        }
-
-        if (tx->IsCoinBase()) {
-            continue;
-        }
+    return BlockStatsToJSON(pindex, GetBlockStats(pindex), ParseSelectedStats(request.params[1]));
+}
 
-        inputs += tx->vin.size(); // Don't count coinbase's fake input
-        total_out += tx_total_out; // Don't count coinbase reward
+static UniValue getblockstatsrange(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getblockstatsrange",
+                "\nCompute per block statistics for a range of blocks in the active chain, like getblockstats.\n"
+                "The range is given by block heights, or by block times if by_time is true.\n"
+                "The statistics are read from the block stats index if enabled with -blockstatsindex.\n",
+                {
+                    {"start", RPCArg::Type::NUM, RPCArg::Optional::NO, "The height, or time expressed in " + UNIX_EPOCH_TIME + ", of the first block"},
+                    {"end", RPCArg::Type::NUM, RPCArg::Optional::NO, "The height, or time expressed in " + UNIX_EPOCH_TIME + ", of the last block"},
+                    {"stats", RPCArg::Type::ARR, /* default */ "all values", "Values to plot (see getblockstats)",
+                        {
+                            {"height", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
+                            {"time", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "Selected statistic"},
+                        },
+                        "stats"},
+                    {"by_time", RPCArg::Type::BOOL, /* default */ "false", "Whether start and end are block times instead of heights"},
+                },
+                RPCResult{
+                    RPCResult::Type::ARR, "", "",
+                    {
+                        {RPCResult::Type::OBJ, "", "",
+                        {
+                            {RPCResult::Type::ELISION, "", "The statistics of a block, in the format of the getblockstats RPC"},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getblockstatsrange", "1000 2000 '[\"height\",\"totalfee\"]'")
+            + HelpExampleCli("getblockstatsrange", "1590000000 1590086400 '[\"height\",\"totalfee\"]' true")
+            + HelpExampleRpc("getblockstatsrange", "1000, 2000, [\"height\",\"totalfee\"]")
+                },
+    }.Check(request);
 
-        int64_t tx_size = 0;
-        if (do_calculate_size) {
+    const int64_t start = request.params[0].get_int64();
+    const int64_t end = request.params[1].get_int64();
+    const bool by_time = !request.params[3].isNull() && request.params[3].get_bool();
+    if (start > end) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid range: start is after end");
+    }
+    const std::set<std::string> selected = ParseSelectedStats(request.params[2]);
 
-            tx_size = tx->GetTotalSize();
-            if (do_mediantxsize) {
-                txsize_array.push_back(tx_size);
+    UniValue result(UniValue::VARR);
+    int start_height;
+    const CBlockIndex* stop_index;
+    {
+        LOCK(cs_main);
+        const CChain& active_chain = ::ChainActive();
+        if (by_time) {
+            // Blocks are found by the maximum time of the chain up to them,
+            // which unlike block times never decreases
+            const CBlockIndex* first = active_chain.FindEarliestAtLeast(start, 0);
+            if (!first) return result;
+            const CBlockIndex* after = active_chain.FindEarliestAtLeast(end + 1, 0);
+            start_height = first->nHeight;
+            stop_index = after ? after->pprev : active_chain.Tip();
+            if (!stop_index || stop_index->nHeight < start_height) return result;
+        } else {
+            if (start < 0 || end > active_chain.Height()) {
+                throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block height out of range, the current tip is %d", active_chain.Height()));
             }
-            maxtxsize = std::max(maxtxsize, tx_size);
-            mintxsize = std::min(mintxsize, tx_size);
-            total_size += tx_size;
-        }
-
-        int64_t weight = 0;
-        if (do_calculate_weight) {
-            weight = GetTransactionWeight(*tx);
-            total_weight += weight;
+            start_height = start;
+            stop_index = active_chain[end];
         }
+    }
 
-        if (loop_inputs) {
-            CAmount tx_total_in = 0;
-            const auto& txundo = blockUndo.vtxundo.at(i - 1);
-            for (const Coin& coin: txundo.vprevout) {
-                const CTxOut& prevoutput = coin.out;
-
-                tx_total_in += prevoutput.nValue;
-                utxo_size_inc -= GetSerializeSize(prevoutput, PROTOCOL_VERSION) + PER_UTXO_OVERHEAD;
-            }
-
-            CAmount txfee = tx_total_in - tx_total_out;
-            CHECK_NONFATAL(MoneyRange(txfee));
-            if (do_medianfee) {
-                fee_array.push_back(txfee);
-            }
-            maxfee = std::max(maxfee, txfee);
-            minfee = std::min(minfee, txfee);
-            totalfee += txfee;
-
-            // New feerate uses satoshis per virtual byte instead of per serialized byte
-            CAmount feerate = weight ? (txfee * WITNESS_SCALE_FACTOR) / weight : 0;
-            maxfeerate = std::max(maxfeerate, feerate);
-            minfeerate = std::min(minfeerate, feerate);
-        }
+    const size_t num_blocks = stop_index->nHeight - start_height + 1;
+    if (num_blocks > MAX_BLOCK_STATS_RANGE) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Range of more than %u blocks, narrow it", MAX_BLOCK_STATS_RANGE));
     }
 
-    UniValue ret_all(UniValue::VOBJ);
-    ret_all.pushKV("avgfee", (block.vtx.size() > 1) ? totalfee / (block.vtx.size() - 1) : 0);
-    ret_all.pushKV("avgfeerate", total_weight ? (totalfee * WITNESS_SCALE_FACTOR) / total_weight : 0); // Unit: sat/vbyte
-    ret_all.pushKV("avgtxsize", (block.vtx.size() > 1) ? total_size / (block.vtx.size() - 1) : 0);
-    ret_all.pushKV("blockhash", pindex->GetBlockHash().GetHex());
-    ret_all.pushKV("height", (int64_t)pindex->nHeight);
-    ret_all.pushKV("ins", inputs);
-    ret_all.pushKV("maxfee", maxfee);
-    ret_all.pushKV("maxfeerate", maxfeerate);
-    ret_all.pushKV("maxtxsize", maxtxsize);
-    ret_all.pushKV("medianfee", CalculateTruncatedMedian(fee_array));
-    ret_all.pushKV("mediantime", pindex->GetMedianTimePast());
-    ret_all.pushKV("mediantxsize", CalculateTruncatedMedian(txsize_array));
-    ret_all.pushKV("minfee", (minfee == MAX_MONEY) ? 0 : minfee);
-    ret_all.pushKV("minfeerate", (minfeerate == MAX_MONEY) ? 0 : minfeerate);
-    ret_all.pushKV("mintxsize", mintxsize == MAX_BLOCK_SERIALIZED_SIZE ? 0 : mintxsize);
-    ret_all.pushKV("outs", outputs);
-    ret_all.pushKV("subsidy", GetProofOfWorkReward(0, pindex));
-    ret_all.pushKV("time", pindex->GetBlockTime());
-    ret_all.pushKV("total_out", total_out);
-    ret_all.pushKV("total_size", total_size);
-    ret_all.pushKV("total_weight", total_weight);
-    ret_all.pushKV("totalfee", totalfee);
-    ret_all.pushKV("txs", (int64_t)block.vtx.size());
-    ret_all.pushKV("utxo_increase", outputs - inputs);
-    ret_all.pushKV("utxo_size_inc", utxo_size_inc);
-
-    if (do_all) {
-        return ret_all;
+    std::vector<const CBlockIndex*> block_indexes(num_blocks);
+    for (const CBlockIndex* block_index = stop_index; block_index && block_index->nHeight >= start_height; block_index = block_index->pprev) {
+        block_indexes[block_index->nHeight - start_height] = block_index;
     }
 
-    UniValue ret(UniValue::VOBJ);
-    for (const std::string& stat : stats) {
-        const UniValue& value = ret_all[stat];
-        if (value.isNull()) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid selected statistic %s", stat));
-        }
-        ret.pushKV(stat, value);
+    std::vector<BlockStats> stats;
+    const bool indexed = g_block_stats_index && g_block_stats_index->LookupStatsRange(start_height, stop_index, stats);
+    for (size_t i = 0; i < num_blocks; ++i) {
+        result.push_back(BlockStatsToJSON(block_indexes[i], indexed ? stats[i] : GetBlockStats(block_indexes[i]), selected));
     }
-    return ret;
+    return result;
 }
 
 static UniValue savemempool(const JSONRPCRequest& request)
@@ -2143,6 +2217,299 @@ static UniValue getblockfilter(const JSONRPCRequest& request)
     return ret;
 }
 
+bool ParseAddressOrScript(const std::string& str, CScript& script)
+{
+    const CTxDestination dest = DecodeDestination(str);
+    if (IsValidDestination(dest)) {
+        script = GetScriptForDestination(dest);
+        return true;
+    }
+    if (!str.empty() && IsHex(str)) {
+        const std::vector<unsigned char> data(ParseHex(str));
+        script = CScript(data.begin(), data.end());
+        return true;
+    }
+    return false;
+}
+
+/** Check that the address index can be queried */
+static bool AddressIndexReady(std::string& error)
+{
+    if (!g_address_index) {
+        error = "Address index is not enabled, restart with -addressindex";
+        return false;
+    }
+    if (!g_address_index->BlockUntilSyncedToCurrentChain()) {
+        error = "Address index is still being built";
+        return false;
+    }
+    return true;
+}
+
+/** Look up the outputs and spends of a script in the address index */
+static bool FindAddressHistory(const CScript& script, int start_height, int end_height,
+                               std::vector<AddressOutput>& outputs, std::vector<AddressSpend>& spends, std::string& error)
+{
+    if (!AddressIndexReady(error)) {
+        return false;
+    }
+    const uint256 script_hash = AddressIndex::GetScriptHash(script);
+    // Ask for one more than allowed to tell a full result from a truncated one
+    if (!g_address_index->FindOutputs(script_hash, start_height, end_height, MAX_ADDRESS_HISTORY_RESULTS + 1, outputs) ||
+        !g_address_index->FindSpends(script_hash, start_height, end_height, MAX_ADDRESS_HISTORY_RESULTS + 1, spends)) {
+        error = "Unable to read address index";
+        return false;
+    }
+    if (outputs.size() > MAX_ADDRESS_HISTORY_RESULTS || spends.size() > MAX_ADDRESS_HISTORY_RESULTS) {
+        error = strprintf("More than %u results, narrow the height range", MAX_ADDRESS_HISTORY_RESULTS);
+        return false;
+    }
+    return true;
+}
+
+bool AddressHistoryToJSON(const CScript& script, int start_height, int end_height, UniValue& result, std::string& error)
+{
+    std::vector<AddressOutput> outputs;
+    std::vector<AddressSpend> spends;
+    if (!FindAddressHistory(script, start_height, end_height, outputs, spends, error)) {
+        return false;
+    }
+
+    UniValue outputs_json(UniValue::VARR);
+    for (const AddressOutput& output : outputs) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("height", output.height);
+        entry.pushKV("txid", output.outpoint.hash.GetHex());
+        entry.pushKV("vout", (int64_t)output.outpoint.n);
+        entry.pushKV("amount", ValueFromAmount(output.amount));
+        if (output.IsSpent()) {
+            UniValue spent(UniValue::VOBJ);
+            spent.pushKV("txid", output.spent_by.hash.GetHex());
+            spent.pushKV("vin", (int64_t)output.spent_by.n);
+            spent.pushKV("height", output.spent_height);
+            entry.pushKV("spent", spent);
+        }
+        outputs_json.push_back(entry);
+    }
+    UniValue spends_json(UniValue::VARR);
+    for (const AddressSpend& spend : spends) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("height", spend.height);
+        entry.pushKV("txid", spend.txid.GetHex());
+        entry.pushKV("vin", (int64_t)spend.vin);
+        entry.pushKV("amount", ValueFromAmount(spend.amount));
+        entry.pushKV("prevout_txid", spend.prevout.hash.GetHex());
+        entry.pushKV("prevout_vout", (int64_t)spend.prevout.n);
+        spends_json.push_back(entry);
+    }
+
+    result = UniValue(UniValue::VOBJ);
+    result.pushKV("outputs", outputs_json);
+    result.pushKV("spends", spends_json);
+    return true;
+}
+
+static UniValue getaddresshistory(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getaddresshistory",
+                "\nReturns the outputs paying to an address or script and the inputs spending from it, in order of height.\n"
+                "Requires -addressindex. Outputs are included by the height they were created at, spends by the height\n"
+                "they were made at. At most " + std::to_string(MAX_ADDRESS_HISTORY_RESULTS) + " of each are returned.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address or hex-encoded scriptPubKey"},
+                    {"start_height", RPCArg::Type::NUM, /* default */ "0", "The first height to include"},
+                    {"end_height", RPCArg::Type::NUM, /* default */ "the tip height", "The last height to include"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::ARR, "outputs", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::NUM, "height", "The height of the block containing the output"},
+                                {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                                {RPCResult::Type::NUM, "vout", "The output number"},
+                                {RPCResult::Type::STR_AMOUNT, "amount", "The output value in " + CURRENCY_UNIT},
+                                {RPCResult::Type::OBJ, "spent", /* optional */ true, "The input spending the output, if spent",
+                                {
+                                    {RPCResult::Type::STR_HEX, "txid", "The spending transaction id"},
+                                    {RPCResult::Type::NUM, "vin", "The input number"},
+                                    {RPCResult::Type::NUM, "height", "The height of the block containing the spend"},
+                                }},
+                            }},
+                        }},
+                        {RPCResult::Type::ARR, "spends", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::NUM, "height", "The height of the block containing the spend"},
+                                {RPCResult::Type::STR_HEX, "txid", "The spending transaction id"},
+                                {RPCResult::Type::NUM, "vin", "The input number"},
+                                {RPCResult::Type::STR_AMOUNT, "amount", "The value spent in " + CURRENCY_UNIT},
+                                {RPCResult::Type::STR_HEX, "prevout_txid", "The transaction id of the spent output"},
+                                {RPCResult::Type::NUM, "prevout_vout", "The output number of the spent output"},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\" 1000 2000") +
+                    HelpExampleRpc("getaddresshistory", "\"" + EXAMPLE_ADDRESS[0] + "\", 1000, 2000")
+                }
+            }.Check(request);
+
+    CScript script;
+    if (!ParseAddressOrScript(request.params[0].get_str(), script)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script");
+    }
+    const int start_height = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    const int end_height = request.params[2].isNull() ? std::numeric_limits<int>::max() : request.params[2].get_int();
+    if (start_height < 0 || end_height < start_height) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid height range");
+    }
+
+    UniValue result;
+    std::string error;
+    if (!AddressHistoryToJSON(script, start_height, end_height, result, error)) {
+        throw JSONRPCError(RPC_MISC_ERROR, error);
+    }
+    return result;
+}
+
+static UniValue getaddressutxos(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getaddressutxos",
+                "\nReturns the unspent outputs paying to an address or script in the active chain. Requires -addressindex.\n"
+                "Fails if there are more than " + std::to_string(MAX_ADDRESS_UTXOS_RESULTS) + " of them.\n",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "The address or hex-encoded scriptPubKey"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_AMOUNT, "balance", "The total value of the unspent outputs in " + CURRENCY_UNIT},
+                        {RPCResult::Type::ARR, "utxos", "",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::NUM, "height", "The height of the block containing the output"},
+                                {RPCResult::Type::STR_HEX, "txid", "The transaction id"},
+                                {RPCResult::Type::NUM, "vout", "The output number"},
+                                {RPCResult::Type::STR_AMOUNT, "amount", "The output value in " + CURRENCY_UNIT},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getaddressutxos", "\"" + EXAMPLE_ADDRESS[0] + "\"") +
+                    HelpExampleRpc("getaddressutxos", "\"" + EXAMPLE_ADDRESS[0] + "\"")
+                }
+            }.Check(request);
+
+    CScript script;
+    if (!ParseAddressOrScript(request.params[0].get_str(), script)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script");
+    }
+
+    std::string error;
+    if (!AddressIndexReady(error)) {
+        throw JSONRPCError(RPC_MISC_ERROR, error);
+    }
+    // Ask for one more than allowed to tell a full result from a truncated one
+    std::vector<AddressOutput> outputs;
+    if (!g_address_index->FindUnspentOutputs(AddressIndex::GetScriptHash(script), MAX_ADDRESS_UTXOS_RESULTS + 1, outputs)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to read address index");
+    }
+    if (outputs.size() > MAX_ADDRESS_UTXOS_RESULTS) {
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("More than %u unspent outputs", MAX_ADDRESS_UTXOS_RESULTS));
+    }
+
+    CAmount balance = 0;
+    UniValue utxos(UniValue::VARR);
+    for (const AddressOutput& output : outputs) {
+        UniValue entry(UniValue::VOBJ);
+        entry.pushKV("height", output.height);
+        entry.pushKV("txid", output.outpoint.hash.GetHex());
+        entry.pushKV("vout", (int64_t)output.outpoint.n);
+        entry.pushKV("amount", ValueFromAmount(output.amount));
+        utxos.push_back(entry);
+        balance += output.amount;
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", ValueFromAmount(balance));
+    result.pushKV("utxos", utxos);
+    return result;
+}
+
+static UniValue getspentinfo(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getspentinfo",
+                "\nReturns the input spending a transaction output in the active chain, and the spent output. Requires -spentindex.\n",
+                {
+                    {"txid", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The transaction id"},
+                    {"n", RPCArg::Type::NUM, RPCArg::Optional::NO, "The output number"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "txid", "The id of the spending transaction"},
+                        {RPCResult::Type::NUM, "vin", "The input number in the spending transaction"},
+                        {RPCResult::Type::NUM, "height", "The height of the block containing the spending transaction"},
+                        {RPCResult::Type::OBJ, "prevout", "The spent output",
+                        {
+                            {RPCResult::Type::BOOL, "generated", "Whether the output was created by a coinbase"},
+                            {RPCResult::Type::BOOL, "coinstake", "Whether the output was created by a coinstake"},
+                            {RPCResult::Type::NUM, "height", "The height of the block containing the output"},
+                            {RPCResult::Type::STR_AMOUNT, "value", "The output value in " + CURRENCY_UNIT},
+                            {RPCResult::Type::OBJ, "scriptPubKey", "",
+                            {
+                                {RPCResult::Type::STR, "asm", "The asm"},
+                                {RPCResult::Type::STR_HEX, "hex", "The hex"},
+                                {RPCResult::Type::STR, "type", "The type, eg 'pubkeyhash'"},
+                                {RPCResult::Type::ARR, "addresses", /* optional */ true, "",
+                                {
+                                    {RPCResult::Type::STR, "address", "The address"},
+                                }},
+                            }},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getspentinfo", "\"mytxid\" 0") +
+                    HelpExampleRpc("getspentinfo", "\"mytxid\", 0")
+                }
+            }.Check(request);
+
+    const COutPoint outpoint(ParseHashV(request.params[0], "txid"), request.params[1].get_int());
+
+    if (!g_spent_index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent index is not enabled, restart with -spentindex");
+    }
+    if (!g_spent_index->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Spent index is still being built");
+    }
+
+    SpentIndexEntry entry;
+    if (!g_spent_index->FindSpent(outpoint, entry)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Output is unspent or does not exist");
+    }
+
+    UniValue prevout(UniValue::VOBJ);
+    prevout.pushKV("generated", bool(entry.prevout.fCoinBase));
+    prevout.pushKV("coinstake", entry.prevout.fCoinStake);
+    prevout.pushKV("height", (int64_t)entry.prevout.nHeight);
+    prevout.pushKV("value", ValueFromAmount(entry.prevout.out.nValue));
+    UniValue script_pub_key(UniValue::VOBJ);
+    ScriptPubKeyToUniv(entry.prevout.out.scriptPubKey, script_pub_key, true);
+    prevout.pushKV("scriptPubKey", script_pub_key);
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("txid", entry.spent_by.hash.GetHex());
+    result.pushKV("vin", (int64_t)entry.spent_by.n);
+    result.pushKV("height", entry.height);
+    result.pushKV("prevout", prevout);
+    return result;
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2254,34 +2621,38 @@ void RegisterBlockchainRPCCommands(CRPCTable &t)
 {
 // clang-format off
 static const CRPCCommand commands[] =
-{ //  category              name                      actor (function)         argNames
-  //  --------------------- ------------------------  -----------------------  ----------
+{ //  category              name                      actor (function)         argNames, parallel_safe
+  //  --------------------- ------------------------  -----------------------  -----------------------
     { "blockchain",         "bootstrap",              &bootstrap,              {} },
-    { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
-    { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
-    { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats"} },
-    { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
-    { "blockchain",         "getblockcount",          &getblockcount,          {} },
-    { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"} },
-    { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
-    { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
-    { "blockchain",         "getblocktime",           &getblocktime,           {} },
-    { "blockchain",         "getchaintips",           &getchaintips,           {} },
-    { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
-    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"} },
-    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
-    { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"} },
-    { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {} },
-    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
-    { "blockchain",         "getsubsidy",             &getsubsidy,             {} },
-    { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
+    { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {}, true },
+    { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"}, true },
+    { "blockchain",         "getblockstats",          &getblockstats,          {"hash_or_height", "stats"}, true },
+    { "blockchain",         "getblockstatsrange",     &getblockstatsrange,     {"start", "end", "stats", "by_time"}, true },
+    { "blockchain",         "getbestblockhash",       &getbestblockhash,       {}, true },
+    { "blockchain",         "getblockcount",          &getblockcount,          {}, true },
+    { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"}, true },
+    { "blockchain",         "getblockhash",           &getblockhash,           {"height"}, true },
+    { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"}, true },
+    { "blockchain",         "getblocktime",           &getblocktime,           {}, true },
+    { "blockchain",         "getchaintips",           &getchaintips,           {}, true },
+    { "blockchain",         "getdifficulty",          &getdifficulty,          {}, true },
+    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"}, true },
+    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"}, true },
+    { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"}, true },
+    { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {}, true },
+    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"}, true },
+    { "blockchain",         "getsubsidy",             &getsubsidy,             {}, true },
+    { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"}, true },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
 
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
     { "blockchain",         "scantxoutset",           &scantxoutset,           {"action", "scanobjects"} },
-    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"}, true },
+    { "blockchain",         "getaddresshistory",      &getaddresshistory,      {"address", "start_height", "end_height"}, true },
+    { "blockchain",         "getaddressutxos",        &getaddressutxos,        {"address"}, true },
+    { "blockchain",         "getspentinfo",           &getspentinfo,           {"txid","n"}, true },
 
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        {"blockhash"} },
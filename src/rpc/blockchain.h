@@ -9,18 +9,33 @@
 #include <sync.h>
 
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 extern RecursiveMutex cs_main;
 
 class CBlock;
 class CBlockIndex;
+class CScript;
 class CTxMemPool;
+class JSONStreamWriter;
 class UniValue;
 struct NodeContext;
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
 
+/** Number of mempool entries rendered per mempool lock acquisition when streaming */
+static constexpr size_t MEMPOOL_STREAM_BATCH_SIZE = 1000;
+
+/** Maximum number of address index records returned by one query */
+static constexpr size_t MAX_ADDRESS_HISTORY_RESULTS = 50000;
+
+/** Maximum number of unspent outputs returned by getaddressutxos */
+static constexpr size_t MAX_ADDRESS_UTXOS_RESULTS = 50000;
+
+/** Maximum number of blocks of one getblockstatsrange query */
+static constexpr size_t MAX_BLOCK_STATS_RANGE = 10000;
+
 /**
  * Get the difficulty of the net wrt to the given block index.
  *
@@ -36,12 +51,28 @@ void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails = false) LOCKS_EXCLUDED(cs_main);
 
+/** Block description written to a JSON stream, rendering one transaction at a time */
+void blockToJSONStream(JSONStreamWriter& writer, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails = false) LOCKS_EXCLUDED(cs_main);
+
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false);
 
+/** Verbose mempool contents written to a JSON stream. The mempool is locked
+ * per batch of entries, so the result is not an atomic snapshot: transactions
+ * leaving the mempool while it is written are omitted. */
+void MempoolToJSONStream(JSONStreamWriter& writer, const CTxMemPool& pool);
+
+/** Parse an address or a hex-encoded scriptPubKey */
+bool ParseAddressOrScript(const std::string& str, CScript& script);
+
+/** Outputs and spends of a script at heights start_height to end_height from
+ * the address index. Returns false and sets error if the index is not
+ * available or there are too many results. */
+bool AddressHistoryToJSON(const CScript& script, int start_height, int end_height, UniValue& result, std::string& error) LOCKS_EXCLUDED(cs_main);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex) LOCKS_EXCLUDED(cs_main);
 
@@ -129,12 +129,20 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "verifychain", 1, "nblocks" },
     { "getblockstats", 0, "hash_or_height" },
     { "getblockstats", 1, "stats" },
+    { "getblockstatsrange", 0, "start" },
+    { "getblockstatsrange", 1, "end" },
+    { "getblockstatsrange", 2, "stats" },
+    { "getblockstatsrange", 3, "by_time" },
+    { "getaddresshistory", 1, "start_height" },
+    { "getaddresshistory", 2, "end_height" },
+    { "getspentinfo", 1, "n" },
     { "keypoolrefill", 0, "newsize" },
     { "getrawmempool", 0, "verbose" },
     { "setban", 2, "bantime" },
     { "setban", 3, "absolute" },
     { "setnetworkactive", 0, "state" },
     { "setwalletflag", 1, "value" },
+    { "setstaking", 0, "enabled" },
     { "getmempoolancestors", 1, "verbose" },
     { "getmempooldescendants", 1, "verbose" },
     { "logging", 0, "include" },
@@ -0,0 +1,442 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsondocument.h>
+
+#include <univalue/lib/univalue_utffilter.h>
+
+#include <limits>
+#include <stdexcept>
+#include <string.h>
+
+/** Same nesting limit as UniValue::read() */
+static const size_t MAX_JSON_DOCUMENT_DEPTH = 512;
+
+static inline bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool IsPlainStringChar(unsigned char c)
+{
+    return c >= 0x20 && c < 0x80 && c != '"' && c != '\\';
+}
+
+/**
+ * Skip over string characters that need no decoding: printable ASCII other
+ * than quote and backslash. Tests eight bytes per step with word-wide
+ * arithmetic before falling back to single bytes.
+ */
+static const char* SkipPlainStringChars(const char* pos, const char* end)
+{
+    static constexpr uint64_t ONES = 0x0101010101010101ULL;
+    static constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+    while (end - pos >= 8) {
+        uint64_t word;
+        memcpy(&word, pos, 8);
+        const uint64_t quote = word ^ (ONES * '"');
+        const uint64_t backslash = word ^ (ONES * '\\');
+        // High bit set in some byte iff it is a quote, a backslash, below 0x20 or non-ASCII
+        const uint64_t special = ((quote - ONES) & ~quote) | ((backslash - ONES) & ~backslash) |
+                                 ((word - ONES * 0x20) & ~word) | word;
+        if (special & HIGH_BITS) break;
+        pos += 8;
+    }
+    while (pos < end && IsPlainStringChar(*pos)) ++pos;
+    return pos;
+}
+
+static bool ParseHex4(const char* pos, unsigned int& out)
+{
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char c = pos[i];
+        int digit;
+        if (IsDigit(c)) {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        out = 16 * out + digit;
+    }
+    return true;
+}
+
+bool JSONDocument::ParseString(const char*& pos, const char* end)
+{
+    const char* start = ++pos; // skip opening quote
+    pos = SkipPlainStringChars(pos, end);
+    if (pos >= end) return false;
+    if (*pos == '"') {
+        // Common case: refer to the input directly
+        m_nodes.push_back(Node{UniValue::VSTR, false, uint32_t(pos - start), uint32_t(start - m_input)});
+        ++pos;
+        return true;
+    }
+
+    // Escape sequences or non-ASCII characters: decode and validate
+    const size_t decoded_start = m_decoded.size();
+    m_decoded.append(start, pos);
+    JSONUTF8StringFilter writer(m_decoded);
+    while (true) {
+        if (pos >= end || (unsigned char)*pos < 0x20) return false;
+        if (*pos == '"') {
+            ++pos;
+            break;
+        }
+        if (*pos != '\\') {
+            writer.push_back(*pos++);
+            continue;
+        }
+        if (++pos >= end) return false;
+        switch (*pos) {
+        case '"':  writer.push_back('\"'); break;
+        case '\\': writer.push_back('\\'); break;
+        case '/':  writer.push_back('/'); break;
+        case 'b':  writer.push_back('\b'); break;
+        case 'f':  writer.push_back('\f'); break;
+        case 'n':  writer.push_back('\n'); break;
+        case 'r':  writer.push_back('\r'); break;
+        case 't':  writer.push_back('\t'); break;
+        case 'u': {
+            unsigned int codepoint;
+            if (end - pos <= 5 || !ParseHex4(pos + 1, codepoint)) return false;
+            writer.push_back_u(codepoint);
+            pos += 4;
+            break;
+        }
+        default:
+            return false;
+        }
+        ++pos;
+    }
+    if (!writer.finalize()) return false;
+    m_nodes.push_back(Node{UniValue::VSTR, true, uint32_t(m_decoded.size() - decoded_start), uint32_t(decoded_start)});
+    return true;
+}
+
+bool JSONDocument::ParseNumber(const char*& pos, const char* end)
+{
+    const char* start = pos;
+    if (*pos == '-') ++pos;
+    if (pos >= end || !IsDigit(*pos)) return false;
+    if (*pos == '0' && pos + 1 < end && IsDigit(pos[1])) return false; // no leading zeros
+    while (pos < end && IsDigit(*pos)) ++pos;
+    if (pos < end && *pos == '.') {
+        ++pos;
+        if (pos >= end || !IsDigit(*pos)) return false;
+        while (pos < end && IsDigit(*pos)) ++pos;
+    }
+    if (pos < end && (*pos == 'e' || *pos == 'E')) {
+        ++pos;
+        if (pos < end && (*pos == '-' || *pos == '+')) ++pos;
+        if (pos >= end || !IsDigit(*pos)) return false;
+        while (pos < end && IsDigit(*pos)) ++pos;
+    }
+    m_nodes.push_back(Node{UniValue::VNUM, false, uint32_t(pos - start), uint32_t(start - m_input)});
+    return true;
+}
+
+static inline bool MatchKeyword(const char*& pos, const char* end, const char* keyword, size_t len)
+{
+    if (size_t(end - pos) < len || memcmp(pos, keyword, len) != 0) return false;
+    pos += len;
+    return true;
+}
+
+bool JSONDocument::Parse(const char* raw, size_t size)
+{
+    m_input = raw;
+    m_nodes.clear();
+    m_decoded.clear();
+    m_stack.clear();
+    if (size >= std::numeric_limits<uint32_t>::max()) return false;
+
+    enum class Expect {
+        VALUE,            //!< a value (top-level, after a colon or after a comma in an array)
+        VALUE_OR_CLOSE,   //!< first element of an array
+        KEY,              //!< a member key after a comma in an object
+        KEY_OR_CLOSE,     //!< first member of an object
+        COLON,
+        COMMA_OR_CLOSE,
+    };
+
+    const char* pos = raw;
+    const char* end = raw + size;
+    Expect expect = Expect::VALUE;
+    bool done = false;
+    while (!done) {
+        while (pos < end && json_isspace(*pos)) ++pos;
+        if (pos >= end) break;
+
+        bool value_done = false;
+        bool close = false;
+        switch (expect) {
+        case Expect::KEY_OR_CLOSE:
+            if (*pos == '}') {
+                close = true;
+                break;
+            }
+            // fall through
+        case Expect::KEY:
+            if (*pos != '"' || !ParseString(pos, end)) break;
+            expect = Expect::COLON;
+            continue;
+        case Expect::COLON:
+            if (*pos != ':') break;
+            ++pos;
+            expect = Expect::VALUE;
+            continue;
+        case Expect::COMMA_OR_CLOSE:
+            if (*pos == '}' || *pos == ']') {
+                close = true;
+            } else if (*pos == ',') {
+                ++pos;
+                expect = m_nodes[m_stack.back()].type == UniValue::VOBJ ? Expect::KEY : Expect::VALUE;
+                continue;
+            }
+            break;
+        case Expect::VALUE_OR_CLOSE:
+            if (*pos == ']') {
+                close = true;
+                break;
+            }
+            // fall through
+        case Expect::VALUE:
+            switch (*pos) {
+            case '{':
+            case '[':
+                m_stack.push_back(uint32_t(m_nodes.size()));
+                m_nodes.push_back(Node{uint8_t(*pos == '{' ? UniValue::VOBJ : UniValue::VARR), false, 0, 0});
+                if (m_stack.size() > MAX_JSON_DOCUMENT_DEPTH) break;
+                expect = *pos == '{' ? Expect::KEY_OR_CLOSE : Expect::VALUE_OR_CLOSE;
+                ++pos;
+                continue;
+            case '"':
+                value_done = ParseString(pos, end);
+                break;
+            case 'n':
+                value_done = MatchKeyword(pos, end, "null", 4);
+                if (value_done) m_nodes.push_back(Node{UniValue::VNULL, false, 0, 0});
+                break;
+            case 't':
+                value_done = MatchKeyword(pos, end, "true", 4);
+                if (value_done) m_nodes.push_back(Node{UniValue::VBOOL, false, 1, 0});
+                break;
+            case 'f':
+                value_done = MatchKeyword(pos, end, "false", 5);
+                if (value_done) m_nodes.push_back(Node{UniValue::VBOOL, false, 0, 0});
+                break;
+            default:
+                if (*pos == '-' || IsDigit(*pos)) value_done = ParseNumber(pos, end);
+                break;
+            }
+            break;
+        }
+
+        if (close) {
+            Node& container = m_nodes[m_stack.back()];
+            if ((*pos == '}') != (container.type == UniValue::VOBJ)) break;
+            container.offset = uint32_t(m_nodes.size());
+            m_stack.pop_back();
+            ++pos;
+            value_done = true;
+        }
+        if (!value_done) break;
+
+        if (m_stack.empty()) {
+            done = true;
+        } else {
+            ++m_nodes[m_stack.back()].length;
+            expect = Expect::COMMA_OR_CLOSE;
+        }
+    }
+
+    // Nothing but whitespace may follow the top-level value
+    while (pos < end && json_isspace(*pos)) ++pos;
+    if (!done || pos != end) {
+        m_nodes.clear();
+        return false;
+    }
+    return true;
+}
+
+JSONValue JSONDocument::Root() const
+{
+    if (m_nodes.empty()) return JSONValue();
+    return JSONValue(this, 0);
+}
+
+uint32_t JSONDocument::NextSibling(uint32_t index) const
+{
+    const Node& node = m_nodes[index];
+    if (node.type == UniValue::VOBJ || node.type == UniValue::VARR) return node.offset;
+    return index + 1;
+}
+
+UniValue::VType JSONValue::getType() const
+{
+    if (!m_doc) return UniValue::VNULL;
+    return UniValue::VType(m_doc->m_nodes[m_index].type);
+}
+
+bool JSONValue::isTrue() const
+{
+    return isBool() && m_doc->m_nodes[m_index].length != 0;
+}
+
+bool JSONValue::isFalse() const
+{
+    return isBool() && m_doc->m_nodes[m_index].length == 0;
+}
+
+size_t JSONValue::size() const
+{
+    if (!isObject() && !isArray()) return 0;
+    return m_doc->m_nodes[m_index].length;
+}
+
+JSONValue JSONValue::operator[](size_t index) const
+{
+    if (index >= size()) return JSONValue();
+    const bool object = isObject();
+    uint32_t child = m_index + 1;
+    for (size_t i = 0; i < index; ++i) {
+        if (object) ++child; // skip key
+        child = m_doc->NextSibling(child);
+    }
+    return JSONValue(m_doc, object ? child + 1 : child);
+}
+
+JSONValue JSONValue::operator[](const std::string& key) const
+{
+    if (!isObject()) return JSONValue();
+    uint32_t child = m_index + 1;
+    for (size_t i = 0; i < size(); ++i) {
+        if (JSONValue(m_doc, child).equals(key)) return JSONValue(m_doc, child + 1);
+        child = m_doc->NextSibling(child + 1);
+    }
+    return JSONValue();
+}
+
+bool JSONValue::exists(const std::string& key) const
+{
+    if (!isObject()) return false;
+    uint32_t child = m_index + 1;
+    for (size_t i = 0; i < size(); ++i) {
+        if (JSONValue(m_doc, child).equals(key)) return true;
+        child = m_doc->NextSibling(child + 1);
+    }
+    return false;
+}
+
+std::string JSONValue::getKey(size_t index) const
+{
+    if (!isObject()) throw std::runtime_error("JSON value is not an object as expected");
+    if (index >= size()) throw std::out_of_range("JSON object member index out of range");
+    uint32_t child = m_index + 1;
+    for (size_t i = 0; i < index; ++i) {
+        child = m_doc->NextSibling(child + 1);
+    }
+    return JSONValue(m_doc, child).get_str();
+}
+
+std::vector<JSONValue> JSONValue::getValues() const
+{
+    if (!isObject() && !isArray()) throw std::runtime_error("JSON value is not an object or array as expected");
+    const bool object = isObject();
+    std::vector<JSONValue> values;
+    values.reserve(size());
+    uint32_t child = m_index + 1;
+    for (size_t i = 0; i < size(); ++i) {
+        if (object) ++child; // skip key
+        values.push_back(JSONValue(m_doc, child));
+        child = m_doc->NextSibling(child);
+    }
+    return values;
+}
+
+const char* JSONValue::Data() const
+{
+    const JSONDocument::Node& node = m_doc->m_nodes[m_index];
+    if (node.decoded) return m_doc->m_decoded.data() + node.offset;
+    return m_doc->m_input + node.offset;
+}
+
+uint32_t JSONValue::Length() const
+{
+    return m_doc->m_nodes[m_index].length;
+}
+
+bool JSONValue::equals(const std::string& str) const
+{
+    return isStr() && Length() == str.size() && memcmp(Data(), str.data(), str.size()) == 0;
+}
+
+bool JSONValue::get_bool() const
+{
+    if (!isBool()) throw std::runtime_error("JSON value is not a boolean as expected");
+    return isTrue();
+}
+
+std::string JSONValue::get_str() const
+{
+    if (!isStr()) throw std::runtime_error("JSON value is not a string as expected");
+    return std::string(Data(), Length());
+}
+
+int JSONValue::get_int() const
+{
+    if (!isNum()) throw std::runtime_error("JSON value is not an integer as expected");
+    return UniValue(UniValue::VNUM, std::string(Data(), Length())).get_int();
+}
+
+int64_t JSONValue::get_int64() const
+{
+    if (!isNum()) throw std::runtime_error("JSON value is not an integer as expected");
+    return UniValue(UniValue::VNUM, std::string(Data(), Length())).get_int64();
+}
+
+double JSONValue::get_real() const
+{
+    if (!isNum()) throw std::runtime_error("JSON value is not a number as expected");
+    return UniValue(UniValue::VNUM, std::string(Data(), Length())).get_real();
+}
+
+UniValue JSONValue::ToUniValue() const
+{
+    switch (getType()) {
+    case UniValue::VNULL:
+        break;
+    case UniValue::VBOOL:
+        return UniValue(isTrue());
+    case UniValue::VNUM:
+    case UniValue::VSTR:
+        return UniValue(getType(), std::string(Data(), Length()));
+    case UniValue::VARR: {
+        UniValue arr(UniValue::VARR);
+        uint32_t child = m_index + 1;
+        for (size_t i = 0; i < size(); ++i) {
+            arr.push_back(JSONValue(m_doc, child).ToUniValue());
+            child = m_doc->NextSibling(child);
+        }
+        return arr;
+    }
+    case UniValue::VOBJ: {
+        UniValue obj(UniValue::VOBJ);
+        uint32_t child = m_index + 1;
+        for (size_t i = 0; i < size(); ++i) {
+            // Keep duplicate keys, as UniValue::read() does
+            obj.__pushKV(JSONValue(m_doc, child).get_str(), JSONValue(m_doc, child + 1).ToUniValue());
+            child = m_doc->NextSibling(child + 1);
+        }
+        return obj;
+    }
+    }
+    return NullUniValue;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONDOCUMENT_H
+#define BITCOIN_RPC_JSONDOCUMENT_H
+
+#include <univalue.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class JSONDocument;
+
+/**
+ * Handle to a value inside a JSONDocument.
+ *
+ * Offers the read accessors of UniValue under the same names, so code that
+ * only inspects a parsed request can work on either. Handles are cheap to
+ * copy and are only valid as long as the document they refer to.
+ * Missing object members and out of range array elements are null values.
+ */
+class JSONValue
+{
+public:
+    JSONValue() : m_doc(nullptr), m_index(0) {}
+
+    UniValue::VType getType() const;
+    UniValue::VType type() const { return getType(); }
+    bool isNull() const { return getType() == UniValue::VNULL; }
+    bool isTrue() const;
+    bool isFalse() const;
+    bool isBool() const { return getType() == UniValue::VBOOL; }
+    bool isStr() const { return getType() == UniValue::VSTR; }
+    bool isNum() const { return getType() == UniValue::VNUM; }
+    bool isArray() const { return getType() == UniValue::VARR; }
+    bool isObject() const { return getType() == UniValue::VOBJ; }
+
+    /** Number of elements of an array or members of an object */
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    /** Array element or object member value by position */
+    JSONValue operator[](size_t index) const;
+    /** Object member by key */
+    JSONValue operator[](const std::string& key) const;
+    bool exists(const std::string& key) const;
+    /** Key of the object member at position index */
+    std::string getKey(size_t index) const;
+    /** Handles to all array elements or object member values, in order.
+     * Prefer this over indexing in a loop, which walks the container each time. */
+    std::vector<JSONValue> getValues() const;
+
+    /** Compare a string value without copying it */
+    bool equals(const std::string& str) const;
+
+    // Strict type-specific getters, these throw std::runtime_error if the
+    // value is of unexpected type
+    bool get_bool() const;
+    std::string get_str() const;
+    int get_int() const;
+    int64_t get_int64() const;
+    double get_real() const;
+
+    /** Deep copy into a UniValue for code that needs one */
+    UniValue ToUniValue() const;
+
+private:
+    friend class JSONDocument;
+    JSONValue(const JSONDocument* doc, uint32_t index) : m_doc(doc), m_index(index) {}
+
+    const JSONDocument* m_doc;
+    uint32_t m_index;
+
+    const char* Data() const;
+    uint32_t Length() const;
+};
+
+/**
+ * Read-only JSON document parsed in a single pass.
+ *
+ * All values are stored in one flat node array, so parsing costs a handful
+ * of allocations per document rather than several per value, and the arrays
+ * are reused when a document object parses again. Numbers and strings
+ * without escape sequences or non-ASCII characters refer directly into the
+ * parsed buffer, which must therefore outlive the document. Other strings are
+ * decoded into a shared side buffer.
+ *
+ * Follows the grammar, nesting limit and UTF-8 validation of UniValue::read().
+ */
+class JSONDocument
+{
+public:
+    JSONDocument() = default;
+    JSONDocument(const JSONDocument&) = delete;
+    JSONDocument& operator=(const JSONDocument&) = delete;
+
+    bool Parse(const char* raw, size_t size);
+    bool Parse(const std::string& str) { return Parse(str.data(), str.size()); }
+
+    /** Top-level value; null if nothing was parsed successfully */
+    JSONValue Root() const;
+
+private:
+    friend class JSONValue;
+
+    struct Node {
+        uint8_t type;
+        //! Whether the string data lives in m_decoded rather than the input
+        bool decoded;
+        //! Strings and numbers: length of the text. Containers: number of children.
+        uint32_t length;
+        //! Strings and numbers: offset of the text. Containers: index of the
+        //! first node after the container, for skipping over it.
+        uint32_t offset;
+    };
+
+    const char* m_input{nullptr};
+    std::vector<Node> m_nodes;
+    std::string m_decoded;
+    std::vector<uint32_t> m_stack;
+
+    bool ParseString(const char*& pos, const char* end);
+    bool ParseNumber(const char*& pos, const char* end);
+    uint32_t NextSibling(uint32_t index) const;
+};
+
+#endif // BITCOIN_RPC_JSONDOCUMENT_H
@@ -0,0 +1,128 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonstream.h>
+
+#include <univalue.h>
+
+#include <assert.h>
+
+JSONStreamWriter::JSONStreamWriter(Sink sink, size_t chunk_size)
+    : m_sink(std::move(sink)), m_chunk_size(chunk_size)
+{
+    m_buffer.reserve(m_chunk_size);
+}
+
+void JSONStreamWriter::BeginElement()
+{
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (!m_empty.empty()) {
+        if (!m_empty.back()) Append(',');
+        m_empty.back() = false;
+    }
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    BeginElement();
+    Append('{');
+    m_empty.push_back(true);
+}
+
+void JSONStreamWriter::EndObject()
+{
+    assert(!m_empty.empty() && !m_after_key);
+    m_empty.pop_back();
+    Append('}');
+    MaybeFlush();
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    BeginElement();
+    Append('[');
+    m_empty.push_back(true);
+}
+
+void JSONStreamWriter::EndArray()
+{
+    assert(!m_empty.empty() && !m_after_key);
+    m_empty.pop_back();
+    Append(']');
+    MaybeFlush();
+}
+
+void JSONStreamWriter::Key(const std::string& key)
+{
+    assert(!m_empty.empty() && !m_after_key);
+    BeginElement();
+    Append(UniValue(UniValue::VSTR, key).write());
+    Append(':');
+    m_after_key = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    switch (value.getType()) {
+    case UniValue::VOBJ: {
+        BeginObject();
+        const std::vector<std::string>& keys = value.getKeys();
+        const std::vector<UniValue>& values = value.getValues();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            Key(keys[i]);
+            Value(values[i]);
+        }
+        EndObject();
+        break;
+    }
+    case UniValue::VARR:
+        BeginArray();
+        for (const UniValue& element : value.getValues()) {
+            Value(element);
+        }
+        EndArray();
+        break;
+    default:
+        BeginElement();
+        Append(value.write());
+        MaybeFlush();
+        break;
+    }
+}
+
+void JSONStreamWriter::Pair(const std::string& key, const UniValue& value)
+{
+    Key(key);
+    Value(value);
+}
+
+std::string JSONStreamWriter::Finish()
+{
+    assert(m_empty.empty() && !m_after_key);
+    std::string rest;
+    rest.swap(m_buffer);
+    return rest;
+}
+
+void JSONStreamWriter::Append(const std::string& str)
+{
+    if (!m_failed) m_buffer += str;
+}
+
+void JSONStreamWriter::Append(char c)
+{
+    if (!m_failed) m_buffer += c;
+}
+
+void JSONStreamWriter::MaybeFlush()
+{
+    if (m_failed || m_buffer.size() < m_chunk_size) return;
+    if (!m_sink(m_buffer)) {
+        m_failed = true;
+    }
+    m_buffer.clear();
+}
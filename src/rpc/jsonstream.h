@@ -0,0 +1,68 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class UniValue;
+
+/** Default number of bytes a JSONStreamWriter buffers before passing them on */
+static constexpr size_t DEFAULT_JSON_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Incremental writer for compact JSON documents.
+ *
+ * Output is accumulated in a buffer that is handed to the sink whenever it
+ * grows past the chunk size, so documents of any size can be produced with
+ * memory bounded by the chunk size and the largest single scalar written.
+ * The output is identical to UniValue::write() without indentation.
+ */
+class JSONStreamWriter
+{
+public:
+    /** Receives a chunk of output. Returning false discards all further output. */
+    using Sink = std::function<bool(const std::string& chunk)>;
+
+    explicit JSONStreamWriter(Sink sink, size_t chunk_size = DEFAULT_JSON_STREAM_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write an object key. Must be followed by exactly one value. */
+    void Key(const std::string& key);
+    /** Write a value. Arrays and objects are written element by element. */
+    void Value(const UniValue& value);
+    /** Write a key/value pair into the current object */
+    void Pair(const std::string& key, const UniValue& value);
+
+    /** Whether the sink refused output. Producers may stop early when set. */
+    bool Failed() const { return m_failed; }
+
+    /** Return the output that has not been passed to the sink yet.
+     * All arrays and objects must have been closed. */
+    std::string Finish();
+
+private:
+    Sink m_sink;
+    const size_t m_chunk_size;
+    std::string m_buffer;
+    //! For every open array or object, whether it still has no elements
+    std::vector<bool> m_empty;
+    //! A key has been written and its value is pending
+    bool m_after_key{false};
+    bool m_failed{false};
+
+    void BeginElement();
+    void Append(const std::string& str);
+    void Append(char c);
+    void MaybeFlush();
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
@@ -255,7 +255,7 @@ static UniValue getmininginfo(const JSONRPCRequest& request)
     if( ! Params().IsVericoin())
     {
         double blocktime = (double)CalculateBlocktime(::ChainActive().Tip())/60;
-        double totalhashrate = hashrate;
+        double totalhashrate = g_mining_metrics.hashes_per_min;
         double minerate;
         if (totalhashrate == 0.0){minerate = 0.0;}
         else{
@@ -279,7 +279,7 @@ static UniValue getmininginfo(const JSONRPCRequest& request)
         UniValue difficulty(UniValue::VOBJ);
         difficulty.pushKV("proof-of-work",        GetDifficulty(NULL));
         difficulty.pushKV("proof-of-stake",       GetDifficulty(GetLastBlockIndex(::ChainActive().Tip(), true)));
-        difficulty.pushKV("search-interval", (int)nLastCoinStakeSearchInterval);
+        difficulty.pushKV("search-interval", (int)g_mining_metrics.search_interval);
 
         UniValue stakeweight(UniValue::VOBJ);
         stakeweight.pushKV("combined", nWeight);
@@ -902,7 +902,7 @@ UniValue stakingstatus(const JSONRPCRequest& request)
 UniValue stakingstart(const JSONRPCRequest& request)
 {
     RPCHelpMan{"stakingstart",
-        "\nStart staking (Vericoin only)",
+        "\nStart staking with all loaded wallets that have staking enabled, see setstaking (Vericoin only)",
         {},
         RPCResult{
             RPCResult::Type::OBJ, "", "",
@@ -922,15 +922,12 @@ UniValue stakingstart(const JSONRPCRequest& request)
     if(!g_rpc_node->connman)
         throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
 
-    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
-
-    if (!EnsureWalletIsAvailable(wallet.get(), request.fHelp)) {
-        return false;
-    }
+    if (GetWallets().empty())
+        throw JSONRPCError(RPC_WALLET_NOT_FOUND, "No wallet is loaded, load a wallet to stake with using loadwallet");
 
     LOCK(cs_main);
 
-    GenerateVericoin(true, wallet, g_rpc_node->connman.get(), g_rpc_node->mempool);
+    GenerateVericoin(true, g_rpc_node->connman.get(), g_rpc_node->mempool);
 
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("status",   "active");
@@ -961,16 +958,9 @@ UniValue stakingstop(const JSONRPCRequest& request)
     if(!g_rpc_node->connman)
         throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
 
-
-    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
-
-    if (!EnsureWalletIsAvailable(wallet.get(), request.fHelp)) {
-        return false;
-    }
-
     LOCK(cs_main);
 
-    GenerateVericoin(false, wallet,  g_rpc_node->connman.get(), g_rpc_node->mempool);
+    GenerateVericoin(false, g_rpc_node->connman.get(), g_rpc_node->mempool);
 
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("status",   "stopped");
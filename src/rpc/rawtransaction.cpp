@@ -7,6 +7,7 @@
 #include <coins.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <index/spentindex.h>
 #include <index/txindex.h>
 #include <key_io.h>
 #include <merkleblock.h>
@@ -27,6 +28,7 @@
 #include <script/signingprovider.h>
 #include <script/standard.h>
 #include <uint256.h>
+#include <undo.h>
 #include <util/moneystr.h>
 #include <util/strencodings.h>
 #include <util/string.h>
@@ -51,8 +53,11 @@ static void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue&
     //
     // Blockchain contextual information (confirmations and blocktime) is not
     // available to code in bitcoin-common, so we query them here and push the
-    // data into the returned UniValue.
-    TxToUniv(tx, uint256(), entry, true, RPCSerializationFlags());
+    // data into the returned UniValue. Input values and the fee of a confirmed
+    // transaction come from the spent index, if enabled.
+    CTxUndo txundo;
+    const bool have_prevouts = !hashBlock.IsNull() && g_spent_index && g_spent_index->FindPrevouts(tx, txundo);
+    TxToUniv(tx, uint256(), entry, true, RPCSerializationFlags(), have_prevouts ? &txundo : nullptr);
 
     if (!hashBlock.IsNull()) {
         LOCK(cs_main);
@@ -124,6 +129,17 @@ static UniValue getrawtransaction(const JSONRPCRequest& request)
                                      {
                                          {RPCResult::Type::STR_HEX, "hex", "hex-encoded witness data (if any)"},
                                      }},
+                                     {RPCResult::Type::OBJ, "prevout", /* optional */ true, "The spent output, only present if -spentindex is enabled and the transaction is confirmed",
+                                     {
+                                         {RPCResult::Type::BOOL, "generated", "Whether the output was created by a coinbase"},
+                                         {RPCResult::Type::BOOL, "coinstake", "Whether the output was created by a coinstake"},
+                                         {RPCResult::Type::NUM, "height", "The height of the block containing the output"},
+                                         {RPCResult::Type::NUM, "value", "The value in " + CURRENCY_UNIT},
+                                         {RPCResult::Type::OBJ, "scriptPubKey", "",
+                                         {
+                                             {RPCResult::Type::ELISION, "", "Same as in \"vout\""},
+                                         }},
+                                     }},
                                  }},
                              }},
                              {RPCResult::Type::ARR, "vout", "",
@@ -145,6 +161,7 @@ static UniValue getrawtransaction(const JSONRPCRequest& request)
                                      }},
                                  }},
                              }},
+                             {RPCResult::Type::NUM, "fee", /* optional */ true, "The transaction fee in " + CURRENCY_UNIT + ", only present if -spentindex is enabled, the transaction is confirmed and it is not a coinbase or coinstake"},
                              {RPCResult::Type::STR_HEX, "blockhash", "the block hash"},
                              {RPCResult::Type::NUM, "confirmations", "The confirmations"},
                              {RPCResult::Type::NUM_TIME, "blocktime", "The block time expressed in " + UNIX_EPOCH_TIME},
@@ -1793,27 +1810,27 @@ void RegisterRawTransactionRPCCommands(CRPCTable &t)
 {
 // clang-format off
 static const CRPCCommand commands[] =
-{ //  category              name                            actor (function)            argNames
-  //  --------------------- ------------------------        -----------------------     ----------
-    { "rawtransactions",    "getrawtransaction",            &getrawtransaction,         {"txid","verbose","blockhash"} },
+{ //  category              name                            actor (function)            argNames, parallel_safe
+  //  --------------------- ------------------------        -----------------------     -----------------------
+    { "rawtransactions",    "getrawtransaction",            &getrawtransaction,         {"txid","verbose","blockhash"}, true },
     { "rawtransactions",    "createrawtransaction",         &createrawtransaction,      {"inputs","outputs","locktime"} },
-    { "rawtransactions",    "decoderawtransaction",         &decoderawtransaction,      {"hexstring","iswitness"} },
-    { "rawtransactions",    "decodescript",                 &decodescript,              {"hexstring"} },
+    { "rawtransactions",    "decoderawtransaction",         &decoderawtransaction,      {"hexstring","iswitness"}, true },
+    { "rawtransactions",    "decodescript",                 &decodescript,              {"hexstring"}, true },
     { "rawtransactions",    "sendrawtransaction",           &sendrawtransaction,        {"hexstring","allowhighfees|maxfeerate"} },
     { "rawtransactions",    "combinerawtransaction",        &combinerawtransaction,     {"txs"} },
     { "rawtransactions",    "signrawtransactionwithkey",    &signrawtransactionwithkey, {"hexstring","privkeys","prevtxs","sighashtype"} },
     { "rawtransactions",    "testmempoolaccept",            &testmempoolaccept,         {"rawtxs","allowhighfees|maxfeerate"} },
-    { "rawtransactions",    "decodepsbt",                   &decodepsbt,                {"psbt"} },
+    { "rawtransactions",    "decodepsbt",                   &decodepsbt,                {"psbt"}, true },
     { "rawtransactions",    "combinepsbt",                  &combinepsbt,               {"txs"} },
     { "rawtransactions",    "finalizepsbt",                 &finalizepsbt,              {"psbt", "extract"} },
     { "rawtransactions",    "createpsbt",                   &createpsbt,                {"inputs","outputs","locktime"} },
     { "rawtransactions",    "converttopsbt",                &converttopsbt,             {"hexstring","permitsigdata","iswitness"} },
     { "rawtransactions",    "utxoupdatepsbt",               &utxoupdatepsbt,            {"psbt", "descriptors"} },
     { "rawtransactions",    "joinpsbts",                    &joinpsbts,                 {"txs"} },
-    { "rawtransactions",    "analyzepsbt",                  &analyzepsbt,               {"psbt"} },
+    { "rawtransactions",    "analyzepsbt",                  &analyzepsbt,               {"psbt"}, true },
 
-    { "blockchain",         "gettxoutproof",                &gettxoutproof,             {"txids", "blockhash"} },
-    { "blockchain",         "verifytxoutproof",             &verifytxoutproof,          {"proof"} },
+    { "blockchain",         "gettxoutproof",                &gettxoutproof,             {"txids", "blockhash"}, true },
+    { "blockchain",         "verifytxoutproof",             &verifytxoutproof,          {"proof"}, true },
 };
 // clang-format on
 
@@ -8,6 +8,7 @@
 #include <fs.h>
 
 #include <random.h>
+#include <rpc/jsondocument.h>
 #include <rpc/protocol.h>
 #include <util/system.h>
 #include <util/strencodings.h>
@@ -166,12 +167,7 @@ void JSONRPCRequest::parse(const UniValue& valRequest)
         throw JSONRPCError(RPC_INVALID_REQUEST, "Missing method");
     if (!valMethod.isStr())
         throw JSONRPCError(RPC_INVALID_REQUEST, "Method must be a string");
-    strMethod = valMethod.get_str();
-    if (fLogIPs)
-        LogPrint(BCLog::RPC, "ThreadRPCServer method=%s user=%s peeraddr=%s\n", SanitizeString(strMethod),
-            this->authUser, this->peerAddr);
-    else
-        LogPrint(BCLog::RPC, "ThreadRPCServer method=%s user=%s\n", SanitizeString(strMethod), this->authUser);
+    setMethod(valMethod.get_str());
 
     // Parse params
     UniValue valParams = find_value(request, "params");
@@ -182,3 +178,40 @@ void JSONRPCRequest::parse(const UniValue& valRequest)
     else
         throw JSONRPCError(RPC_INVALID_REQUEST, "Params must be an array or object");
 }
+
+void JSONRPCRequest::parse(const JSONValue& valRequest)
+{
+    // Parse request
+    if (!valRequest.isObject())
+        throw JSONRPCError(RPC_INVALID_REQUEST, "Invalid Request object");
+
+    // Parse id now so errors from here on will have the id
+    id = valRequest["id"].ToUniValue();
+
+    // Parse method
+    const JSONValue valMethod = valRequest["method"];
+    if (valMethod.isNull())
+        throw JSONRPCError(RPC_INVALID_REQUEST, "Missing method");
+    if (!valMethod.isStr())
+        throw JSONRPCError(RPC_INVALID_REQUEST, "Method must be a string");
+    setMethod(valMethod.get_str());
+
+    // Parse params
+    const JSONValue valParams = valRequest["params"];
+    if (valParams.isArray() || valParams.isObject())
+        params = valParams.ToUniValue();
+    else if (valParams.isNull())
+        params = UniValue(UniValue::VARR);
+    else
+        throw JSONRPCError(RPC_INVALID_REQUEST, "Params must be an array or object");
+}
+
+void JSONRPCRequest::setMethod(const std::string& method)
+{
+    strMethod = method;
+    if (fLogIPs)
+        LogPrint(BCLog::RPC, "ThreadRPCServer method=%s user=%s peeraddr=%s\n", SanitizeString(strMethod),
+            this->authUser, this->peerAddr);
+    else
+        LogPrint(BCLog::RPC, "ThreadRPCServer method=%s user=%s\n", SanitizeString(strMethod), this->authUser);
+}
@@ -6,10 +6,13 @@
 #ifndef BITCOIN_RPC_REQUEST_H
 #define BITCOIN_RPC_REQUEST_H
 
+#include <stdint.h>
 #include <string>
 
 #include <univalue.h>
 
+class JSONValue;
+
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id);
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
@@ -34,9 +37,16 @@ public:
     std::string URI;
     std::string authUser;
     std::string peerAddr;
+    //! Microseconds the request waited for a worker before execution
+    int64_t queueTime;
 
-    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
+    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false), queueTime(0) {}
     void parse(const UniValue& valRequest);
+    /** Parse a request straight from a parsed body, only id and params are copied */
+    void parse(const JSONValue& valRequest);
+
+private:
+    void setMethod(const std::string& method);
 };
 
 #endif // BITCOIN_RPC_REQUEST_H
@@ -5,17 +5,23 @@
 
 #include <rpc/server.h>
 
+#include <httpserver.h>
+#include <rpc/jsondocument.h>
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <util/threadnames.h>
 
 #include <boost/signals2/signal.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 
+#include <condition_variable>
+#include <deque>
 #include <memory> // for unique_ptr
+#include <thread>
 #include <unordered_map>
 
 static RecursiveMutex cs_rpcWarmup;
@@ -35,25 +41,118 @@ struct RPCCommandExecutionInfo
     int64_t start;
 };
 
+/** Cumulative timings of a method, in microseconds */
+struct RPCMethodStats
+{
+    uint64_t calls{0};
+    int64_t queue_time{0};
+    int64_t queue_time_max{0};
+    int64_t exec_time{0};
+    int64_t exec_time_max{0};
+};
+
 struct RPCServerInfo
 {
     Mutex mutex;
     std::list<RPCCommandExecutionInfo> active_commands GUARDED_BY(mutex);
+    std::map<std::string, RPCMethodStats> method_stats GUARDED_BY(mutex);
 };
 
 static RPCServerInfo g_rpc_server_info;
 
+/**
+ * Fixed set of threads running the parallel-safe calls of batch requests.
+ *
+ * The queue is bounded: when it is full, or the executor is not running,
+ * Submit() runs the task on the calling thread instead. On Stop() the threads
+ * finish all queued tasks before exiting, so nobody waits on a dropped task.
+ */
+class RPCBatchExecutor
+{
+private:
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<std::function<void()>> m_queue GUARDED_BY(m_mutex);
+    bool m_running GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_threads;
+
+    void Run()
+    {
+        while (true) {
+            std::function<void()> task;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                while (m_running && m_queue.empty()) m_cond.wait(lock);
+                if (m_queue.empty()) break;
+                task = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    void Start(int threads)
+    {
+        LOCK(m_mutex);
+        if (m_running || threads <= 0) return;
+        m_running = true;
+        for (int i = 0; i < threads; ++i) {
+            m_threads.emplace_back([this, i] {
+                util::ThreadRename(strprintf("rpcbatch.%i", i));
+                Run();
+            });
+        }
+    }
+
+    void Stop()
+    {
+        WITH_LOCK(m_mutex, m_running = false; m_cond.notify_all());
+        for (std::thread& thread : m_threads) thread.join();
+        m_threads.clear();
+    }
+
+    bool IsRunning()
+    {
+        LOCK(m_mutex);
+        return m_running;
+    }
+
+    void Submit(std::function<void()> task)
+    {
+        {
+            LOCK(m_mutex);
+            if (m_running && m_queue.size() < MAX_RPC_BATCH_QUEUE) {
+                m_queue.push_back(std::move(task));
+                m_cond.notify_one();
+                return;
+            }
+        }
+        task();
+    }
+};
+
+static RPCBatchExecutor g_rpc_batch_executor;
+
 struct RPCCommandExecution
 {
     std::list<RPCCommandExecutionInfo>::iterator it;
-    explicit RPCCommandExecution(const std::string& method)
+    int64_t queue_time;
+    RPCCommandExecution(const std::string& method, int64_t queue_time) : queue_time(queue_time)
     {
         LOCK(g_rpc_server_info.mutex);
         it = g_rpc_server_info.active_commands.insert(g_rpc_server_info.active_commands.end(), {method, GetTimeMicros()});
     }
     ~RPCCommandExecution()
     {
+        const int64_t exec_time = GetTimeMicros() - it->start;
         LOCK(g_rpc_server_info.mutex);
+        RPCMethodStats& stats = g_rpc_server_info.method_stats[it->method];
+        ++stats.calls;
+        stats.queue_time += queue_time;
+        stats.queue_time_max = std::max(stats.queue_time_max, queue_time);
+        stats.exec_time += exec_time;
+        stats.exec_time_max = std::max(stats.exec_time_max, exec_time);
         g_rpc_server_info.active_commands.erase(it);
     }
 };
@@ -209,6 +308,33 @@ static UniValue getrpcinfo(const JSONRPCRequest& request)
                                  {RPCResult::Type::NUM, "duration", "The running time in microseconds"},
                             }},
                         }},
+                        {RPCResult::Type::OBJ_DYN, "methods", "Timings of the commands executed so far, by method",
+                        {
+                            {RPCResult::Type::OBJ, "method", "",
+                            {
+                                {RPCResult::Type::NUM, "calls", "Number of executions"},
+                                {RPCResult::Type::NUM, "queue_time_avg", "Average time waited for a worker thread in microseconds"},
+                                {RPCResult::Type::NUM, "queue_time_max", "Maximum time waited for a worker thread in microseconds"},
+                                {RPCResult::Type::NUM, "exec_time_avg", "Average running time in microseconds"},
+                                {RPCResult::Type::NUM, "exec_time_max", "Maximum running time in microseconds"},
+                            }},
+                        }},
+                        {RPCResult::Type::OBJ, "work_queue", /* optional */ true, "The HTTP work queue, when the HTTP server is running",
+                        {
+                            {RPCResult::Type::NUM, "threads", "Current number of worker threads"},
+                            {RPCResult::Type::NUM, "idle_threads", "Worker threads waiting for work"},
+                            {RPCResult::Type::NUM, "min_threads", "Worker threads kept when idle (-rpcthreads)"},
+                            {RPCResult::Type::NUM, "max_threads", "Upper bound of worker threads (-rpcmaxthreads)"},
+                            {RPCResult::Type::OBJ_DYN, "lanes", "Queues by priority (high, normal, low)",
+                            {
+                                {RPCResult::Type::OBJ, "priority", "",
+                                {
+                                    {RPCResult::Type::NUM, "queued", "Requests waiting for a worker"},
+                                    {RPCResult::Type::NUM, "active", "Requests being executed"},
+                                    {RPCResult::Type::NUM, "max_active", "Maximum number of workers the lane may occupy"},
+                                }},
+                            }},
+                        }},
                         {RPCResult::Type::STR, "logpath", "The complete file path to the debug log"},
                     }
                 },
@@ -226,8 +352,40 @@ static UniValue getrpcinfo(const JSONRPCRequest& request)
         active_commands.push_back(entry);
     }
 
+    UniValue methods(UniValue::VOBJ);
+    for (const auto& entry : g_rpc_server_info.method_stats) {
+        const RPCMethodStats& stats = entry.second;
+        UniValue method(UniValue::VOBJ);
+        method.pushKV("calls", stats.calls);
+        method.pushKV("queue_time_avg", stats.queue_time / (int64_t)stats.calls);
+        method.pushKV("queue_time_max", stats.queue_time_max);
+        method.pushKV("exec_time_avg", stats.exec_time / (int64_t)stats.calls);
+        method.pushKV("exec_time_max", stats.exec_time_max);
+        methods.pushKV(entry.first, method);
+    }
+
     UniValue result(UniValue::VOBJ);
     result.pushKV("active_commands", active_commands);
+    result.pushKV("methods", methods);
+
+    HTTPWorkQueueInfo queue_info;
+    if (GetHTTPWorkQueueInfo(queue_info)) {
+        UniValue work_queue(UniValue::VOBJ);
+        work_queue.pushKV("threads", queue_info.threads);
+        work_queue.pushKV("idle_threads", queue_info.idle_threads);
+        work_queue.pushKV("min_threads", queue_info.min_threads);
+        work_queue.pushKV("max_threads", queue_info.max_threads);
+        UniValue lanes(UniValue::VOBJ);
+        for (int i = 0; i < HTTP_PRIORITY_COUNT; ++i) {
+            UniValue lane(UniValue::VOBJ);
+            lane.pushKV("queued", (uint64_t)queue_info.lanes[i].queued);
+            lane.pushKV("active", (uint64_t)queue_info.lanes[i].active);
+            lane.pushKV("max_active", (uint64_t)queue_info.lanes[i].max_active);
+            lanes.pushKV(HTTPPriorityString(HTTPPriority(i)), lane);
+        }
+        work_queue.pushKV("lanes", lanes);
+        result.pushKV("work_queue", work_queue);
+    }
 
     const std::string path = LogInstance().m_file_path.string();
     UniValue log_path(UniValue::VSTR, path);
@@ -286,6 +444,7 @@ void StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
     g_rpc_running = true;
+    g_rpc_batch_executor.Start(gArgs.GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS));
     g_rpcSignals.Started();
 }
 
@@ -300,6 +459,7 @@ void StopRPC()
 {
     LogPrint(BCLog::RPC, "Stopping RPC\n");
     WITH_LOCK(g_deadline_timers_mutex, deadlineTimers.clear());
+    g_rpc_batch_executor.Stop();
     DeleteAuthCookie();
     g_rpcSignals.Stopped();
 }
@@ -337,7 +497,7 @@ bool IsDeprecatedRPCEnabled(const std::string& method)
     return find(enabled_methods.begin(), enabled_methods.end(), method) != enabled_methods.end();
 }
 
-static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
+static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const JSONValue& req)
 {
     UniValue rpc_result(UniValue::VOBJ);
 
@@ -360,12 +520,57 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+static bool IsParallelSafeRequest(const JSONValue& req)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    const JSONValue method = req["method"];
+    return method.isStr() && tableRPC.isParallelSafe(method.get_str());
+}
+
+/** Execute vReq[begin, end) concurrently, storing the replies at the same positions */
+static void JSONRPCExecParallel(const JSONRPCRequest& jreq, const std::vector<JSONValue>& vReq, size_t begin, size_t end, std::vector<UniValue>& results)
+{
+    Mutex mutex;
+    std::condition_variable cond;
+    size_t remaining = end - begin - 1;
+
+    // The calling thread takes the last call itself rather than sitting idle
+    for (size_t i = begin; i + 1 < end; ++i) {
+        g_rpc_batch_executor.Submit([&, i] {
+            results[i] = JSONRPCExecOne(jreq, vReq[i]);
+            LOCK(mutex);
+            if (--remaining == 0) cond.notify_all();
+        });
+    }
+    results[end - 1] = JSONRPCExecOne(jreq, vReq[end - 1]);
+
+    WAIT_LOCK(mutex, lock);
+    while (remaining > 0) cond.wait(lock);
+}
 
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const JSONValue& batch)
+{
+    const std::vector<JSONValue> vReq = batch.getValues();
+    // Runs of consecutive parallel-safe calls are spread over the batch
+    // executor. Every other call, in particular anything touching a wallet,
+    // is a barrier: it starts after all calls before it have finished and
+    // completes before any call after it starts.
+    std::vector<UniValue> results(vReq.size());
+    size_t reqIdx = 0;
+    while (reqIdx < vReq.size()) {
+        size_t end = reqIdx;
+        while (end < vReq.size() && IsParallelSafeRequest(vReq[end])) ++end;
+        if (end - reqIdx > 1 && g_rpc_batch_executor.IsRunning()) {
+            JSONRPCExecParallel(jreq, vReq, reqIdx, end, results);
+            reqIdx = end;
+        } else {
+            end = std::max(end, reqIdx + 1);
+            for (; reqIdx < end; reqIdx++)
+                results[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+        }
+    }
+
+    UniValue ret(UniValue::VARR);
+    ret.push_backV(results);
     return ret.write() + "\n";
 }
 
@@ -445,7 +650,7 @@ static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& req
 {
     try
     {
-        RPCCommandExecution execution(request.strMethod);
+        RPCCommandExecution execution(request.strMethod, request.queueTime);
         // Execute, convert arguments to array if necessary
         if (request.params.isObject()) {
             return command.actor(transformNamedArguments(request, command.argNames), result, last_handler);
@@ -459,6 +664,16 @@ static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& req
     }
 }
 
+bool CRPCTable::isParallelSafe(const std::string& method) const
+{
+    auto it = mapCommands.find(method);
+    if (it == mapCommands.end() || it->second.empty()) return false;
+    for (const CRPCCommand* command : it->second) {
+        if (!command->parallel_safe) return false;
+    }
+    return true;
+}
+
 std::vector<std::string> CRPCTable::listCommands() const
 {
     std::vector<std::string> commandList;
@@ -17,6 +17,10 @@
 #include <univalue.h>
 
 static const unsigned int DEFAULT_RPC_SERIALIZE_VERSION = 0;
+//! Threads executing the read-only calls of batch requests in parallel; 0 disables
+static const int DEFAULT_RPC_BATCH_THREADS = 4;
+//! Maximum number of batch calls queued for those threads before callers run them inline
+static const size_t MAX_RPC_BATCH_QUEUE = 1024;
 
 class CRPCCommand;
 
@@ -92,17 +96,17 @@ public:
     using Actor = std::function<bool(const JSONRPCRequest& request, UniValue& result, bool last_handler)>;
 
     //! Constructor taking Actor callback supporting multiple handlers.
-    CRPCCommand(std::string category, std::string name, Actor actor, std::vector<std::string> args, intptr_t unique_id)
+    CRPCCommand(std::string category, std::string name, Actor actor, std::vector<std::string> args, intptr_t unique_id, bool parallel_safe = false)
         : category(std::move(category)), name(std::move(name)), actor(std::move(actor)), argNames(std::move(args)),
-          unique_id(unique_id)
+          unique_id(unique_id), parallel_safe(parallel_safe)
     {
     }
 
     //! Simplified constructor taking plain rpcfn_type function pointer.
-    CRPCCommand(const char* category, const char* name, rpcfn_type fn, std::initializer_list<const char*> args)
+    CRPCCommand(const char* category, const char* name, rpcfn_type fn, std::initializer_list<const char*> args, bool parallel_safe = false)
         : CRPCCommand(category, name,
                       [fn](const JSONRPCRequest& request, UniValue& result, bool) { result = fn(request); return true; },
-                      {args.begin(), args.end()}, intptr_t(fn))
+                      {args.begin(), args.end()}, intptr_t(fn), parallel_safe)
     {
     }
 
@@ -111,6 +115,9 @@ public:
     Actor actor;
     std::vector<std::string> argNames;
     intptr_t unique_id;
+    //! Whether the command only reads state and may run concurrently with
+    //! other parallel-safe commands of the same batch request.
+    bool parallel_safe;
 };
 
 /**
@@ -138,6 +145,11 @@ public:
     */
     std::vector<std::string> listCommands() const;
 
+    /**
+     * Whether every handler registered for a method is parallel-safe.
+     * Unknown methods are not.
+     */
+    bool isParallelSafe(const std::string& method) const;
 
     /**
      * Appends a CRPCCommand to the dispatch table.
@@ -162,7 +174,7 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const JSONValue& vReq);
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
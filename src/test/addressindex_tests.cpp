@@ -0,0 +1,208 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+#include <key.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <limits>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+//! Transaction spending the first output of a pay-to-pubkey coinbase to dest_script
+static CMutableTransaction SpendCoinbase(const CKey& key, const CTransaction& coinbase, const CScript& dest_script)
+{
+    const CScript coinbase_script = CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(coinbase.GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = coinbase.vout[0].nValue - CENT;
+    spend.vout[0].scriptPubKey = dest_script;
+    std::vector<unsigned char> sig;
+    const uint256 sighash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(key.Sign(sighash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+    return spend;
+}
+
+static void WaitUntilSynced(AddressIndex& address_index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!address_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_initial_sync, TestChain100Setup)
+{
+    AddressIndex address_index(1 << 20, true);
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const uint256 coinbase_hash = AddressIndex::GetScriptHash(coinbase_script);
+    const int max_height = std::numeric_limits<int>::max();
+
+    std::vector<AddressOutput> outputs;
+    std::vector<AddressSpend> spends;
+    BOOST_CHECK(address_index.FindOutputs(coinbase_hash, 0, max_height, 1000, outputs));
+    BOOST_CHECK(outputs.empty());
+
+    address_index.Start();
+
+    // Allow the index to catch up with the block index.
+    WaitUntilSynced(address_index);
+
+    // Every coinbase that was in the chain before the index started is found, in
+    // order. The first one is in block 1.
+    BOOST_CHECK(address_index.FindOutputs(coinbase_hash, 0, max_height, 1000, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), m_coinbase_txns.size());
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        BOOST_CHECK(outputs[i].outpoint == COutPoint(m_coinbase_txns[i]->GetHash(), 0));
+        BOOST_CHECK_EQUAL(outputs[i].amount, m_coinbase_txns[i]->vout[0].nValue);
+        BOOST_CHECK(!outputs[i].IsSpent());
+    }
+
+    // Height ranges and limits
+    outputs.clear();
+    BOOST_CHECK(address_index.FindOutputs(coinbase_hash, 10, 19, 1000, outputs));
+    BOOST_CHECK_EQUAL(outputs.size(), 10U);
+    BOOST_CHECK_EQUAL(outputs.front().height, 10);
+    outputs.clear();
+    BOOST_CHECK(address_index.FindOutputs(coinbase_hash, 0, max_height, 5, outputs));
+    BOOST_CHECK_EQUAL(outputs.size(), 5U);
+
+    // Spend the first coinbase to a new script in a new block.
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript dest_script = GetScriptForDestination(PKHash(key.GetPubKey()));
+    const uint256 dest_hash = AddressIndex::GetScriptHash(dest_script);
+    const CMutableTransaction spend = SpendCoinbase(coinbaseKey, *m_coinbase_txns[0], dest_script);
+
+    const CBlock block = CreateAndProcessBlock({spend}, coinbase_script);
+    const int spend_height = WITH_LOCK(cs_main, return ::ChainActive().Height());
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+
+    outputs.clear();
+    BOOST_CHECK(address_index.FindOutputs(coinbase_hash, 1, 1, 1000, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK(outputs[0].IsSpent());
+    BOOST_CHECK(outputs[0].spent_by == COutPoint(spend.GetHash(), 0));
+    BOOST_CHECK_EQUAL(outputs[0].spent_height, spend_height);
+
+    // The spent output is skipped and does not count towards the limit.
+    outputs.clear();
+    BOOST_CHECK(address_index.FindUnspentOutputs(coinbase_hash, 1, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK(outputs[0].outpoint == COutPoint(m_coinbase_txns[1]->GetHash(), 0));
+    outputs.clear();
+    BOOST_CHECK(address_index.FindUnspentOutputs(coinbase_hash, 1000, outputs));
+    BOOST_CHECK_EQUAL(outputs.size(), m_coinbase_txns.size());
+
+    BOOST_CHECK(address_index.FindSpends(coinbase_hash, 0, max_height, 1000, spends));
+    BOOST_REQUIRE_EQUAL(spends.size(), 1U);
+    BOOST_CHECK_EQUAL(spends[0].height, spend_height);
+    BOOST_CHECK(spends[0].txid == spend.GetHash());
+    BOOST_CHECK(spends[0].prevout == spend.vin[0].prevout);
+    BOOST_CHECK_EQUAL(spends[0].amount, m_coinbase_txns[0]->vout[0].nValue);
+
+    outputs.clear();
+    BOOST_CHECK(address_index.FindOutputs(dest_hash, 0, max_height, 1000, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK_EQUAL(outputs[0].height, spend_height);
+    BOOST_CHECK(outputs[0].outpoint == COutPoint(block.vtx[1]->GetHash(), 0));
+    outputs.clear();
+    BOOST_CHECK(address_index.FindUnspentOutputs(dest_hash, 1000, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK_EQUAL(outputs[0].amount, spend.vout[0].nValue);
+
+    // Disconnecting the block removes its records.
+    {
+        BlockValidationState state;
+        CBlockIndex* tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+        BOOST_CHECK(InvalidateBlock(state, Params(), tip));
+    }
+    SyncWithValidationInterfaceQueue();
+    outputs.clear();
+    spends.clear();
+    BOOST_CHECK(address_index.FindOutputs(coinbase_hash, 1, 1, 1000, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK(!outputs[0].IsSpent());
+    BOOST_CHECK(address_index.FindSpends(coinbase_hash, 0, max_height, 1000, spends));
+    BOOST_CHECK(spends.empty());
+
+    // The spent output is unspent again, and the output of the spend is gone.
+    outputs.clear();
+    BOOST_CHECK(address_index.FindUnspentOutputs(coinbase_hash, 1, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1U);
+    BOOST_CHECK(outputs[0].outpoint == COutPoint(m_coinbase_txns[0]->GetHash(), 0));
+    BOOST_CHECK_EQUAL(outputs[0].amount, m_coinbase_txns[0]->vout[0].nValue);
+    outputs.clear();
+    BOOST_CHECK(address_index.FindUnspentOutputs(dest_hash, 1000, outputs));
+    BOOST_CHECK(outputs.empty());
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    address_index.Stop();
+
+    // addressindex job may be scheduled, so stop scheduler before destructing
+    m_node.scheduler->stop();
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+
+    // Rest of shutdown sequence and destructors happen in ~TestingSetup()
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_bulk_sync, TestChain100Setup)
+{
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    const uint256 coinbase_hash = AddressIndex::GetScriptHash(coinbase_script);
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript dest_script = GetScriptForDestination(PKHash(key.GetPubKey()));
+    const uint256 dest_hash = AddressIndex::GetScriptHash(dest_script);
+
+    // Spend a coinbase deep enough in the chain to be indexed in parallel,
+    // and another one in a block the index syncs block by block.
+    const CMutableTransaction bulk_spend = SpendCoinbase(coinbaseKey, *m_coinbase_txns[0], dest_script);
+    CreateAndProcessBlock({bulk_spend}, coinbase_script);
+    for (int i = 0; i < 100; ++i) {
+        CreateAndProcessBlock({}, coinbase_script);
+    }
+    const CMutableTransaction spend = SpendCoinbase(coinbaseKey, *m_coinbase_txns[1], dest_script);
+    CreateAndProcessBlock({spend}, coinbase_script);
+    const int tip_height = WITH_LOCK(cs_main, return ::ChainActive().Height());
+
+    AddressIndex address_index(1 << 20, true);
+    address_index.Start();
+    WaitUntilSynced(address_index);
+
+    // Every coinbase is unspent but the two that were spent.
+    std::vector<AddressOutput> outputs;
+    BOOST_CHECK(address_index.FindUnspentOutputs(coinbase_hash, 1000, outputs));
+    BOOST_CHECK_EQUAL(outputs.size(), size_t(tip_height - 2));
+    for (const AddressOutput& output : outputs) {
+        BOOST_CHECK(output.outpoint != bulk_spend.vin[0].prevout);
+        BOOST_CHECK(output.outpoint != spend.vin[0].prevout);
+    }
+    outputs.clear();
+    BOOST_CHECK(address_index.FindUnspentOutputs(dest_hash, 1000, outputs));
+    BOOST_REQUIRE_EQUAL(outputs.size(), 2U);
+    BOOST_CHECK(outputs[0].outpoint == COutPoint(bulk_spend.GetHash(), 0));
+    BOOST_CHECK(outputs[1].outpoint == COutPoint(spend.GetHash(), 0));
+
+    address_index.Stop();
+    m_node.scheduler->stop();
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/blockstatsindex.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <util/check.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockstatsindex_tests, BasicTestingSetup)
+
+static CMutableTransaction SpendingTx(const uint256& prev_hash, uint32_t time)
+{
+    CMutableTransaction tx;
+    tx.nTime = time;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(prev_hash, 0);
+    return tx;
+}
+
+BOOST_AUTO_TEST_CASE(compute_block_stats)
+{
+    const uint32_t block_time = 1600000000;
+    const CScript script = CScript() << OP_TRUE;
+
+    CMutableTransaction coinbase;
+    coinbase.nTime = block_time;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].SetEmpty();
+
+    // A coinstake staking 100 coins that are ten days old, with an empty first output
+    CMutableTransaction coinstake = SpendingTx(uint256S("01"), block_time);
+    coinstake.vout.resize(2);
+    coinstake.vout[0].SetEmpty();
+    coinstake.vout[1] = CTxOut(101 * COIN, script);
+
+    CMutableTransaction spend = SpendingTx(uint256S("02"), block_time);
+    spend.vout.emplace_back(5 * COIN - CENT, script);
+
+    CBlock block;
+    block.vtx = {MakeTransactionRef(coinbase), MakeTransactionRef(coinstake), MakeTransactionRef(spend)};
+    BOOST_CHECK(block.IsProofOfStake());
+
+    CBlockUndo block_undo;
+    block_undo.vtxundo.resize(2);
+    block_undo.vtxundo[0].vprevout.emplace_back(CTxOut(100 * COIN, script), 1, false, false, block_time - 10 * 24 * 60 * 60);
+    block_undo.vtxundo[1].vprevout.emplace_back(CTxOut(5 * COIN, script), 1, false, false, block_time - 60);
+
+    const BlockStats stats = ComputeBlockStats(block, block_undo);
+    BOOST_CHECK_EQUAL(stats.txs, 3);
+    BOOST_CHECK_EQUAL(stats.ins, 2);
+    BOOST_CHECK_EQUAL(stats.outs, 4);
+    BOOST_CHECK_EQUAL(stats.fee_txs, 1);
+    BOOST_CHECK_EQUAL(stats.totalfee, CENT);
+    BOOST_CHECK_EQUAL(stats.minfee, CENT);
+    BOOST_CHECK_EQUAL(stats.maxfee, CENT);
+    BOOST_CHECK_EQUAL(stats.medianfee, CENT);
+    BOOST_CHECK_EQUAL(stats.total_out, 101 * COIN + 5 * COIN - CENT);
+    BOOST_CHECK_EQUAL(stats.stake_reward, COIN);
+    BOOST_CHECK_EQUAL(stats.coin_age, 1000U);
+    BOOST_CHECK_EQUAL(stats.mintxsize, (int64_t)CTransaction(spend).GetTotalSize());
+
+    // The statistics survive a round trip through the index database format
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << stats;
+    BlockStats read;
+    ss >> read;
+    BOOST_CHECK_EQUAL(read.totalfee, stats.totalfee);
+    BOOST_CHECK_EQUAL(read.utxo_size_inc, stats.utxo_size_inc);
+    BOOST_CHECK_EQUAL(read.coin_age, stats.coin_age);
+}
+
+BOOST_AUTO_TEST_CASE(compute_block_stats_empty)
+{
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 50 * COIN;
+
+    CBlock block;
+    block.vtx = {MakeTransactionRef(coinbase)};
+
+    const BlockStats stats = ComputeBlockStats(block, CBlockUndo());
+    BOOST_CHECK_EQUAL(stats.txs, 1);
+    BOOST_CHECK_EQUAL(stats.ins, 0);
+    BOOST_CHECK_EQUAL(stats.total_out, 0);
+    BOOST_CHECK_EQUAL(stats.minfee, 0);
+    BOOST_CHECK_EQUAL(stats.mintxsize, 0);
+    BOOST_CHECK_EQUAL(stats.stake_reward, 0);
+    BOOST_CHECK_GT(stats.utxo_size_inc, 0);
+}
+
+BOOST_AUTO_TEST_CASE(compute_block_stats_bad_fee)
+{
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+
+    // Undo data giving the spend fewer coins in than out
+    CMutableTransaction spend = SpendingTx(uint256S("01"), 0);
+    spend.vout.emplace_back(5 * COIN, CScript() << OP_TRUE);
+
+    CBlock block;
+    block.vtx = {MakeTransactionRef(coinbase), MakeTransactionRef(spend)};
+    CBlockUndo block_undo;
+    block_undo.vtxundo.resize(1);
+    block_undo.vtxundo[0].vprevout.emplace_back(CTxOut(COIN, CScript() << OP_TRUE), 1, false, false, 0);
+
+    BOOST_CHECK_THROW(ComputeBlockStats(block, block_undo), NonFatalCheckError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsondocument.h>
+#include <test/util/setup_common.h>
+
+#include <univalue.h>
+
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(jsondocument_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(jsondocument_matches_univalue)
+{
+    const std::vector<std::string> inputs{
+        "", " ", "1", "-1", "01", "1.", "1e", "1.5e+5", "-0.25E-3", "null", "nul", "truex", "false",
+        "[]", "{}", " [ ] ", "[1,]", "{\"a\":1,}", "[1 2]", "{\"a\" 1}", "{1:2}", "[[[]]]", "]", "[}", "{]",
+        "\"plain ascii string longer than a word\"", "\"a\\u0041\\n\\t\\\\\\\"\"", "\"\\ud834\\udd1e\"", "\"\\ud834\"",
+        "\"\\u00e9\"", "\"\xc3\xa9\"", "\"\xc3\"", "\"\x01\"", "\"\\x\"", "\"unterminated",
+        "{\"a\":1,\"a\":2}", "{\"method\":\"getblock\",\"params\":[\"00ff\",2],\"id\":7}",
+        "[{\"a\":[1,{\"b\":null}]},true,\"x\",-5]",
+    };
+    for (const std::string& input : inputs) {
+        UniValue expected;
+        const bool expected_ok = expected.read(input);
+        JSONDocument doc;
+        BOOST_CHECK_EQUAL(doc.Parse(input), expected_ok);
+        if (expected_ok) {
+            BOOST_CHECK_EQUAL(doc.Root().ToUniValue().write(), expected.write());
+        } else {
+            BOOST_CHECK(doc.Root().isNull());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(jsondocument_depth)
+{
+    JSONDocument doc;
+    BOOST_CHECK(doc.Parse(std::string(512, '[') + std::string(512, ']')));
+    BOOST_CHECK(!doc.Parse(std::string(513, '[') + std::string(513, ']')));
+}
+
+BOOST_AUTO_TEST_CASE(jsondocument_accessors)
+{
+    const std::string json = "{\"method\":\"getblock\",\"params\":[\"h\\u0041sh\",2,true,1.5],\"id\":null,\"method\":\"dup\"}";
+    JSONDocument doc;
+    BOOST_REQUIRE(doc.Parse(json));
+    const JSONValue root = doc.Root();
+    BOOST_CHECK(root.isObject());
+    BOOST_CHECK_EQUAL(root.size(), 4U);
+    BOOST_CHECK_EQUAL(root.getKey(1), "params");
+    BOOST_CHECK(root.exists("id"));
+    BOOST_CHECK(!root.exists("missing"));
+    BOOST_CHECK(root["missing"].isNull());
+    BOOST_CHECK(root["id"].isNull());
+    // The first of duplicate keys wins, as with find_value()
+    BOOST_CHECK(root["method"].equals("getblock"));
+    BOOST_CHECK_EQUAL(root[3].get_str(), "dup");
+
+    const JSONValue params = root["params"];
+    BOOST_CHECK(params.isArray());
+    BOOST_CHECK_EQUAL(params.size(), 4U);
+    BOOST_CHECK_EQUAL(params[0].get_str(), "hAsh");
+    BOOST_CHECK_EQUAL(params[1].get_int(), 2);
+    BOOST_CHECK_EQUAL(params[1].get_int64(), 2);
+    BOOST_CHECK(params[2].get_bool());
+    BOOST_CHECK_EQUAL(params[3].get_real(), 1.5);
+    BOOST_CHECK(params[4].isNull());
+    const std::vector<JSONValue> values = params.getValues();
+    BOOST_REQUIRE_EQUAL(values.size(), 4U);
+    BOOST_CHECK(values[0].equals("hAsh"));
+    BOOST_CHECK(values[3].isNum());
+    BOOST_CHECK(root.getValues()[1].isArray());
+
+    BOOST_CHECK_THROW(params[0].get_int(), std::runtime_error);
+    BOOST_CHECK_THROW(params[1].get_str(), std::runtime_error);
+    BOOST_CHECK_THROW(params.getKey(0), std::runtime_error);
+    BOOST_CHECK_THROW(params[3].get_int(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(jsondocument_reuse)
+{
+    JSONDocument doc;
+    BOOST_CHECK(doc.Parse("[1,2,3]"));
+    BOOST_CHECK(!doc.Parse("[1,2,"));
+    BOOST_CHECK(doc.Root().isNull());
+    BOOST_CHECK(doc.Parse("{\"k\":\"v\"}"));
+    BOOST_CHECK(doc.Root()["k"].equals("v"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonstream.h>
+#include <test/util/setup_common.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(jsonstream_tests, BasicTestingSetup)
+
+static UniValue SampleDocument()
+{
+    UniValue inner(UniValue::VOBJ);
+    inner.pushKV("empty_arr", UniValue(UniValue::VARR));
+    inner.pushKV("empty_obj", UniValue(UniValue::VOBJ));
+    inner.pushKV("escaped \"key\"\n", "tab\there");
+    UniValue arr(UniValue::VARR);
+    for (int i = 0; i < 100; ++i) {
+        arr.push_back(i);
+        arr.push_back(i % 2 == 0);
+        arr.push_back(NullUniValue);
+        arr.push_back(inner);
+    }
+    UniValue doc(UniValue::VOBJ);
+    doc.pushKV("name", "stream");
+    doc.pushKV("amount", 1.5);
+    doc.pushKV("values", arr);
+    doc.pushKV("inner", inner);
+    return doc;
+}
+
+BOOST_AUTO_TEST_CASE(stream_matches_univalue)
+{
+    const UniValue doc = SampleDocument();
+    for (size_t chunk_size : {1, 7, 64, 1 << 20}) {
+        std::string out;
+        size_t chunks = 0;
+        JSONStreamWriter writer([&](const std::string& chunk) {
+            BOOST_CHECK(chunk.size() >= chunk_size);
+            out += chunk;
+            ++chunks;
+            return true;
+        }, chunk_size);
+        writer.Value(doc);
+        out += writer.Finish();
+        BOOST_CHECK_EQUAL(out, doc.write());
+        BOOST_CHECK(!writer.Failed());
+        if (chunk_size < 64) BOOST_CHECK(chunks > 1);
+        if (chunk_size == 1 << 20) BOOST_CHECK_EQUAL(chunks, 0U);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(stream_incremental)
+{
+    std::string out;
+    JSONStreamWriter writer([&](const std::string& chunk) { out += chunk; return true; }, 16);
+    writer.BeginObject();
+    writer.Pair("a", 1);
+    writer.Key("list");
+    writer.BeginArray();
+    writer.Value("x");
+    writer.BeginObject();
+    writer.EndObject();
+    writer.Value(UniValue(UniValue::VARR));
+    writer.EndArray();
+    writer.Pair("b", false);
+    writer.EndObject();
+    out += writer.Finish();
+    BOOST_CHECK_EQUAL(out, "{\"a\":1,\"list\":[\"x\",{},[]],\"b\":false}");
+}
+
+BOOST_AUTO_TEST_CASE(stream_sink_failure)
+{
+    size_t calls = 0;
+    JSONStreamWriter writer([&](const std::string&) { ++calls; return false; }, 4);
+    writer.BeginArray();
+    for (int i = 0; i < 100; ++i) {
+        writer.Value("abcdef");
+    }
+    BOOST_CHECK(writer.Failed());
+    writer.EndArray();
+    BOOST_CHECK_EQUAL(calls, 1U);
+    BOOST_CHECK(writer.Finish().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
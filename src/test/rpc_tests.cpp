@@ -4,9 +4,11 @@
 
 #include <rpc/server.h>
 #include <rpc/client.h>
+#include <rpc/jsondocument.h>
 #include <rpc/util.h>
 
 #include <core_io.h>
+#include <httprpc.h>
 #include <interfaces/chain.h>
 #include <node/context.h>
 #include <test/util/setup_common.h>
@@ -335,4 +337,104 @@ BOOST_AUTO_TEST_CASE(rpc_convert_values_generatetoaddress)
     BOOST_CHECK_EQUAL(result[2].get_int(), 9);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_parse_document)
+{
+    const std::string body = "{\"id\": [1, \"a\"], \"method\": \"getblockhash\", \"params\": {\"height\": 1}}";
+    JSONDocument doc;
+    BOOST_REQUIRE(doc.Parse(body));
+    UniValue value;
+    BOOST_REQUIRE(value.read(body));
+
+    JSONRPCRequest from_doc, from_value;
+    from_doc.parse(doc.Root());
+    from_value.parse(value);
+    BOOST_CHECK_EQUAL(from_doc.strMethod, "getblockhash");
+    BOOST_CHECK_EQUAL(from_doc.id.write(), from_value.id.write());
+    BOOST_CHECK_EQUAL(from_doc.params.write(), from_value.params.write());
+
+    // Same errors as for a UniValue request
+    for (const std::string bad : {"1", "{}", "{\"method\": 1}", "{\"method\": \"help\", \"params\": 1}"}) {
+        BOOST_REQUIRE(doc.Parse(bad));
+        BOOST_CHECK_THROW(from_doc.parse(doc.Root()), UniValue);
+    }
+    const std::string no_params = "{\"method\": \"help\"}";
+    BOOST_REQUIRE(doc.Parse(no_params));
+    from_doc.parse(doc.Root());
+    BOOST_CHECK(from_doc.params.isArray() && from_doc.params.empty());
+}
+
+BOOST_AUTO_TEST_CASE(rpc_request_priority)
+{
+    auto priority = [](const std::string& body) {
+        return JSONRPCRequestPriority(body.data(), body.size());
+    };
+    BOOST_CHECK(priority("{\"method\": \"getblockhash\"}") == HTTPPriority::HIGH);
+    BOOST_CHECK(priority("{\"method\": \"sendrawtransaction\"}") == HTTPPriority::NORMAL);
+    BOOST_CHECK(priority("{\"method\": \"rescanblockchain\"}") == HTTPPriority::LOW);
+    BOOST_CHECK(priority("[{\"method\": \"getblockhash\"}, {\"method\": \"decodescript\"}]") == HTTPPriority::HIGH);
+    BOOST_CHECK(priority("[{\"method\": \"getblockhash\"}, {\"method\": \"sendrawtransaction\"}]") == HTTPPriority::NORMAL);
+    BOOST_CHECK(priority("[{\"method\": \"scantxoutset\"}, {\"method\": \"getblockhash\"}]") == HTTPPriority::LOW);
+
+    // Bodies that are valid JSON but not requests must not throw
+    for (const std::string body : {"1", "\"x\"", "null", "true", "{}", "{\"method\": 1}", "[1, \"x\"]", "[[{\"method\": \"getblockhash\"}]]", "[{\"method\": null}]"}) {
+        BOOST_CHECK(priority(body) == HTTPPriority::NORMAL);
+    }
+
+    // Only the method members of the request objects count
+    BOOST_CHECK(priority("{\"id\": \"method\", \"method\": \"getblockhash\", \"params\": [\"method\", {\"method\": \"rescanblockchain\"}]}") == HTTPPriority::HIGH);
+    BOOST_CHECK(priority(" { \"params\" : [\"a\\\"b\"] , \"method\" : \"rescanblockchain\" } ") == HTTPPriority::LOW);
+    BOOST_CHECK(priority("[{\"method\": \"getblockhash\"}, {\"id\": 1}]") == HTTPPriority::NORMAL);
+    BOOST_CHECK(priority("{\"method\": \"getblock\\u0068ash\"}") == HTTPPriority::NORMAL);
+
+    // Bodies that are not valid JSON
+    for (const std::string body : {"", "{", "{\"method\": \"getblockhash\"", "[{\"method\": \"getblockhash\"}", "{\"method\": \"getblockhash}"}) {
+        BOOST_CHECK(priority(body) == HTTPPriority::NORMAL);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rpc_batch_parallel)
+{
+    BOOST_CHECK(tableRPC.isParallelSafe("getblockhash"));
+    BOOST_CHECK(tableRPC.isParallelSafe("decodescript"));
+    BOOST_CHECK(!tableRPC.isParallelSafe("sendrawtransaction"));
+    BOOST_CHECK(!tableRPC.isParallelSafe("no_such_method"));
+
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < 50; ++i) {
+        UniValue req(UniValue::VOBJ);
+        // A non parallel-safe call every ten requests splits the batch into runs
+        req.pushKV("method", i % 10 == 5 ? "createrawtransaction" : "decodescript");
+        UniValue params(UniValue::VARR);
+        if (i % 10 == 5) {
+            params.push_back(UniValue(UniValue::VARR));
+            params.push_back(UniValue(UniValue::VOBJ));
+        } else {
+            params.push_back(i % 7 == 0 ? "not_hex" : "51");
+        }
+        req.pushKV("params", params);
+        req.pushKV("id", i);
+        batch.push_back(req);
+    }
+
+    const std::string body = batch.write();
+    JSONDocument doc;
+    BOOST_REQUIRE(doc.Parse(body));
+    JSONRPCRequest jreq;
+    const std::string sequential = JSONRPCExecBatch(jreq, doc.Root());
+    StartRPC();
+    const std::string parallel = JSONRPCExecBatch(jreq, doc.Root());
+    InterruptRPC();
+    StopRPC();
+    BOOST_CHECK_EQUAL(parallel, sequential);
+
+    UniValue replies;
+    BOOST_REQUIRE(replies.read(parallel));
+    BOOST_REQUIRE_EQUAL(replies.size(), 50U);
+    for (int i = 0; i < 50; ++i) {
+        BOOST_CHECK_EQUAL(find_value(replies[i], "id").get_int(), i);
+        BOOST_CHECK_EQUAL(find_value(replies[i], "error").isNull(), i % 7 != 0 || i % 10 == 5);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
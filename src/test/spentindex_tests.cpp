@@ -0,0 +1,88 @@
+// Copyright (c) 2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/spentindex.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <undo.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(spentindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(spentindex_initial_sync, TestChain100Setup)
+{
+    SpentIndex spent_index(1 << 20, true);
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Spend the first coinbase before the index is started.
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(m_coinbase_txns[0]->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue - CENT;
+    spend.vout[0].scriptPubKey = coinbase_script;
+    std::vector<unsigned char> sig;
+    const uint256 sighash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_REQUIRE(coinbaseKey.Sign(sighash, sig));
+    sig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << sig;
+
+    CreateAndProcessBlock({spend}, coinbase_script);
+    const int spend_height = WITH_LOCK(cs_main, return ::ChainActive().Height());
+
+    SpentIndexEntry entry;
+    BOOST_CHECK(!spent_index.FindSpent(spend.vin[0].prevout, entry));
+
+    spent_index.Start();
+
+    // Allow the index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!spent_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    BOOST_REQUIRE(spent_index.FindSpent(spend.vin[0].prevout, entry));
+    BOOST_CHECK(entry.spent_by == COutPoint(spend.GetHash(), 0));
+    BOOST_CHECK_EQUAL(entry.height, spend_height);
+    BOOST_CHECK(entry.prevout.out == m_coinbase_txns[0]->vout[0]);
+    BOOST_CHECK(entry.prevout.IsCoinBase());
+    BOOST_CHECK_EQUAL(entry.prevout.nHeight, 1U);
+
+    // Unspent outputs and coinbases have nothing to report.
+    BOOST_CHECK(!spent_index.FindSpent(COutPoint(m_coinbase_txns[1]->GetHash(), 0), entry));
+    CTxUndo tx_undo;
+    BOOST_CHECK(!spent_index.FindPrevouts(*m_coinbase_txns[1], tx_undo));
+
+    BOOST_REQUIRE(spent_index.FindPrevouts(CTransaction(spend), tx_undo));
+    BOOST_REQUIRE_EQUAL(tx_undo.vprevout.size(), 1U);
+    BOOST_CHECK_EQUAL(tx_undo.vprevout[0].out.nValue, m_coinbase_txns[0]->vout[0].nValue);
+
+    // Disconnecting the block removes its records.
+    {
+        BlockValidationState state;
+        CBlockIndex* tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+        BOOST_CHECK(InvalidateBlock(state, Params(), tip));
+    }
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK(!spent_index.FindSpent(spend.vin[0].prevout, entry));
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    spent_index.Stop();
+
+    // spentindex job may be scheduled, so stop scheduler before destructing
+    m_node.scheduler->stop();
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+
+    // Rest of shutdown sequence and destructors happen in ~TestingSetup()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -108,6 +108,11 @@ bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_v
                 best_waste = curr_waste;
             }
             curr_waste -= (curr_value - actual_target); // Remove the excess value as we will be selecting different coins now
+            // When no input has negative waste, a selection without waste cannot be improved upon. This is common with
+            // many outputs of the same value, which would otherwise use up all tries looking for an equivalent one.
+            if (best_waste == 0 && (utxo_pool.at(0).fee - utxo_pool.at(0).long_term_fee) >= 0) {
+                break;
+            }
             backtrack = true;
         }
 
@@ -166,10 +171,15 @@ bool SelectCoinsBnB(std::vector<OutputGroup>& utxo_pool, const CAmount& target_v
     return true;
 }
 
+/** Bound on the number of groups visited by ApproximateBestSubset, which
+ * lowers its number of iterations for wallets with many small outputs. */
+static const size_t KNAPSACK_MAX_VISITS = 1000000;
+
 static void ApproximateBestSubset(const std::vector<OutputGroup>& groups, const CAmount& nTotalLower, const CAmount& nTargetValue,
                                   std::vector<char>& vfBest, CAmount& nBest, int iterations = 1000)
 {
     std::vector<char> vfIncluded;
+    iterations = std::max<int>(1, std::min<size_t>(iterations, KNAPSACK_MAX_VISITS / std::max<size_t>(1, groups.size())));
 
     vfBest.assign(groups.size(), true);
     nBest = nTotalLower;
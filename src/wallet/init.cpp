@@ -163,7 +163,7 @@ void WalletInit::StartProcess(NodeContext& node) const
                 LogPrintf("No wallet. Staking disabled\n");
             }
             else {
-                GenerateVericoin(true, GetWallets()[0], node.connman.get(), node.mempool);
+                GenerateVericoin(true, node.connman.get(), node.mempool);
             }
         }
     }
@@ -130,7 +130,11 @@ LegacyScriptPubKeyMan& EnsureLegacyScriptPubKeyMan(CWallet& wallet, bool also_cr
     return *spk_man;
 }
 
-static void WalletTxToJSON(interfaces::Chain& chain, interfaces::Chain::Lock& locked_chain, const CWalletTx& wtx, UniValue& entry)
+/**
+ * Describe a wallet transaction from the wallet state alone, without locking
+ * the chain.
+ */
+static void WalletTxToJSON(const CWalletTx& wtx, UniValue& entry)
 {
     int confirms = wtx.GetDepthInMainChain();
     entry.pushKV("confirmations", confirms);
@@ -141,12 +145,9 @@ static void WalletTxToJSON(interfaces::Chain& chain, interfaces::Chain::Lock& lo
         entry.pushKV("blockhash", wtx.m_confirm.hashBlock.GetHex());
         entry.pushKV("blockheight", wtx.m_confirm.block_height);
         entry.pushKV("blockindex", wtx.m_confirm.nIndex);
-        int64_t block_time;
-        bool found_block = chain.findBlock(wtx.m_confirm.hashBlock, nullptr /* block */, &block_time);
-        CHECK_NONFATAL(found_block);
-        entry.pushKV("blocktime", block_time);
+        entry.pushKV("blocktime", wtx.m_confirm.block_time);
     } else {
-        entry.pushKV("trusted", wtx.IsTrusted(locked_chain));
+        entry.pushKV("trusted", wtx.IsTrusted());
     }
     uint256 hash = wtx.GetHash();
     entry.pushKV("txid", hash.GetHex());
@@ -716,7 +717,6 @@ static UniValue getbalance(const JSONRPCRequest& request)
     // the user could have gotten from another RPC command prior to now
     pwallet->BlockUntilSyncedToCurrentChain();
 
-    auto locked_chain = pwallet->chain().lock();
     LOCK(pwallet->cs_wallet);
 
     const UniValue& dummy_value = request.params[0];
@@ -758,7 +758,6 @@ static UniValue getunconfirmedbalance(const JSONRPCRequest &request)
     // the user could have gotten from another RPC command prior to now
     pwallet->BlockUntilSyncedToCurrentChain();
 
-    auto locked_chain = pwallet->chain().lock();
     LOCK(pwallet->cs_wallet);
 
     return ValueFromAmount(pwallet->GetBalance().m_mine_untrusted_pending);
@@ -1248,8 +1247,10 @@ static void PushCoinStakeCategory(UniValue & entry, const CWalletTx &wtx)
  * @param  ret            The UniValue into which the result is stored.
  * @param  filter_ismine  The "is mine" filter flags.
  * @param  filter_label   Optional label string to filter incoming transactions.
+ * @param  skip           Optional number of entries to count down instead of
+ *                        storing them, which saves describing skipped entries.
  */
-static void ListTransactions(interfaces::Chain::Lock& locked_chain, const CWallet* const pwallet, const CWalletTx& wtx, int nMinDepth, bool fLong, UniValue& ret, const isminefilter& filter_ismine, const std::string* filter_label) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+static void ListTransactions(const CWallet* const pwallet, const CWalletTx& wtx, int nMinDepth, bool fLong, UniValue& ret, const isminefilter& filter_ismine, const std::string* filter_label, int* skip = nullptr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
 {
     CAmount nFee;
     std::list<COutputEntry> listReceived;
@@ -1264,6 +1265,10 @@ static void ListTransactions(interfaces::Chain::Lock& locked_chain, const CWalle
     {
         for (const COutputEntry& s : listSent)
         {
+            if (skip && *skip > 0) {
+                --*skip;
+                continue;
+            }
             UniValue entry(UniValue::VOBJ);
             if (involvesWatchonly || (pwallet->IsMine(s.destination) & ISMINE_WATCH_ONLY)) {
                 entry.pushKV("involvesWatchonly", true);
@@ -1281,7 +1286,7 @@ static void ListTransactions(interfaces::Chain::Lock& locked_chain, const CWalle
             entry.pushKV("vout", s.vout);
             entry.pushKV("fee", ValueFromAmount(-nFee));
             if (fLong)
-                WalletTxToJSON(pwallet->chain(), locked_chain, wtx, entry);
+                WalletTxToJSON(wtx, entry);
             entry.pushKV("abandoned", wtx.isAbandoned());
             ret.push_back(entry);
         }
@@ -1299,6 +1304,10 @@ static void ListTransactions(interfaces::Chain::Lock& locked_chain, const CWalle
             if (filter_label && label != *filter_label) {
                 continue;
             }
+            if (skip && *skip > 0) {
+                --*skip;
+                continue;
+            }
             UniValue entry(UniValue::VOBJ);
             if (involvesWatchonly || (pwallet->IsMine(r.destination) & ISMINE_WATCH_ONLY)) {
                 entry.pushKV("involvesWatchonly", true);
@@ -1327,7 +1336,7 @@ static void ListTransactions(interfaces::Chain::Lock& locked_chain, const CWalle
             }
             entry.pushKV("vout", r.vout);
             if (fLong)
-                WalletTxToJSON(pwallet->chain(), locked_chain, wtx, entry);
+                WalletTxToJSON(wtx, entry);
             ret.push_back(entry);
         }
     }
@@ -1440,30 +1449,28 @@ UniValue listtransactions(const JSONRPCRequest& request)
     UniValue ret(UniValue::VARR);
 
     {
-        auto locked_chain = pwallet->chain().lock();
         LOCK(pwallet->cs_wallet);
 
         const CWallet::TxItems & txOrdered = pwallet->wtxOrdered;
 
-        // iterate backwards until we have nCount items to return:
-        for (CWallet::TxItems::const_reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend(); ++it)
+        // iterate backwards until we have skipped nFrom items and have nCount
+        // items to return:
+        int skip = nFrom;
+        for (CWallet::TxItems::const_reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend() && (int)ret.size() < nCount; ++it)
         {
             CWalletTx *const pwtx = (*it).second;
-            ListTransactions(*locked_chain, pwallet, *pwtx, 0, true, ret, filter, filter_label);
-            if ((int)ret.size() >= (nCount+nFrom)) break;
+            ListTransactions(pwallet, *pwtx, 0, true, ret, filter, filter_label, &skip);
         }
     }
 
     // ret is newest to oldest
 
-    if (nFrom > (int)ret.size())
-        nFrom = ret.size();
-    if ((nFrom + nCount) > (int)ret.size())
-        nCount = ret.size() - nFrom;
+    if (nCount > (int)ret.size())
+        nCount = ret.size();
 
     const std::vector<UniValue>& txs = ret.getValues();
     UniValue result{UniValue::VARR};
-    result.push_backV({ txs.rend() - nFrom - nCount, txs.rend() - nFrom }); // Return oldest to newest
+    result.push_backV({ txs.rend() - nCount, txs.rend() }); // Return oldest to newest
     return result;
 }
 
@@ -1569,10 +1576,10 @@ static UniValue listsinceblock(const JSONRPCRequest& request)
     UniValue transactions(UniValue::VARR);
 
     for (const std::pair<const uint256, CWalletTx>& pairWtx : pwallet->mapWallet) {
-        CWalletTx tx = pairWtx.second;
+        const CWalletTx& tx = pairWtx.second;
 
         if (depth == -1 || abs(tx.GetDepthInMainChain()) < depth) {
-            ListTransactions(*locked_chain, pwallet, tx, 0, true, transactions, filter, nullptr /* filter_label */);
+            ListTransactions(pwallet, tx, 0, true, transactions, filter, nullptr /* filter_label */);
         }
     }
 
@@ -1589,7 +1596,7 @@ static UniValue listsinceblock(const JSONRPCRequest& request)
             if (it != pwallet->mapWallet.end()) {
                 // We want all transactions regardless of confirmation count to appear here,
                 // even negative confirmation ones, hence the big negative.
-                ListTransactions(*locked_chain, pwallet, it->second, -100000000, true, removed, filter, nullptr /* filter_label */);
+                ListTransactions(pwallet, it->second, -100000000, true, removed, filter, nullptr /* filter_label */);
             }
         }
         blockId = block.hashPrevBlock;
@@ -1674,9 +1681,6 @@ static UniValue gettransaction(const JSONRPCRequest& request)
     // the user could have gotten from another RPC command prior to now
     pwallet->BlockUntilSyncedToCurrentChain();
 
-    auto locked_chain = pwallet->chain().lock();
-    LOCK(pwallet->cs_wallet);
-
     uint256 hash(ParseHashV(request.params[0], "txid"));
 
     isminefilter filter = ISMINE_SPENDABLE;
@@ -1688,34 +1692,38 @@ static UniValue gettransaction(const JSONRPCRequest& request)
     bool verbose = request.params[2].isNull() ? false : request.params[2].get_bool();
 
     UniValue entry(UniValue::VOBJ);
-    auto it = pwallet->mapWallet.find(hash);
-    if (it == pwallet->mapWallet.end()) {
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or non-wallet transaction id");
-    }
-    const CWalletTx& wtx = it->second;
+    {
+        LOCK(pwallet->cs_wallet);
 
-    CAmount nCredit = wtx.GetCredit(filter);
-    CAmount nDebit = wtx.GetDebit(filter);
-    CAmount nNet = nCredit - nDebit;
-    CAmount nFee = (wtx.IsFromMe(filter) ? wtx.tx->GetValueOut() - nDebit : 0);
+        auto it = pwallet->mapWallet.find(hash);
+        if (it == pwallet->mapWallet.end()) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid or non-wallet transaction id");
+        }
+        const CWalletTx& wtx = it->second;
 
-    entry.pushKV("amount", ValueFromAmount(nNet - nFee));
-    if (wtx.IsFromMe(filter))
-        entry.pushKV("fee", ValueFromAmount(nFee));
+        CAmount nCredit = wtx.GetCredit(filter);
+        CAmount nDebit = wtx.GetDebit(filter);
+        CAmount nNet = nCredit - nDebit;
+        CAmount nFee = (wtx.IsFromMe(filter) ? wtx.tx->GetValueOut() - nDebit : 0);
 
-    WalletTxToJSON(pwallet->chain(), *locked_chain, wtx, entry);
+        entry.pushKV("amount", ValueFromAmount(nNet - nFee));
+        if (wtx.IsFromMe(filter))
+            entry.pushKV("fee", ValueFromAmount(nFee));
 
-    UniValue details(UniValue::VARR);
-    ListTransactions(*locked_chain, pwallet, wtx, 0, false, details, filter, nullptr /* filter_label */);
-    entry.pushKV("details", details);
+        WalletTxToJSON(wtx, entry);
 
-    std::string strHex = EncodeHexTx(*wtx.tx, pwallet->chain().rpcSerializationFlags());
-    entry.pushKV("hex", strHex);
+        UniValue details(UniValue::VARR);
+        ListTransactions(pwallet, wtx, 0, false, details, filter, nullptr /* filter_label */);
+        entry.pushKV("details", details);
 
-    if (verbose) {
-        UniValue decoded(UniValue::VOBJ);
-        TxToUniv(*wtx.tx, uint256(), decoded, false);
-        entry.pushKV("decoded", decoded);
+        std::string strHex = EncodeHexTx(*wtx.tx, pwallet->chain().rpcSerializationFlags());
+        entry.pushKV("hex", strHex);
+
+        if (verbose) {
+            UniValue decoded(UniValue::VOBJ);
+            TxToUniv(*wtx.tx, uint256(), decoded, false);
+            entry.pushKV("decoded", decoded);
+        }
     }
 
     return entry;
@@ -2368,7 +2376,6 @@ static UniValue getbalances(const JSONRPCRequest& request)
     // the user could have gotten from another RPC command prior to now
     wallet.BlockUntilSyncedToCurrentChain();
 
-    auto locked_chain = wallet.chain().lock();
     LOCK(wallet.cs_wallet);
 
     const auto bal = wallet.GetBalance();
@@ -2478,6 +2485,9 @@ static UniValue getwalletinfo(const JSONRPCRequest& request)
                         },
                         {RPCResult::Type::STR_AMOUNT, "newmint", "New mint"},
                         {RPCResult::Type::STR_AMOUNT, "stake", "total of coin being stake"},
+                        {RPCResult::Type::BOOL, "staking_enabled", "whether the coins of this wallet are staked, see setstaking"},
+                        {RPCResult::Type::NUM, "stake_searches", "number of kernel searches over the coins of this wallet since startup"},
+                        {RPCResult::Type::NUM, "stakes_found", "number of proof-of-stake blocks found by this wallet since startup"},
                     }
                 }
             },
@@ -2492,7 +2502,6 @@ static UniValue getwalletinfo(const JSONRPCRequest& request)
     // the user could have gotten from another RPC command prior to now
     pwallet->BlockUntilSyncedToCurrentChain();
 
-    auto locked_chain = pwallet->chain().lock();
     LOCK(pwallet->cs_wallet);
 
     UniValue obj(UniValue::VOBJ);
@@ -2538,6 +2547,9 @@ static UniValue getwalletinfo(const JSONRPCRequest& request)
     {
         obj.pushKV("newmint", ValueFromAmount(pwallet->GetNewMint()));
         obj.pushKV("stake", ValueFromAmount(pwallet->GetStake()));
+        obj.pushKV("staking_enabled", pwallet->m_staking_enabled.load());
+        obj.pushKV("stake_searches", pwallet->m_stake_searches.load());
+        obj.pushKV("stakes_found", pwallet->m_stakes_found.load());
     }
     return obj;
 }
@@ -3584,6 +3596,53 @@ UniValue reservebalance(const JSONRPCRequest& request)
     return obj;
 }
 
+static UniValue setstaking(const JSONRPCRequest& request)
+{
+    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
+    CWallet* const pwallet = wallet.get();
+
+    if (!EnsureWalletIsAvailable(pwallet, request.fHelp)) {
+        return NullUniValue;
+    }
+
+    RPCHelpMan{"setstaking",
+        "\nEnable or disable staking with the coins of this wallet. The staker searches the coins of all\n"
+        "loaded wallets with staking enabled, see stakingstart. Staking is enabled for wallets when they are loaded.\n",
+        {
+            {"enabled", RPCArg::Type::BOOL, RPCArg::Optional::OMITTED, "Whether to stake the coins of this wallet"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+            {
+                {RPCResult::Type::BOOL, "enabled", "Whether the coins of this wallet are staked"},
+                {RPCResult::Type::NUM, "searches", "Number of kernel searches over the coins of this wallet since startup"},
+                {RPCResult::Type::NUM, "found", "Number of proof-of-stake blocks found by this wallet since startup"},
+            }
+        },
+        RPCExamples{
+            "\nStop staking with the coins of this wallet\n"
+          + HelpExampleCli("setstaking", "false")
+          + HelpExampleRpc("setstaking", "false")
+          + "\nShow the staking state of this wallet\n"
+          + HelpExampleCli("setstaking", "")
+        },
+    }.Check(request);
+
+    if( ! Params().IsVericoin() )
+        throw JSONRPCError(RPC_INVALID_REQUEST, "Action impossible on Verium");
+
+    if (!request.params[0].isNull()) {
+        pwallet->m_staking_enabled = request.params[0].get_bool();
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("enabled", pwallet->m_staking_enabled.load());
+    obj.pushKV("searches", pwallet->m_stake_searches.load());
+    obj.pushKV("found", pwallet->m_stakes_found.load());
+
+    return obj;
+}
+
 class DescribeWalletAddressVisitor : public boost::static_visitor<UniValue>
 {
 public:
@@ -4290,6 +4349,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "makekeypair",                      &makekeypair,                   {"prefix"} },
     { "wallet",             "showkeypair",                      &showkeypair,                   {"hexprivkey"} },
     { "wallet",             "reservebalance",                   &reservebalance,                {"reserve", "amount"} },
+    { "wallet",             "setstaking",                       &setstaking,                    {"enabled"} },
 };
 // clang-format on
 
@@ -9,9 +9,13 @@
 #include <util/bip32.h>
 #include <util/strencodings.h>
 #include <util/string.h>
+#include <util/system.h>
 #include <util/translation.h>
 #include <wallet/scriptpubkeyman.h>
 
+#include <atomic>
+#include <thread>
+
 bool LegacyScriptPubKeyMan::GetNewDestination(const OutputType type, CTxDestination& dest, std::string& error)
 {
     LOCK(cs_KeyStore);
@@ -211,37 +215,73 @@ isminetype LegacyScriptPubKeyMan::IsMine(const CScript& script) const
     assert(false);
 }
 
+std::set<CScript> LegacyScriptPubKeyMan::GetScriptPubKeys() const
+{
+    LOCK(cs_KeyStore);
+    std::set<CScript> spks;
+
+    // All keys have at least P2PK and P2PKH
+    for (const auto& key_pair : mapKeys) {
+        const CPubKey& pub = key_pair.second.GetPubKey();
+        spks.insert(GetScriptForRawPubKey(pub));
+        spks.insert(GetScriptForDestination(PKHash(pub)));
+    }
+    for (const auto& key_pair : mapCryptedKeys) {
+        const CPubKey& pub = key_pair.second.first;
+        spks.insert(GetScriptForRawPubKey(pub));
+        spks.insert(GetScriptForDestination(PKHash(pub)));
+    }
+
+    // Segwit versions of keys are in mapScripts, as are P2SH redeem scripts
+    for (const auto& script_pair : mapScripts) {
+        const CScript& script = script_pair.second;
+        if (IsMine(script) == ISMINE_SPENDABLE) {
+            if (!script.IsPayToScriptHash()) {
+                spks.insert(GetScriptForDestination(ScriptHash(script)));
+            }
+            int wit_ver = -1;
+            std::vector<unsigned char> witprog;
+            if (script.IsWitnessProgram(wit_ver, witprog) && wit_ver == 0) {
+                spks.insert(script);
+            }
+        } else {
+            // Multisig scripts are only ours inside P2SH
+            std::vector<std::vector<unsigned char>> sols;
+            if (Solver(script, sols) == TX_MULTISIG) {
+                CScript ms_spk = GetScriptForDestination(ScriptHash(script));
+                if (IsMine(ms_spk) != ISMINE_NO) {
+                    spks.insert(ms_spk);
+                }
+            }
+        }
+    }
+
+    // Watch-only scripts are raw scriptPubKeys, but any script could be imported
+    for (const CScript& script : setWatchOnly) {
+        if (IsMine(script) != ISMINE_NO) spks.insert(script);
+    }
+
+    return spks;
+}
+
 bool LegacyScriptPubKeyMan::CheckDecryptionKey(const CKeyingMaterial& master_key, bool accept_no_keys)
 {
     {
         LOCK(cs_KeyStore);
         assert(mapKeys.empty());
 
-        bool keyPass = mapCryptedKeys.empty(); // Always pass when there are no encrypted keys
-        bool keyFail = false;
+        // A single key tells whether the master key is right. The other keys
+        // are only decrypted when they are first used, see GetKey, so unlocking
+        // does not depend on the number of keys. A key that does not decrypt
+        // then is reported as corruption there.
         CryptedKeyMap::const_iterator mi = mapCryptedKeys.begin();
-        for (; mi != mapCryptedKeys.end(); ++mi)
-        {
-            const CPubKey &vchPubKey = (*mi).second.first;
-            const std::vector<unsigned char> &vchCryptedSecret = (*mi).second.second;
-            CKey key;
-            if (!DecryptKey(master_key, vchCryptedSecret, vchPubKey, key))
-            {
-                keyFail = true;
-                break;
-            }
-            keyPass = true;
-            if (fDecryptionThoroughlyChecked)
-                break;
-        }
-        if (keyPass && keyFail)
-        {
-            LogPrintf("The wallet is probably corrupted: Some keys decrypt but not all.\n");
-            throw std::runtime_error("Error unlocking wallet: some keys decrypt but not all. Your wallet file may be corrupt.");
-        }
-        if (keyFail || (!keyPass && !accept_no_keys))
+        if (mi == mapCryptedKeys.end())
+            return true; // Always pass when there are no encrypted keys
+        const CPubKey &vchPubKey = (*mi).second.first;
+        const std::vector<unsigned char> &vchCryptedSecret = (*mi).second.second;
+        CKey key;
+        if (!DecryptKey(master_key, vchCryptedSecret, vchPubKey, key))
             return false;
-        fDecryptionThoroughlyChecked = true;
     }
     return true;
 }
@@ -855,17 +895,41 @@ bool LegacyScriptPubKeyMan::GetKey(const CKeyID &address, CKey& keyOut) const
     if (!m_storage.HasEncryptionKeys()) {
         return FillableSigningProvider::GetKey(address, keyOut);
     }
+    // CWallet::Lock waits for cs_KeyStore in SetUnlocked before it clears the
+    // master key, so the master key stays set while this decrypts.
+    if (!m_unlocked) {
+        return false;
+    }
 
     CryptedKeyMap::const_iterator mi = mapCryptedKeys.find(address);
     if (mi != mapCryptedKeys.end())
     {
+        auto it = m_decrypted_keys.find(address);
+        if (it != m_decrypted_keys.end()) {
+            keyOut = it->second;
+            return true;
+        }
         const CPubKey &vchPubKey = (*mi).second.first;
         const std::vector<unsigned char> &vchCryptedSecret = (*mi).second.second;
-        return DecryptKey(m_storage.GetEncryptionKey(), vchCryptedSecret, vchPubKey, keyOut);
+        if (!DecryptKey(m_storage.GetEncryptionKey(), vchCryptedSecret, vchPubKey, keyOut)) {
+            WalletLogPrintf("The wallet is probably corrupted: key %s does not decrypt.\n", address.ToString());
+            return false;
+        }
+        m_decrypted_keys.emplace(address, keyOut);
+        return true;
     }
     return false;
 }
 
+void LegacyScriptPubKeyMan::SetUnlocked(bool unlocked)
+{
+    LOCK(cs_KeyStore);
+    m_unlocked = unlocked;
+    if (!unlocked) {
+        m_decrypted_keys.clear();
+    }
+}
+
 bool LegacyScriptPubKeyMan::GetKeyOrigin(const CKeyID& keyID, KeyOriginInfo& info) const
 {
     CKeyMetadata meta;
@@ -955,20 +1019,25 @@ CPubKey LegacyScriptPubKeyMan::GenerateNewKey(WalletBatch &batch, bool internal)
 
 const uint32_t BIP32_HARDENED_KEY_LIMIT = 0x80000000;
 
-void LegacyScriptPubKeyMan::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata& metadata, CKey& secret, bool internal)
+//! Number of keys a keypool refill derives before adding them to the wallet
+static constexpr int64_t KEYPOOL_DERIVE_BATCH_SIZE = 1000;
+//! Maximum number of threads deriving keys in a keypool refill
+static constexpr int MAX_KEYPOOL_THREADS = 8;
+
+CExtKey LegacyScriptPubKeyMan::DeriveHDChainKey(bool internal, CKeyID& master_id) const
 {
     // for now we use a fixed keypath scheme of m/0'/0'/k
     CKey seed;                     //seed (256bit)
     CExtKey masterKey;             //hd master key
     CExtKey accountKey;            //key at m/0'
     CExtKey chainChildKey;         //key at m/0'/0' (external) or m/0'/1' (internal)
-    CExtKey childKey;              //key at m/0'/0'/<n>'
 
     // try to get the seed
     if (!GetKey(hdChain.seed_id, seed))
         throw std::runtime_error(std::string(__func__) + ": seed not found");
 
     masterKey.SetSeed(seed.begin(), seed.size());
+    master_id = masterKey.key.GetPubKey().GetID();
 
     // derive m/0'
     // use hardened derivation (child keys >= 0x80000000 are hardened after bip32)
@@ -977,39 +1046,100 @@ void LegacyScriptPubKeyMan::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata&
     // derive m/0'/0' (external chain) OR m/0'/1' (internal chain)
     assert(internal ? m_storage.CanSupportFeature(FEATURE_HD_SPLIT) : true);
     accountKey.Derive(chainChildKey, BIP32_HARDENED_KEY_LIMIT+(internal ? 1 : 0));
+    return chainChildKey;
+}
+
+//! Record in the metadata of a key that it was derived at m/0'/<internal>'/<index>'
+static void SetHDKeyOrigin(CKeyMetadata& metadata, const CHDChain& chain, const CKeyID& master_id, bool internal, uint32_t index)
+{
+    metadata.hdKeypath = "m/0'/" + std::string(internal ? "1" : "0") + "'/" + ToString(index) + "'";
+    metadata.key_origin.path = {0 | BIP32_HARDENED_KEY_LIMIT, (internal ? 1U : 0U) | BIP32_HARDENED_KEY_LIMIT, index | BIP32_HARDENED_KEY_LIMIT};
+    metadata.hd_seed_id = chain.seed_id;
+    std::copy(master_id.begin(), master_id.begin() + 4, metadata.key_origin.fingerprint);
+    metadata.has_key_origin = true;
+}
+
+void LegacyScriptPubKeyMan::DeriveNewChildKey(WalletBatch &batch, CKeyMetadata& metadata, CKey& secret, bool internal)
+{
+    CKeyID master_id;
+    const CExtKey chainChildKey = DeriveHDChainKey(internal, master_id);
+    CExtKey childKey;              //key at m/0'/0'/<n>'
 
     // derive child key at next index, skip keys already known to the wallet
+    uint32_t& counter = internal ? hdChain.nInternalChainCounter : hdChain.nExternalChainCounter;
+    uint32_t index;
     do {
         // always derive hardened keys
         // childIndex | BIP32_HARDENED_KEY_LIMIT = derive childIndex in hardened child-index-range
         // example: 1 | BIP32_HARDENED_KEY_LIMIT == 0x80000001 == 2147483649
-        if (internal) {
-            chainChildKey.Derive(childKey, hdChain.nInternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            metadata.hdKeypath = "m/0'/1'/" + ToString(hdChain.nInternalChainCounter) + "'";
-            metadata.key_origin.path.push_back(0 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(1 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(hdChain.nInternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            hdChain.nInternalChainCounter++;
-        }
-        else {
-            chainChildKey.Derive(childKey, hdChain.nExternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            metadata.hdKeypath = "m/0'/0'/" + ToString(hdChain.nExternalChainCounter) + "'";
-            metadata.key_origin.path.push_back(0 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(0 | BIP32_HARDENED_KEY_LIMIT);
-            metadata.key_origin.path.push_back(hdChain.nExternalChainCounter | BIP32_HARDENED_KEY_LIMIT);
-            hdChain.nExternalChainCounter++;
-        }
+        index = counter++;
+        chainChildKey.Derive(childKey, index | BIP32_HARDENED_KEY_LIMIT);
     } while (HaveKey(childKey.key.GetPubKey().GetID()));
     secret = childKey.key;
-    metadata.hd_seed_id = hdChain.seed_id;
-    CKeyID master_id = masterKey.key.GetPubKey().GetID();
-    std::copy(master_id.begin(), master_id.begin() + 4, metadata.key_origin.fingerprint);
-    metadata.has_key_origin = true;
+    SetHDKeyOrigin(metadata, hdChain, master_id, internal, index);
     // update the chain model in the database
     if (!batch.WriteHDChain(hdChain))
         throw std::runtime_error(std::string(__func__) + ": Writing HD chain model failed");
 }
 
+void LegacyScriptPubKeyMan::TopUpHDChain(WalletBatch& batch, bool internal, int64_t count)
+{
+    // The chain key is derived from the seed once for the whole refill, and
+    // the child keys, which only depend on it and their index, are derived
+    // in parallel before they are added to the wallet in index order.
+    if (count <= 0) return;
+    CKeyID master_id;
+    const CExtKey chain_key = DeriveHDChainKey(internal, master_id);
+    uint32_t& counter = internal ? hdChain.nInternalChainCounter : hdChain.nExternalChainCounter;
+    const int64_t creation_time = GetTime();
+
+    while (count > 0) {
+        const uint32_t first_index = counter;
+        std::vector<CKey> secrets(std::min(count, KEYPOOL_DERIVE_BATCH_SIZE));
+        std::vector<CPubKey> pubkeys(secrets.size());
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            CExtKey child_key;
+            for (size_t i = next++; i < secrets.size(); i = next++) {
+                chain_key.Derive(child_key, (first_index + i) | BIP32_HARDENED_KEY_LIMIT);
+                secrets[i] = child_key.key;
+                pubkeys[i] = secrets[i].GetPubKey();
+                assert(secrets[i].VerifyPubKey(pubkeys[i]));
+            }
+        };
+
+        const int num_threads = std::max(1, std::min<int>({GetNumCores(), MAX_KEYPOOL_THREADS, (int)(secrets.size() / 100) + 1}));
+        std::vector<std::thread> threads;
+        for (int i = 1; i < num_threads; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        // Skip keys already known to the wallet and derive replacements for them
+        for (size_t i = 0; i < secrets.size(); ++i) {
+            counter++;
+            if (HaveKey(pubkeys[i].GetID())) continue;
+
+            CKeyMetadata metadata(creation_time);
+            SetHDKeyOrigin(metadata, hdChain, master_id, internal, first_index + i);
+            mapKeyMetadata[pubkeys[i].GetID()] = metadata;
+            if (!AddKeyPubKeyWithDB(batch, secrets[i], pubkeys[i])) {
+                throw std::runtime_error(std::string(__func__) + ": AddKey failed");
+            }
+            AddKeypoolPubkeyWithDB(pubkeys[i], internal, batch);
+            --count;
+        }
+    }
+    UpdateTimeFirstKey(creation_time);
+
+    // update the chain model in the database once for the whole refill
+    if (!batch.WriteHDChain(hdChain))
+        throw std::runtime_error(std::string(__func__) + ": Writing HD chain model failed");
+}
+
 void LegacyScriptPubKeyMan::LoadKeyPool(int64_t nIndex, const CKeyPool &keypool)
 {
     LOCK(cs_KeyStore);
@@ -1154,16 +1284,24 @@ bool LegacyScriptPubKeyMan::TopUp(unsigned int kpSize)
             // don't create extra internal keys
             missingInternal = 0;
         }
-        bool internal = false;
         WalletBatch batch(m_storage.GetDatabase());
-        for (int64_t i = missingInternal + missingExternal; i--;)
-        {
-            if (i < missingInternal) {
-                internal = true;
+        if (IsHDEnabled()) {
+            if (missingInternal + missingExternal > 0 && m_storage.CanSupportFeature(FEATURE_COMPRPUBKEY)) {
+                m_storage.SetMinVersion(FEATURE_COMPRPUBKEY, &batch);
             }
+            TopUpHDChain(batch, false, missingExternal);
+            TopUpHDChain(batch, true, missingInternal);
+        } else {
+            bool internal = false;
+            for (int64_t i = missingInternal + missingExternal; i--;)
+            {
+                if (i < missingInternal) {
+                    internal = true;
+                }
 
-            CPubKey pubkey(GenerateNewKey(batch, internal));
-            AddKeypoolPubkeyWithDB(pubkey, internal, batch);
+                CPubKey pubkey(GenerateNewKey(batch, internal));
+                AddKeypoolPubkeyWithDB(pubkey, internal, batch);
+            }
         }
         if (missingInternal + missingExternal > 0) {
             WalletLogPrintf("keypool added %d keys (%d internal), size=%u (%u internal)\n", missingInternal + missingExternal, missingInternal, setInternalKeyPool.size() + setExternalKeyPool.size() + set_pre_split_keypool.size(), setInternalKeyPool.size());
@@ -160,9 +160,15 @@ public:
     virtual bool GetNewDestination(const OutputType type, CTxDestination& dest, std::string& error) { return false; }
     virtual isminetype IsMine(const CScript& script) const { return ISMINE_NO; }
 
-    //! Check that the given decryption key is valid for this ScriptPubKeyMan, i.e. it decrypts all of the keys handled by it.
+    //! Returns the scriptPubKeys that IsMine recognizes, e.g. to match them against block filters
+    virtual std::set<CScript> GetScriptPubKeys() const { return {}; }
+
+    //! Check that the given decryption key is valid for this ScriptPubKeyMan, i.e. it decrypts one of the keys handled by it.
     virtual bool CheckDecryptionKey(const CKeyingMaterial& master_key, bool accept_no_keys = false) { return false; }
     virtual bool Encrypt(const CKeyingMaterial& master_key, WalletBatch* batch) { return false; }
+    //! Called under cs_wallet once the wallet is unlocked, and before it is locked.
+    //! Keys are only decrypted while unlocked; locking forgets the decrypted keys.
+    virtual void SetUnlocked(bool unlocked) {}
 
     virtual bool GetReservedDestination(const OutputType type, bool internal, CTxDestination& address, int64_t& index, CKeyPool& keypool) { return false; }
     virtual void KeepDestination(int64_t index, const OutputType& type) {}
@@ -238,9 +244,6 @@ public:
 class LegacyScriptPubKeyMan : public ScriptPubKeyMan, public FillableSigningProvider
 {
 private:
-    //! keeps track of whether Unlock has run a thorough check before
-    bool fDecryptionThoroughlyChecked = false;
-
     using WatchOnlySet = std::set<CScript>;
     using WatchKeyMap = std::map<CKeyID, CPubKey>;
 
@@ -249,6 +252,12 @@ private:
     using CryptedKeyMap = std::map<CKeyID, std::pair<CPubKey, std::vector<unsigned char>>>;
 
     CryptedKeyMap mapCryptedKeys GUARDED_BY(cs_KeyStore);
+    //! Keys decrypted since the wallet was unlocked. CKey keeps its secret in
+    //! locked memory, so this holds the decrypted keys in LockedPoolManager pages.
+    mutable std::map<CKeyID, CKey> m_decrypted_keys GUARDED_BY(cs_KeyStore);
+    //! Whether the wallet's master key is set. Kept under cs_KeyStore so that
+    //! GetKey does not need cs_wallet to tell whether it may decrypt.
+    bool m_unlocked GUARDED_BY(cs_KeyStore) = false;
     WatchOnlySet setWatchOnly GUARDED_BY(cs_KeyStore);
     WatchKeyMap mapWatchKeys GUARDED_BY(cs_KeyStore);
 
@@ -288,6 +297,10 @@ private:
 
     /* HD derive new child key (on internal or external chain) */
     void DeriveNewChildKey(WalletBatch& batch, CKeyMetadata& metadata, CKey& secret, bool internal = false) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
+    /* HD derive the key at m/0'/0' (external chain) or m/0'/1' (internal chain) from the seed */
+    CExtKey DeriveHDChainKey(bool internal, CKeyID& master_id) const EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
+    /* HD derive count new child keys from the chain key and add them to the keypool */
+    void TopUpHDChain(WalletBatch& batch, bool internal, int64_t count) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
 
     std::set<int64_t> setInternalKeyPool GUARDED_BY(cs_KeyStore);
     std::set<int64_t> setExternalKeyPool GUARDED_BY(cs_KeyStore);
@@ -321,9 +334,11 @@ public:
 
     bool GetNewDestination(const OutputType type, CTxDestination& dest, std::string& error) override;
     isminetype IsMine(const CScript& script) const override;
+    std::set<CScript> GetScriptPubKeys() const override;
 
     bool CheckDecryptionKey(const CKeyingMaterial& master_key, bool accept_no_keys = false) override;
     bool Encrypt(const CKeyingMaterial& master_key, WalletBatch* batch) override;
+    void SetUnlocked(bool unlocked) override;
 
     bool GetReservedDestination(const OutputType type, bool internal, CTxDestination& address, int64_t& index, CKeyPool& keypool) override;
     void KeepDestination(int64_t index, const OutputType& type) override;
@@ -409,6 +424,8 @@ public:
     /* SigningProvider overrides */
     bool HaveKey(const CKeyID &address) const override;
     bool GetKey(const CKeyID &address, CKey& keyOut) const override;
+    //! Number of keys decrypted by GetKey since the wallet was unlocked
+    size_t CountDecryptedKeys() const { LOCK(cs_KeyStore); return m_decrypted_keys.size(); }
     bool GetPubKey(const CKeyID &address, CPubKey& vchPubKeyOut) const override;
     bool AddCScript(const CScript& redeemScript) override;
     bool GetKeyOrigin(const CKeyID& keyid, KeyOriginInfo& info) const override;
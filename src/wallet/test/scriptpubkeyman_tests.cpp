@@ -5,6 +5,7 @@
 #include <key.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
+#include <util/string.h>
 #include <wallet/scriptpubkeyman.h>
 #include <wallet/wallet.h>
 
@@ -40,4 +41,52 @@ BOOST_AUTO_TEST_CASE(CanProvide)
     BOOST_CHECK(keyman.CanProvide(p2sh_script, data));
 }
 
+// Test that a keypool refill derives the same keys, with the same key origins,
+// as deriving them one by one from the seed, skipping keys already known.
+BOOST_AUTO_TEST_CASE(TopUpDerivesHDKeys)
+{
+    NodeContext node;
+    std::unique_ptr<interfaces::Chain> chain = interfaces::MakeChain(node);
+    CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateDummy());
+    wallet.SetMinVersion(FEATURE_LATEST);
+    LegacyScriptPubKeyMan& keyman = *wallet.GetOrCreateLegacyScriptPubKeyMan();
+    keyman.SetHDSeed(keyman.GenerateNewSeed());
+
+    CKey seed;
+    BOOST_CHECK(keyman.GetKey(keyman.GetHDChain().seed_id, seed));
+    CExtKey master_key, account_key, external_key, internal_key;
+    master_key.SetSeed(seed.begin(), seed.size());
+    master_key.Derive(account_key, 0x80000000);
+    account_key.Derive(external_key, 0x80000000);
+    account_key.Derive(internal_key, 0x80000001);
+
+    // The external key at index 2 is already known and must be skipped
+    CExtKey known_key;
+    external_key.Derive(known_key, 2 | 0x80000000);
+    BOOST_CHECK(keyman.AddKeyPubKey(known_key.key, known_key.key.GetPubKey()));
+
+    BOOST_CHECK(keyman.TopUp(5));
+    BOOST_CHECK_EQUAL(keyman.KeypoolCountExternalKeys(), 5U);
+    BOOST_CHECK_EQUAL(keyman.GetKeyPoolSize(), 10U);
+    BOOST_CHECK_EQUAL(keyman.GetHDChain().nExternalChainCounter, 6U);
+    BOOST_CHECK_EQUAL(keyman.GetHDChain().nInternalChainCounter, 5U);
+
+    for (uint32_t i = 0; i < 6; ++i) {
+        if (i == 2) continue;
+        CExtKey child_key;
+        external_key.Derive(child_key, i | 0x80000000);
+        const CKeyMetadata* metadata = keyman.GetMetadata(PKHash(child_key.key.GetPubKey()));
+        BOOST_REQUIRE(metadata);
+        BOOST_CHECK_EQUAL(metadata->hdKeypath, "m/0'/0'/" + ToString(i) + "'");
+        BOOST_CHECK(metadata->key_origin.path.back() == (i | 0x80000000));
+    }
+    for (uint32_t i = 0; i < 5; ++i) {
+        CExtKey child_key;
+        internal_key.Derive(child_key, i | 0x80000000);
+        const CKeyMetadata* metadata = keyman.GetMetadata(PKHash(child_key.key.GetPubKey()));
+        BOOST_REQUIRE(metadata);
+        BOOST_CHECK_EQUAL(metadata->hdKeypath, "m/0'/1'/" + ToString(i) + "'");
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -13,8 +13,10 @@
 #include <policy/policy.h>
 #include <rpc/server.h>
 #include <test/util/setup_common.h>
+#include <random.h>
 #include <validation.h>
 #include <wallet/coincontrol.h>
+#include <wallet/crypter.h>
 #include <wallet/test/wallet_test_fixture.h>
 
 #include <boost/test/unit_test.hpp>
@@ -491,6 +493,28 @@ public:
         return it->second;
     }
 
+    //! Write the key and transactions of the wallet to a fresh database and load them back
+    std::unique_ptr<CWallet> ReloadWallet()
+    {
+        std::unique_ptr<WalletDatabase> database = WalletDatabase::CreateMock();
+        {
+            WalletBatch batch(*database);
+            BOOST_CHECK(batch.WriteKey(coinbaseKey.GetPubKey(), coinbaseKey.GetPrivKey(), CKeyMetadata()));
+            LOCK(wallet->cs_wallet);
+            for (const auto& entry : wallet->mapWallet) {
+                BOOST_CHECK(batch.WriteTx(entry.second));
+            }
+        }
+        auto loaded = MakeUnique<CWallet>(m_chain.get(), WalletLocation(), std::move(database));
+        {
+            LOCK(loaded->cs_wallet);
+            loaded->SetLastBlockProcessed(::ChainActive().Height(), ::ChainActive().Tip()->GetBlockHash());
+        }
+        bool first_run;
+        BOOST_CHECK(loaded->LoadWallet(first_run) == DBErrors::LOAD_OK);
+        return loaded;
+    }
+
     NodeContext m_node;
     std::unique_ptr<interfaces::Chain> m_chain = interfaces::MakeChain(m_node);
     std::unique_ptr<CWallet> wallet;
@@ -562,6 +586,178 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+BOOST_FIXTURE_TEST_CASE(BalanceFollowsWalletChanges, ListCoinsTestingSetup)
+{
+    // The mature coinbase transaction is the only spendable coin.
+    const CWallet::Balance balance = wallet->GetBalance();
+    BOOST_CHECK_EQUAL(balance.m_mine_trusted, 50 * COIN);
+    BOOST_CHECK_EQUAL(wallet->GetStake(), 0);
+
+    // A wallet loaded from disk has the same balance, although its
+    // transaction records are read before the key they pay to.
+    {
+        std::unique_ptr<CWallet> loaded = ReloadWallet();
+        const CWallet::Balance loaded_balance = loaded->GetBalance();
+        BOOST_CHECK_EQUAL(loaded_balance.m_mine_trusted, balance.m_mine_trusted);
+        BOOST_CHECK_EQUAL(loaded_balance.m_mine_immature, balance.m_mine_immature);
+        BOOST_CHECK_EQUAL(loaded->GetAvailableBalance(), 50 * COIN);
+    }
+
+    // Committing a transaction replaces the cached balance with the change.
+    CWalletTx& wtx = AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */});
+    CAmount fee;
+    {
+        LOCK(wallet->cs_wallet);
+        fee = wtx.GetDebit(ISMINE_ALL) - wtx.tx->GetValueOut();
+    }
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, 49 * COIN - fee);
+    BOOST_CHECK_EQUAL(wallet->GetAvailableBalance(), 49 * COIN - fee);
+
+    // Re-evaluating all transactions drops the spent coinbase transaction
+    // without losing the change.
+    wallet->MarkDirty();
+    BOOST_CHECK_EQUAL(wallet->GetBalance().m_mine_trusted, 49 * COIN - fee);
+    {
+        auto locked_chain = m_chain->lock();
+        LOCK(wallet->cs_wallet);
+        std::vector<COutput> available;
+        wallet->AvailableCoins(*locked_chain, available);
+        BOOST_CHECK_EQUAL(available.size(), 1U);
+        BOOST_CHECK(available[0].tx->GetHash() == wtx.GetHash());
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(LoadedWalletKeepsSpends, ListCoinsTestingSetup)
+{
+    CWalletTx& wtx = AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */});
+    CWalletTx::Confirmation confirm;
+    CAmount change;
+    {
+        LOCK(wallet->cs_wallet);
+        confirm = wtx.m_confirm;
+        change = wtx.GetCredit(ISMINE_SPENDABLE);
+    }
+
+    // The spending transaction and the coin it spends are moved into the
+    // loaded wallet whichever is read first, and no amount cached during
+    // loading hides the spend.
+    std::unique_ptr<CWallet> loaded = ReloadWallet();
+    BOOST_CHECK_EQUAL(loaded->GetBalance().m_mine_trusted, change);
+    BOOST_CHECK_EQUAL(loaded->GetAvailableBalance(), change);
+    {
+        auto locked_chain = m_chain->lock();
+        LOCK(loaded->cs_wallet);
+        const CWalletTx* loaded_wtx = loaded->GetWalletTx(wtx.GetHash());
+        BOOST_REQUIRE(loaded_wtx);
+        BOOST_CHECK(loaded_wtx->m_confirm.hashBlock == confirm.hashBlock);
+        BOOST_CHECK_EQUAL(loaded_wtx->m_confirm.block_height, confirm.block_height);
+        std::vector<COutput> available;
+        loaded->AvailableCoins(*locked_chain, available);
+        BOOST_REQUIRE_EQUAL(available.size(), 1U);
+        BOOST_CHECK(available[0].tx->GetHash() == wtx.GetHash());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(IsTxFinalUsesLastBlockProcessed)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].nSequence = 0;
+
+    LOCK(m_wallet.cs_wallet);
+    m_wallet.SetLastBlockProcessed(100, uint256S("01"));
+    mtx.nLockTime = 100;
+    BOOST_CHECK(m_wallet.IsTxFinal(CTransaction(mtx)));
+    mtx.nLockTime = 101;
+    BOOST_CHECK(!m_wallet.IsTxFinal(CTransaction(mtx)));
+
+    // The transaction becomes final with the next block processed, whatever
+    // the height of the chain tip.
+    m_wallet.SetLastBlockProcessed(101, uint256S("02"));
+    BOOST_CHECK(m_wallet.IsTxFinal(CTransaction(mtx)));
+}
+
+BOOST_AUTO_TEST_CASE(LoadWalletTransactions)
+{
+    // Enough transaction records to be decoded by several threads.
+    const int num_txs = 2500;
+    std::unique_ptr<WalletDatabase> database = WalletDatabase::CreateMock();
+    std::vector<uint256> txids;
+    {
+        WalletBatch batch(*database);
+        for (int i = 0; i < num_txs; ++i) {
+            CMutableTransaction mtx;
+            mtx.nLockTime = i;
+            CWalletTx wtx(nullptr, MakeTransactionRef(mtx));
+            wtx.nOrderPos = i;
+            BOOST_CHECK(batch.WriteTx(wtx));
+            txids.push_back(wtx.GetHash());
+        }
+    }
+
+    CWallet wallet(m_chain.get(), WalletLocation(), std::move(database));
+    bool first_run;
+    BOOST_CHECK(wallet.LoadWallet(first_run) == DBErrors::LOAD_OK);
+
+    LOCK(wallet.cs_wallet);
+    BOOST_CHECK_EQUAL(wallet.mapWallet.size(), (size_t)num_txs);
+    for (int i = 0; i < num_txs; ++i) {
+        const CWalletTx* wtx = wallet.GetWalletTx(txids[i]);
+        BOOST_REQUIRE(wtx);
+        BOOST_CHECK_EQUAL(wtx->nOrderPos, i);
+        BOOST_CHECK_EQUAL(wtx->tx->nLockTime, (uint32_t)i);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DecryptedKeysForgottenOnLock)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CKeyID keyid = key.GetPubKey().GetID();
+    AddKey(m_wallet, key);
+    LegacyScriptPubKeyMan* spk_man = m_wallet.GetLegacyScriptPubKeyMan();
+
+    // Encrypt the key the way EncryptWallet does, without rewriting the database.
+    const SecureString passphrase("passphrase");
+    CKeyingMaterial master_key(WALLET_CRYPTO_KEY_SIZE);
+    GetStrongRandBytes(master_key.data(), WALLET_CRYPTO_KEY_SIZE);
+    CMasterKey master;
+    master.vchSalt.resize(WALLET_CRYPTO_SALT_SIZE);
+    GetStrongRandBytes(master.vchSalt.data(), WALLET_CRYPTO_SALT_SIZE);
+    CCrypter crypter;
+    BOOST_REQUIRE(crypter.SetKeyFromPassphrase(passphrase, master.vchSalt, master.nDeriveIterations, master.nDerivationMethod));
+    BOOST_REQUIRE(crypter.Encrypt(master_key, master.vchCryptedKey));
+    {
+        LOCK(m_wallet.cs_wallet);
+        m_wallet.mapMasterKeys[1] = master;
+        BOOST_REQUIRE(spk_man->Encrypt(master_key, nullptr));
+    }
+    BOOST_CHECK(m_wallet.IsLocked());
+
+    CKey found;
+    BOOST_CHECK(!spk_man->GetKey(keyid, found));
+
+    // Unlocking does not decrypt the keys, the first GetKey does.
+    BOOST_REQUIRE(m_wallet.Unlock(passphrase));
+    BOOST_CHECK_EQUAL(spk_man->CountDecryptedKeys(), 0U);
+    BOOST_CHECK(spk_man->GetKey(keyid, found));
+    BOOST_CHECK(found == key);
+    BOOST_CHECK_EQUAL(spk_man->CountDecryptedKeys(), 1U);
+
+    // Locking forgets the cached key and GetKey no longer returns it.
+    BOOST_CHECK(m_wallet.Lock());
+    BOOST_CHECK_EQUAL(spk_man->CountDecryptedKeys(), 0U);
+    found = CKey();
+    BOOST_CHECK(!spk_man->GetKey(keyid, found));
+    BOOST_CHECK(!found.IsValid());
+
+    // After unlocking again the key decrypts again.
+    BOOST_REQUIRE(m_wallet.Unlock(passphrase));
+    BOOST_CHECK(spk_man->GetKey(keyid, found));
+    BOOST_CHECK(found == key);
+    BOOST_CHECK_EQUAL(spk_man->CountDecryptedKeys(), 1U);
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
 {
     NodeContext node;
@@ -16,6 +16,7 @@
 #include <interfaces/wallet.h>
 #include <key.h>
 #include <key_io.h>
+#include <miner.h>
 #include <optional.h>
 #include <policy/policy.h>
 #include <primitives/block.h>
@@ -38,6 +39,7 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <thread>
 
 #include <boost/algorithm/string/replace.hpp>
 
@@ -537,6 +539,29 @@ void CWallet::AddToSpends(const uint256& wtxid)
         AddToSpends(txin.prevout, wtxid);
 }
 
+void CWallet::UpdateCoinTx(const CWalletTx& wtx)
+{
+    const uint256& hash = wtx.GetHash();
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        if (IsMine(wtx.tx->vout[i]) == ISMINE_NO) continue;
+
+        // Only confirmed spends are final enough to drop the transaction;
+        // they can only be undone by a block disconnection, which updates
+        // the spender and so re-evaluates this transaction.
+        bool spent_in_chain = false;
+        const auto range = mapTxSpends.equal_range(COutPoint(hash, i));
+        for (auto it = range.first; it != range.second && !spent_in_chain; ++it) {
+            const auto mit = mapWallet.find(it->second);
+            spent_in_chain = mit != mapWallet.end() && mit->second.isConfirmed();
+        }
+        if (!spent_in_chain) {
+            m_coin_txs.insert(hash);
+            return;
+        }
+    }
+    m_coin_txs.erase(hash);
+}
+
 bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 {
     if (IsCrypted())
@@ -709,8 +734,12 @@ void CWallet::MarkDirty()
 {
     {
         LOCK(cs_wallet);
-        for (std::pair<const uint256, CWalletTx>& item : mapWallet)
+        for (std::pair<const uint256, CWalletTx>& item : mapWallet) {
             item.second.MarkDirty();
+            // Which outputs are ours may have changed
+            UpdateCoinTx(item.second);
+        }
+        MarkBalancesDirty();
     }
 }
 
@@ -829,6 +858,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
             wtx.m_confirm.nIndex = wtxIn.m_confirm.nIndex;
             wtx.m_confirm.hashBlock = wtxIn.m_confirm.hashBlock;
             wtx.m_confirm.block_height = wtxIn.m_confirm.block_height;
+            wtx.m_confirm.block_time = wtxIn.m_confirm.block_time;
             fUpdated = true;
         } else {
             assert(wtx.m_confirm.nIndex == wtxIn.m_confirm.nIndex);
@@ -861,6 +891,8 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    UpdateCoinTx(wtx);
+    MarkBalancesDirty();
 
     // since AddToWallet is called directly for self-originating transactions, check for consumption of own coins
     if( Params().IsVericoin() )
@@ -902,6 +934,7 @@ void CWallet::LoadToWallet(CWalletTx& wtxIn)
             // Update cached block height variable since it not stored in the
             // serialized transaction.
             wtxIn.m_confirm.block_height = *block_height;
+            wtxIn.m_confirm.block_time = locked_chain->getBlockTime(*block_height);
         } else if (wtxIn.isConflicted() || wtxIn.isConfirmed()) {
             // If tx block (or conflicting block) was reorged out of chain
             // while the wallet was shutdown, change tx status to UNCONFIRMED
@@ -915,8 +948,9 @@ void CWallet::LoadToWallet(CWalletTx& wtxIn)
             wtxIn.m_confirm.nIndex = 0;
         }
     }
+    // The transaction is moved rather than copied while loading.
     uint256 hash = wtxIn.GetHash();
-    const auto& ins = mapWallet.emplace(hash, wtxIn);
+    const auto& ins = mapWallet.emplace(hash, std::move(wtxIn));
     CWalletTx& wtx = ins.first->second;
     wtx.BindWallet(this);
     if (/* insertion took place */ ins.second) {
@@ -996,8 +1030,10 @@ void CWallet::MarkInputsDirty(const CTransactionRef& tx)
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            UpdateCoinTx(it->second);
         }
     }
+    MarkBalancesDirty();
 }
 
 bool CWallet::AbandonTransaction(const uint256& hashTx)
@@ -1126,6 +1162,7 @@ void CWallet::transactionAddedToMempool(const CTransactionRef& tx) {
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         it->second.fInMempool = true;
+        MarkBalancesDirty();
     }
 }
 
@@ -1134,6 +1171,7 @@ void CWallet::transactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRe
     auto it = mapWallet.find(tx->GetHash());
     if (it != mapWallet.end()) {
         it->second.fInMempool = false;
+        MarkBalancesDirty();
     }
     // Handle transactions that were removed from the mempool because they
     // conflict with transactions in a newly connected block.
@@ -1175,8 +1213,10 @@ void CWallet::blockConnected(const CBlock& block, int height)
 
     m_last_block_processed_height = height;
     m_last_block_processed = block_hash;
+    // Depths and maturity of all wallet transactions changed
+    MarkBalancesDirty();
     for (size_t index = 0; index < block.vtx.size(); index++) {
-        SyncTransaction(block.vtx[index], {CWalletTx::Status::CONFIRMED, height, block_hash, (int)index});
+        SyncTransaction(block.vtx[index], {CWalletTx::Status::CONFIRMED, height, block_hash, (int)index, block.GetBlockTime()});
         transactionRemovedFromMempool(block.vtx[index], MemPoolRemovalReason::BLOCK);
     }
 }
@@ -1192,6 +1232,7 @@ void CWallet::blockDisconnected(const CBlock& block, int height)
     // future with a stickier abandoned state or even removing abandontransaction call.
     m_last_block_processed_height = height - 1;
     m_last_block_processed = block.hashPrevBlock;
+    MarkBalancesDirty();
     for (const CTransactionRef& ptx : block.vtx) {
         SyncTransaction(ptx, {CWalletTx::Status::UNCONFIRMED, /* block height */ 0, /* block hash */ {}, /* index */ 0});
     }
@@ -1696,6 +1737,82 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+//! Number of blocks read ahead of a wallet rescan
+static constexpr int RESCAN_BATCH_SIZE = 64;
+//! Maximum number of threads reading blocks ahead of a wallet rescan
+static constexpr int MAX_RESCAN_THREADS = 8;
+
+namespace {
+/** A block read ahead of a wallet rescan */
+struct RescanBlock {
+    uint256 hash;
+    //! Whether the block filter showed the block has nothing for the wallet
+    bool skipped{false};
+    //! Whether the block was read, and if so the block
+    bool read{false};
+    CBlock block;
+    //! Per transaction, whether any output pays to a wallet script
+    std::vector<bool> pays_wallet;
+};
+} // namespace
+
+//! All scriptPubKeys of a wallet, as block filter elements
+static GCSFilter::ElementSet GetWalletScriptElements(const CWallet& wallet)
+{
+    GCSFilter::ElementSet elements;
+    for (const ScriptPubKeyMan* spk_man : wallet.GetAllScriptPubKeyMans()) {
+        for (const CScript& script : spk_man->GetScriptPubKeys()) {
+            elements.emplace(script.begin(), script.end());
+        }
+    }
+    return elements;
+}
+
+/**
+ * Read blocks ahead of a rescan on a pool of threads. If use_filters, blocks
+ * whose filter matches none of the wallet scripts are not read at all; the
+ * outputs of the others are matched against the wallet scripts while they are
+ * still hot.
+ */
+static void ReadRescanBlocks(interfaces::Chain& chain, const GCSFilter::ElementSet& wallet_scripts, bool use_filters, std::vector<RescanBlock>& blocks)
+{
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < blocks.size(); i = next++) {
+            RescanBlock& rescan_block = blocks[i];
+            if (use_filters && !wallet_scripts.empty()) {
+                const Optional<bool> matches = chain.blockFilterMatchesAny(rescan_block.hash, wallet_scripts);
+                if (matches && !*matches) {
+                    rescan_block.skipped = true;
+                    continue;
+                }
+            }
+            rescan_block.read = chain.findBlock(rescan_block.hash, &rescan_block.block) && !rescan_block.block.IsNull();
+            if (!rescan_block.read) continue;
+
+            rescan_block.pays_wallet.resize(rescan_block.block.vtx.size());
+            for (size_t pos = 0; pos < rescan_block.block.vtx.size(); ++pos) {
+                for (const CTxOut& txout : rescan_block.block.vtx[pos]->vout) {
+                    if (wallet_scripts.count({txout.scriptPubKey.begin(), txout.scriptPubKey.end()})) {
+                        rescan_block.pays_wallet[pos] = true;
+                        break;
+                    }
+                }
+            }
+        }
+    };
+
+    const int num_threads = std::max(1, std::min<int>({GetNumCores(), MAX_RESCAN_THREADS, (int)blocks.size()}));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
 /**
  * Scan the block chain (starting in start_block) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -1745,6 +1862,18 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
         progress_begin = chain().guessVerificationProgress(block_hash);
         progress_end = chain().guessVerificationProgress(stop_block.IsNull() ? tip_hash : stop_block);
     }
+
+    // Wallet scripts change when keys are used and the keypool is topped up,
+    // so they are gathered again whenever the scan adds transactions.
+    GCSFilter::ElementSet wallet_scripts = GetWalletScriptElements(*this);
+    size_t wallet_tx_count = WITH_LOCK(cs_wallet, return mapWallet.size());
+    // A block confirming a conflict through an input the wallet does not
+    // know of may match none of the wallet scripts, so no block is skipped
+    // while such conflicts are possible.
+    bool use_filters = WITH_LOCK(cs_wallet, return !HasUnconfirmedForeignSpends());
+    std::vector<RescanBlock> batch;
+    size_t batch_pos = 0;
+
     double progress_current = progress_begin;
     while (block_height && !fAbortRescan && !chain().shutdownRequested()) {
         m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
@@ -1756,8 +1885,26 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
             WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", *block_height, progress_current);
         }
 
-        CBlock block;
-        if (chain().findBlock(block_hash, &block) && !block.IsNull()) {
+        if (batch_pos >= batch.size() || batch[batch_pos].hash != block_hash) {
+            // Read the next blocks of the active chain ahead, up to the stop block
+            batch.clear();
+            batch_pos = 0;
+            {
+                auto locked_chain = chain().lock();
+                const Optional<int> tip_height = locked_chain->getHeight();
+                uint256 hash = block_hash;
+                for (int height = *block_height; ; ++height) {
+                    batch.emplace_back();
+                    batch.back().hash = hash;
+                    if (hash == stop_block || !tip_height || height >= *tip_height || (int)batch.size() >= RESCAN_BATCH_SIZE) break;
+                    hash = locked_chain->getBlockHash(height + 1);
+                }
+            }
+            ReadRescanBlocks(chain(), wallet_scripts, use_filters, batch);
+        }
+        const RescanBlock& rescan_block = batch[batch_pos++];
+
+        if (rescan_block.skipped || rescan_block.read) {
             auto locked_chain = chain().lock();
             LOCK(cs_wallet);
             if (!locked_chain->getBlockHeight(block_hash)) {
@@ -1769,8 +1916,21 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
                 result.status = ScanResult::FAILURE;
                 break;
             }
-            for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
-                SyncTransaction(block.vtx[posInBlock], {CWalletTx::Status::CONFIRMED, *block_height, block_hash, (int)posInBlock}, fUpdate);
+            const std::vector<CTransactionRef>& vtx = rescan_block.block.vtx;
+            for (size_t posInBlock = 0; posInBlock < vtx.size(); ++posInBlock) {
+                // Transactions that pay no wallet script can only involve the
+                // wallet through transactions it already has
+                if (!rescan_block.pays_wallet[posInBlock] && !IsInvolvedThroughWalletTxs(*vtx[posInBlock])) continue;
+                SyncTransaction(vtx[posInBlock], {CWalletTx::Status::CONFIRMED, *block_height, block_hash, (int)posInBlock, rescan_block.block.GetBlockTime()}, fUpdate);
+            }
+            if (mapWallet.size() != wallet_tx_count) {
+                wallet_tx_count = mapWallet.size();
+                const size_t old_size = wallet_scripts.size();
+                wallet_scripts = GetWalletScriptElements(*this);
+                // Blocks read ahead were matched against fewer scripts
+                const bool old_use_filters = use_filters;
+                use_filters = !HasUnconfirmedForeignSpends();
+                if (wallet_scripts.size() != old_size || use_filters != old_use_filters) batch.resize(batch_pos);
             }
             // scan succeeded, record block as most recent successfully scanned
             result.last_scanned_block = block_hash;
@@ -1818,6 +1978,35 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     return result;
 }
 
+bool CWallet::IsInvolvedThroughWalletTxs(const CTransaction& tx) const
+{
+    AssertLockHeld(cs_wallet);
+    if (mapWallet.count(tx.GetHash())) return true;
+    for (const CTxIn& txin : tx.vin) {
+        // Spends a wallet output, or conflicts with a wallet transaction
+        if (mapWallet.count(txin.prevout.hash) || mapTxSpends.count(txin.prevout)) return true;
+    }
+    return false;
+}
+
+bool CWallet::HasUnconfirmedForeignSpends() const
+{
+    AssertLockHeld(cs_wallet);
+    for (const auto& entry : mapWallet) {
+        const CWalletTx& wtx = entry.second;
+        if (wtx.isConfirmed() || wtx.isConflicted() || wtx.IsCoinBase()) continue;
+        for (const CTxIn& txin : wtx.tx->vin) {
+            // Block filters only match spends of our own scripts; the payee
+            // output of an earlier wallet transaction is not one of them.
+            auto it = mapWallet.find(txin.prevout.hash);
+            if (it == mapWallet.end()) return true;
+            const CWalletTx& parent = it->second;
+            if (txin.prevout.n >= parent.tx->vout.size() || !IsMine(parent.tx->vout[txin.prevout.n])) return true;
+        }
+    }
+    return false;
+}
+
 void CWallet::ReacceptWalletTransactions()
 {
     // If transactions aren't being broadcasted, don't let them into local mempool either
@@ -2002,16 +2191,18 @@ bool CWalletTx::InMempool() const
     return fInMempool;
 }
 
-bool CWalletTx::IsTrusted(interfaces::Chain::Lock& locked_chain) const
+bool CWalletTx::IsTrusted() const
 {
+    AssertLockHeld(pwallet->cs_wallet);
     std::set<uint256> s;
-    return IsTrusted(locked_chain, s);
+    return IsTrusted(s);
 }
 
-bool CWalletTx::IsTrusted(interfaces::Chain::Lock& locked_chain, std::set<uint256>& trusted_parents) const
+bool CWalletTx::IsTrusted(std::set<uint256>& trusted_parents) const
 {
+    AssertLockHeld(pwallet->cs_wallet);
     // Quick answer in most cases
-    if (!locked_chain.checkFinalTx(*tx)) return false;
+    if (!pwallet->IsTxFinal(*tx)) return false;
     int nDepth = GetDepthInMainChain();
     if (nDepth >= 1) return true;
     if (nDepth < 0) return false;
@@ -2033,12 +2224,22 @@ bool CWalletTx::IsTrusted(interfaces::Chain::Lock& locked_chain, std::set<uint25
         // If we've already trusted this parent, continue
         if (trusted_parents.count(parent->GetHash())) continue;
         // Recurse to check that the parent is also trusted
-        if (!parent->IsTrusted(locked_chain, trusted_parents)) return false;
+        if (!parent->IsTrusted(trusted_parents)) return false;
         trusted_parents.insert(parent->GetHash());
     }
     return true;
 }
 
+bool CWallet::IsTxFinal(const CTransaction& tx) const
+{
+    AssertLockHeld(cs_wallet);
+    // Same as CheckFinalTx with its default flags, which checks time locks
+    // against the adjusted time rather than the median time past. The height
+    // is that of the last block processed rather than the chain tip, so that
+    // it matches transaction depths.
+    return IsFinalTx(tx, m_last_block_processed_height + 1, GetAdjustedTime());
+}
+
 bool CWalletTx::IsEquivalentTo(const CWalletTx& _tx) const
 {
         CMutableTransaction tx1 {*this->tx};
@@ -2118,13 +2319,17 @@ CWallet::Balance CWallet::GetBalance(const int min_depth, bool avoid_reuse) cons
     Balance ret;
     isminefilter reuse_filter = avoid_reuse ? ISMINE_NO : ISMINE_USED;
     {
-        auto locked_chain = chain().lock();
         LOCK(cs_wallet);
+        const auto cached = m_balance_cache.find(std::make_pair(min_depth, avoid_reuse));
+        if (cached != m_balance_cache.end()) {
+            return cached->second;
+        }
+
         std::set<uint256> trusted_parents;
-        for (const auto& entry : mapWallet)
+        for (const uint256& hash : m_coin_txs)
         {
-            const CWalletTx& wtx = entry.second;
-            const bool is_trusted{wtx.IsTrusted(*locked_chain, trusted_parents)};
+            const CWalletTx& wtx = mapWallet.at(hash);
+            const bool is_trusted{wtx.IsTrusted(trusted_parents)};
             const int tx_depth{wtx.GetDepthInMainChain()};
             const CAmount tx_credit_mine{wtx.GetAvailableCredit(/* fUseCache */ true, ISMINE_SPENDABLE | reuse_filter)};
             const CAmount tx_credit_watchonly{wtx.GetAvailableCredit(/* fUseCache */ true, ISMINE_WATCH_ONLY | reuse_filter)};
@@ -2136,11 +2341,12 @@ CWallet::Balance CWallet::GetBalance(const int min_depth, bool avoid_reuse) cons
                 ret.m_mine_untrusted_pending += tx_credit_mine;
                 ret.m_watchonly_untrusted_pending += tx_credit_watchonly;
             }
-            if (wtx.IsCoinStake())
+            if (wtx.IsCoinStake() && wtx.GetBlocksToMaturity() > 0 && tx_depth > 0)
                 ret.m_mine_stake += wtx.GetCredit(ISMINE_ALL);
             ret.m_mine_immature += wtx.GetImmatureCredit();
             ret.m_watchonly_immature += wtx.GetImmatureWatchOnlyCredit();
         }
+        m_balance_cache.emplace(std::make_pair(min_depth, avoid_reuse), ret);
     }
     return ret;
 }
@@ -2174,10 +2380,9 @@ void CWallet::AvailableCoins(interfaces::Chain::Lock& locked_chain, std::vector<
     const int max_depth = {coinControl ? coinControl->m_max_depth : DEFAULT_MAX_DEPTH};
 
     std::set<uint256> trusted_parents;
-    for (const auto& entry : mapWallet)
+    for (const uint256& wtxid : m_coin_txs)
     {
-        const uint256& wtxid = entry.first;
-        const CWalletTx& wtx = entry.second;
+        const CWalletTx& wtx = mapWallet.at(wtxid);
 
         if (!locked_chain.checkFinalTx(*wtx.tx)) {
             continue;
@@ -2198,7 +2403,7 @@ void CWallet::AvailableCoins(interfaces::Chain::Lock& locked_chain, std::vector<
         if (nDepth == 0 && !wtx.InMempool())
             continue;
 
-        bool safeTx = wtx.IsTrusted(locked_chain, trusted_parents);
+        bool safeTx = wtx.IsTrusted(trusted_parents);
 
         // We should not consider coins from transactions that are replacing
         // other transactions.
@@ -2243,10 +2448,10 @@ void CWallet::AvailableCoins(interfaces::Chain::Lock& locked_chain, std::vector<
             if (wtx.tx->vout[i].nValue < nMinimumAmount || wtx.tx->vout[i].nValue > nMaximumAmount)
                 continue;
 
-            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint(entry.first, i)))
+            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint(wtxid, i)))
                 continue;
 
-            if (IsLockedCoin(entry.first, i))
+            if (IsLockedCoin(wtxid, i))
                 continue;
 
             if (IsSpent(wtxid, i))
@@ -2344,7 +2549,7 @@ const CTxOut& CWallet::FindNonChangeParentOutput(const CTransaction& tx, int out
     return ptx->vout[n];
 }
 
-bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, std::vector<OutputGroup> groups,
+bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, const std::vector<OutputGroup>& groups,
                                  std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used) const
 {
     setCoinsRet.clear();
@@ -2360,9 +2565,10 @@ bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibil
         CAmount cost_of_change = GetDiscardRate(*this).GetFee(coin_selection_params.change_spend_size) + coin_selection_params.effective_fee.GetFee(coin_selection_params.change_output_size);
 
         // Filter by the min conf specs and add to utxo_pool and calculate effective value
-        for (OutputGroup& group : groups) {
-            if (!group.EligibleForSpending(eligibility_filter)) continue;
+        for (const OutputGroup& eligible_group : groups) {
+            if (!eligible_group.EligibleForSpending(eligibility_filter)) continue;
 
+            OutputGroup group(eligible_group);
             group.fee = 0;
             group.long_term_fee = 0;
             group.effective_value = 0;
@@ -2383,7 +2589,7 @@ bool CWallet::SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibil
                     it = group.Discard(coin);
                 }
             }
-            if (group.effective_value > 0) utxo_pool.push_back(group);
+            if (group.effective_value > 0) utxo_pool.push_back(std::move(group));
         }
         // Calculate the fees for things that aren't inputs
         CAmount not_input_fees = coin_selection_params.effective_fee.GetFee(coin_selection_params.tx_noinputs_size);
@@ -3149,6 +3355,14 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
 
     fFirstRunRet = false;
     DBErrors nLoadWalletRet = WalletBatch(*database,"cr+").LoadWallet(this);
+
+    // Transaction records are read before the keys, so which of them hold
+    // coins of the wallet is only known now.
+    for (const auto& entry : mapWallet) {
+        UpdateCoinTx(entry.second);
+    }
+    MarkBalancesDirty();
+
     if (nLoadWalletRet == DBErrors::NEED_REWRITE)
     {
         if (database->Rewrite("\x04pool"))
@@ -3179,6 +3393,7 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
     for (uint256 hash : vHashOut) {
         const auto& it = mapWallet.find(hash);
         wtxOrdered.erase(it->second.m_it_wtxOrdered);
+        m_coin_txs.erase(hash);
         mapWallet.erase(it);
         NotifyTransactionChanged(this, hash, CT_DELETED);
     }
@@ -3372,7 +3587,7 @@ std::map<CTxDestination, CAmount> CWallet::GetAddressBalances(interfaces::Chain:
         {
             const CWalletTx& wtx = walletEntry.second;
 
-            if (!wtx.IsTrusted(locked_chain, trusted_parents))
+            if (!wtx.IsTrusted(trusted_parents))
                 continue;
 
             if (wtx.IsImmatureCoinBase())
@@ -4232,6 +4447,11 @@ bool CWallet::Lock()
 
     {
         LOCK(cs_wallet);
+        // Before the master key is cleared, so that no key is decrypted with
+        // or served without it
+        for (const auto& spk_man_pair : m_spk_managers) {
+            spk_man_pair.second->SetUnlocked(false);
+        }
         vMasterKey.clear();
     }
 
@@ -4249,6 +4469,9 @@ bool CWallet::Unlock(const CKeyingMaterial& vMasterKeyIn, bool accept_no_keys)
             }
         }
         vMasterKey = vMasterKeyIn;
+        for (const auto& spk_man_pair : m_spk_managers) {
+            spk_man_pair.second->SetUnlocked(true);
+        }
     }
     NotifyStatusChanged(this);
     return true;
@@ -4428,29 +4651,13 @@ bool CWallet::SelectCoinsSimple(int64_t nTargetValue, unsigned int nSpendTime, s
 
 int64_t CWallet::GetNewMint() const
 {
-    int64_t nTotal = 0;
-    LOCK(cs_wallet);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-    {
-        const CWalletTx* pcoin = &(*it).second;
-        if (pcoin->IsCoinBase() && pcoin->GetBlocksToMaturity() > 0 && pcoin->GetDepthInMainChain() > 0)
-            nTotal += pcoin->GetCredit(ISMINE_ALL);
-    }
-    return nTotal;
+    const Balance bal = GetBalance();
+    return bal.m_mine_immature + bal.m_watchonly_immature;
 }
 
 int64_t CWallet::GetStake() const
 {
-    int64_t nTotal = 0;
-    LOCK(cs_wallet);
-    for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-    {
-        const CWalletTx* pcoin = &(*it).second;
-
-        if (pcoin->IsCoinStake() && pcoin->GetBlocksToMaturity() > 0 && pcoin->GetDepthInMainChain() > 0)
-            nTotal += pcoin->GetCredit(ISMINE_ALL);
-    }
-    return nTotal;
+    return GetBalance().m_mine_stake;
 }
 
 bool CWallet::GetStakeWeight(uint64_t& nWeight)
@@ -4547,6 +4754,7 @@ bool CWallet::CreateCoinStake(const CWallet* pwallet, unsigned int nBits, int64_
 
     CAmount nCredit = 0;
     CScript scriptPubKeyKernel;
+    uint64_t nKernelHashes = 0;
 
     for (const auto& pcoin : setCoins)
     {
@@ -4577,6 +4785,7 @@ bool CWallet::CreateCoinStake(const CWallet* pwallet, unsigned int nBits, int64_
             // Search nSearchInterval seconds back up to nMaxStakeSearchInterval
             uint256 hashProofOfStake = uint256();
             COutPoint prevoutStake = pcoin.outpoint;
+            ++nKernelHashes;
             if (CheckStakeKernelHash(nBits, ::ChainActive().Tip(), header, postx.nTxOffset + CBlockHeader::NORMAL_SERIALIZE_SIZE, tx, prevoutStake, txNew.nTime - n, hashProofOfStake))
             {
                 // Found a kernel
@@ -4627,6 +4836,7 @@ bool CWallet::CreateCoinStake(const CWallet* pwallet, unsigned int nBits, int64_
         if (fKernelFound)
             break; // if kernel is found stop searching
     }
+    g_mining_metrics.kernel_hashes.fetch_add(nKernelHashes, std::memory_order_relaxed);
 
     if (nCredit == 0 || nCredit > nBalance - nReserveBalance)
         return false;
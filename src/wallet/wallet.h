@@ -373,7 +373,9 @@ public:
         int block_height;
         uint256 hashBlock;
         int nIndex;
-        Confirmation(Status s = UNCONFIRMED, int b = 0, uint256 h = uint256(), int i = 0) : status(s), block_height(b), hashBlock(h), nIndex(i) {}
+        //! Not serialized, looked up from the chain when loading
+        int64_t block_time;
+        Confirmation(Status s = UNCONFIRMED, int b = 0, uint256 h = uint256(), int i = 0, int64_t t = 0) : status(s), block_height(b), hashBlock(h), nIndex(i), block_time(t) {}
     };
 
     Confirmation m_confirm;
@@ -485,8 +487,8 @@ public:
     bool IsEquivalentTo(const CWalletTx& tx) const;
 
     bool InMempool() const;
-    bool IsTrusted(interfaces::Chain::Lock& locked_chain) const;
-    bool IsTrusted(interfaces::Chain::Lock& locked_chain, std::set<uint256>& trusted_parents) const;
+    bool IsTrusted() const;
+    bool IsTrusted(std::set<uint256>& trusted_parents) const;
 
     int64_t GetTxTime() const;
 
@@ -641,6 +643,17 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void AddToSpends(const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /**
+     * Wallet transactions with outputs of ours that are not known to be spent
+     * in the active chain. Balances and coin listings only look at these, so
+     * their cost follows the number of unspent outputs rather than the size
+     * of the wallet history. A transaction is dropped once confirmed
+     * transactions spend all its outputs of ours, and re-evaluated whenever
+     * one of its spenders changes state.
+     */
+    std::set<uint256> m_coin_txs GUARDED_BY(cs_wallet);
+    void UpdateCoinTx(const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Add a transaction to the wallet, or update it.  pIndex and posInBlock should
      * be set when the transaction was known to be included in a block.  When
@@ -668,6 +681,12 @@ private:
      * Should be called with non-zero block_hash and posInBlock if this is for a transaction that is included in a block. */
     void SyncTransaction(const CTransactionRef& tx, CWalletTx::Confirmation confirm, bool update_tx = true) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /* Whether a transaction is or conflicts with a wallet transaction, or spends one of its outputs. */
+    bool IsInvolvedThroughWalletTxs(const CTransaction& tx) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
+    /* Whether an unconfirmed wallet transaction spends an output that is not the wallet's own. */
+    bool HasUnconfirmedForeignSpends() const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     std::atomic<uint64_t> m_wallet_flags{0};
 
     bool SetAddressBookWithDB(WalletBatch& batch, const CTxDestination& address, const std::string& strName, const std::string& strPurpose);
@@ -810,7 +829,7 @@ public:
      * completion the coin set and corresponding actual target value is
      * assembled
      */
-    bool SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, std::vector<OutputGroup> groups,
+    bool SelectCoinsMinConf(const CAmount& nTargetValue, const CoinEligibilityFilter& eligibility_filter, const std::vector<OutputGroup>& groups,
         std::set<CInputCoin>& setCoinsRet, CAmount& nValueRet, const CoinSelectionParams& coin_selection_params, bool& bnb_used) const;
 
     bool IsSpent(const uint256& hash, unsigned int n) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
@@ -880,6 +899,7 @@ public:
     void WalletUpdateSpent(const CTransactionRef& tx);
     void MarkDirty();
     bool AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose=true);
+    /** Add a transaction read from the wallet database, moving from wtxIn. */
     void LoadToWallet(CWalletTx& wtxIn) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void transactionAddedToMempool(const CTransactionRef& tx) override;
     void blockConnected(const CBlock& block, int height) override;
@@ -910,7 +930,7 @@ public:
         CAmount m_mine_trusted{0};           //!< Trusted, at depth=GetBalance.min_depth or more
         CAmount m_mine_untrusted_pending{0}; //!< Untrusted, but in mempool (pending)
         CAmount m_mine_immature{0};          //!< Immature coinbases in the main chain
-        CAmount m_mine_stake{0};             //!< Staked, non-spendable until maturity
+        CAmount m_mine_stake{0};             //!< Immature coinstakes in the main chain, non-spendable until maturity
         CAmount m_watchonly_trusted{0};
         CAmount m_watchonly_untrusted_pending{0};
         CAmount m_watchonly_immature{0};
@@ -918,6 +938,17 @@ public:
     Balance GetBalance(int min_depth = 0, bool avoid_reuse = true) const;
     CAmount GetAvailableBalance(const CCoinControl* coinControl = nullptr) const;
 
+private:
+    /**
+     * Balances by GetBalance arguments. Cleared whenever a wallet transaction,
+     * its mempool state or the last processed block changes, so repeated
+     * queries between those events don't touch any transaction.
+     */
+    mutable std::map<std::pair<int, bool>, Balance> m_balance_cache GUARDED_BY(cs_wallet);
+    void MarkBalancesDirty() EXCLUSIVE_LOCKS_REQUIRED(cs_wallet) { m_balance_cache.clear(); }
+
+public:
+
     OutputType TransactionChangeType(OutputType change_type, const std::vector<CRecipient>& vecSend);
 
     /**
@@ -1194,6 +1225,15 @@ public:
 
     bool GetStakeWeight(uint64_t& nWeight);
 
+    /** Whether the staker searches the coins of this wallet for kernels */
+    std::atomic<bool> m_staking_enabled{true};
+    /** Number of stake searches over the coins of this wallet, and of the
+     * proof-of-stake blocks they produced */
+    std::atomic<uint64_t> m_stake_searches{0};
+    std::atomic<uint64_t> m_stakes_found{0};
+    /** Time up to which the coins of this wallet were searched for kernels */
+    int64_t m_last_coin_stake_search_time GUARDED_BY(cs_wallet){0};
+
     bool CreateCoinStake(const CWallet* pwallet, unsigned int nBits, int64_t nSearchInterval, int64_t nFees, CMutableTransaction& txNew);
 
     /** Get last block processed height */
@@ -1203,12 +1243,16 @@ public:
         assert(m_last_block_processed_height >= 0);
         return m_last_block_processed_height;
     };
+    /** Whether a transaction can be included in the block after the last
+     * block processed, without locking the chain */
+    bool IsTxFinal(const CTransaction& tx) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     /** Set last block processed height, currently only use in unit test */
     void SetLastBlockProcessed(int block_height, uint256 block_hash) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet)
     {
         AssertLockHeld(cs_wallet);
         m_last_block_processed_height = block_height;
         m_last_block_processed = block_hash;
+        MarkBalancesDirty();
     };
 
     //! Connect the signals from ScriptPubKeyMans to the signals in CWallet
@@ -16,6 +16,7 @@
 
 #include <atomic>
 #include <string>
+#include <thread>
 
 #include <boost/thread.hpp>
 
@@ -194,6 +195,53 @@ public:
     }
 };
 
+/**
+ * Decode a wallet transaction record, without the record type. It only
+ * touches its arguments, so records can be decoded on any thread.
+ */
+static bool DecodeTxRecord(CDataStream& ssKey, CDataStream& ssValue, CWalletTx& wtx, bool& upgraded, std::string& strErr)
+{
+    uint256 hash;
+    ssKey >> hash;
+    ssValue >> wtx;
+    if (wtx.GetHash() != hash)
+        return false;
+
+    upgraded = false;
+    // Undo serialize changes in 31600
+    if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
+    {
+        if (!ssValue.empty())
+        {
+            char fTmp;
+            char fUnused;
+            std::string unused_string;
+            ssValue >> fTmp >> fUnused >> unused_string;
+            strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
+                               wtx.fTimeReceivedIsTxTime, fTmp, hash.ToString());
+            wtx.fTimeReceivedIsTxTime = fTmp;
+        }
+        else
+        {
+            strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
+            wtx.fTimeReceivedIsTxTime = 0;
+        }
+        upgraded = true;
+    }
+    return true;
+}
+
+static void LoadTxRecord(CWallet* pwallet, CWalletTx& wtx, bool upgraded, CWalletScanState& wss) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
+{
+    if (upgraded)
+        wss.vWalletUpgrade.push_back(wtx.GetHash());
+
+    if (wtx.nOrderPos == -1)
+        wss.fAnyUnordered = true;
+
+    pwallet->LoadToWallet(wtx);
+}
+
 static bool
 ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
              CWalletScanState &wss, std::string& strType, std::string& strErr) EXCLUSIVE_LOCKS_REQUIRED(pwallet->cs_wallet)
@@ -214,38 +262,11 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
             ssKey >> strAddress;
             ssValue >> pwallet->m_address_book[DecodeDestination(strAddress)].purpose;
         } else if (strType == DBKeys::TX) {
-            uint256 hash;
-            ssKey >> hash;
             CWalletTx wtx(nullptr /* pwallet */, MakeTransactionRef());
-            ssValue >> wtx;
-            if (wtx.GetHash() != hash)
+            bool upgraded;
+            if (!DecodeTxRecord(ssKey, ssValue, wtx, upgraded, strErr))
                 return false;
-
-            // Undo serialize changes in 31600
-            if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
-            {
-                if (!ssValue.empty())
-                {
-                    char fTmp;
-                    char fUnused;
-                    std::string unused_string;
-                    ssValue >> fTmp >> fUnused >> unused_string;
-                    strErr = strprintf("LoadWallet() upgrading tx ver=%d %d %s",
-                                       wtx.fTimeReceivedIsTxTime, fTmp, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = fTmp;
-                }
-                else
-                {
-                    strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = 0;
-                }
-                wss.vWalletUpgrade.push_back(hash);
-            }
-
-            if (wtx.nOrderPos == -1)
-                wss.fAnyUnordered = true;
-
-            pwallet->LoadToWallet(wtx);
+            LoadTxRecord(pwallet, wtx, upgraded, wss);
         } else if (strType == DBKeys::WATCHS) {
             wss.nWatchKeys++;
             CScript script;
@@ -429,6 +450,63 @@ bool WalletBatch::IsKeyType(const std::string& strType)
             strType == DBKeys::MASTER_KEY || strType == DBKeys::CRYPTED_KEY);
 }
 
+//! Number of records LoadWallet reads from the cursor before loading them
+static constexpr size_t LOAD_CHUNK_SIZE = 10000;
+//! Maximum number of threads decoding transaction records in LoadWallet
+static constexpr int MAX_LOAD_THREADS = 8;
+
+namespace {
+/** A wallet transaction record decoded ahead of loading it */
+struct DecodedTxRecord {
+    //! Null if the record is not a transaction record
+    std::unique_ptr<CWalletTx> wtx;
+    bool ok{false};
+    bool upgraded{false};
+    std::string err;
+};
+} // namespace
+
+/**
+ * Decode the transaction records among records read from the database on a
+ * pool of threads. Deserializing and hashing transactions is most of the work
+ * of loading a large wallet, and doesn't depend on the wallet.
+ */
+static std::vector<DecodedTxRecord> DecodeTxRecords(std::vector<std::pair<CDataStream, CDataStream>>& records)
+{
+    std::vector<DecodedTxRecord> decoded(records.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < records.size(); i = next++) {
+            try {
+                // Leave the key intact for records that are loaded by ReadKeyValue
+                CDataStream ssKey(records[i].first);
+                std::string strType;
+                ssKey >> strType;
+                if (strType != DBKeys::TX) continue;
+
+                DecodedTxRecord& record = decoded[i];
+                record.wtx = MakeUnique<CWalletTx>(nullptr /* pwallet */, MakeTransactionRef());
+                record.ok = DecodeTxRecord(ssKey, records[i].second, *record.wtx, record.upgraded, record.err);
+            } catch (...) {
+                // The record stays undecoded if its type couldn't be read, and
+                // is then reported by ReadKeyValue
+                if (decoded[i].wtx) decoded[i].ok = false;
+            }
+        }
+    };
+
+    const int num_threads = std::max(1, std::min<int>({GetNumCores(), MAX_LOAD_THREADS, (int)(records.size() / 1000) + 1}));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return decoded;
+}
+
 DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
 {
     CWalletScanState wss;
@@ -452,41 +530,63 @@ DBErrors WalletBatch::LoadWallet(CWallet* pwallet)
             return DBErrors::CORRUPT;
         }
 
-        while (true)
+        // Records are read in chunks, whose transaction records are decoded in
+        // parallel. All records are then loaded in cursor order.
+        std::vector<std::pair<CDataStream, CDataStream>> records;
+        bool end_of_records = false;
+        while (!end_of_records)
         {
-            // Read next record
-            CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-            int ret = m_batch.ReadAtCursor(pcursor, ssKey, ssValue);
-            if (ret == DB_NOTFOUND)
-                break;
-            else if (ret != 0)
+            records.clear();
+            while (records.size() < LOAD_CHUNK_SIZE)
             {
-                pwallet->WalletLogPrintf("Error reading next record from wallet database\n");
-                return DBErrors::CORRUPT;
+                // Read next record
+                CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+                CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+                int ret = m_batch.ReadAtCursor(pcursor, ssKey, ssValue);
+                if (ret == DB_NOTFOUND) {
+                    end_of_records = true;
+                    break;
+                } else if (ret != 0) {
+                    pwallet->WalletLogPrintf("Error reading next record from wallet database\n");
+                    return DBErrors::CORRUPT;
+                }
+                records.emplace_back(std::move(ssKey), std::move(ssValue));
             }
+            std::vector<DecodedTxRecord> decoded = DecodeTxRecords(records);
 
-            // Try to be tolerant of single corrupt records:
-            std::string strType, strErr;
-            if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr))
+            for (size_t i = 0; i < records.size(); ++i)
             {
-                // losing keys is considered a catastrophic error, anything else
-                // we assume the user can live with:
-                if (IsKeyType(strType) || strType == DBKeys::DEFAULTKEY) {
-                    result = DBErrors::CORRUPT;
-                } else if (strType == DBKeys::FLAGS) {
-                    // reading the wallet flags can only fail if unknown flags are present
-                    result = DBErrors::TOO_NEW;
+                // Try to be tolerant of single corrupt records:
+                std::string strType, strErr;
+                bool loaded;
+                if (decoded[i].wtx) {
+                    strType = DBKeys::TX;
+                    strErr = std::move(decoded[i].err);
+                    loaded = decoded[i].ok;
+                    if (loaded) LoadTxRecord(pwallet, *decoded[i].wtx, decoded[i].upgraded, wss);
                 } else {
-                    // Leave other errors alone, if we try to fix them we might make things worse.
-                    fNoncriticalErrors = true; // ... but do warn the user there is something wrong.
-                    if (strType == DBKeys::TX)
-                        // Rescan if there is a bad transaction record:
-                        gArgs.SoftSetBoolArg("-rescan", true);
+                    loaded = ReadKeyValue(pwallet, records[i].first, records[i].second, wss, strType, strErr);
+                }
+                if (!loaded)
+                {
+                    // losing keys is considered a catastrophic error, anything else
+                    // we assume the user can live with:
+                    if (IsKeyType(strType) || strType == DBKeys::DEFAULTKEY) {
+                        result = DBErrors::CORRUPT;
+                    } else if (strType == DBKeys::FLAGS) {
+                        // reading the wallet flags can only fail if unknown flags are present
+                        result = DBErrors::TOO_NEW;
+                    } else {
+                        // Leave other errors alone, if we try to fix them we might make things worse.
+                        fNoncriticalErrors = true; // ... but do warn the user there is something wrong.
+                        if (strType == DBKeys::TX)
+                            // Rescan if there is a bad transaction record:
+                            gArgs.SoftSetBoolArg("-rescan", true);
+                    }
                 }
+                if (!strErr.empty())
+                    pwallet->WalletLogPrintf("%s\n", strErr);
             }
-            if (!strErr.empty())
-                pwallet->WalletLogPrintf("%s\n", strErr);
         }
         pcursor->close();
     }
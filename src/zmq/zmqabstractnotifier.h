@@ -7,7 +7,11 @@
 
 #include <zmq/zmqconfig.h>
 
+#include <memory>
+
+class CBlock;
 class CBlockIndex;
+class CTransaction;
 class CZMQAbstractNotifier;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
@@ -16,8 +20,12 @@ class CZMQAbstractNotifier
 {
 public:
     static const int DEFAULT_ZMQ_SNDHWM {1000};
+    static const int DEFAULT_ZMQ_BATCH {1};
+    static const int DEFAULT_ZMQ_REPLAY {1000};
+    //! Milliseconds a partial batch of mempool notifications may be held back
+    static const int MAX_ZMQ_BATCH_DELAY {100};
 
-    CZMQAbstractNotifier() : psocket(nullptr), outbound_message_high_water_mark(DEFAULT_ZMQ_SNDHWM) { }
+    CZMQAbstractNotifier() : psocket(nullptr), outbound_message_high_water_mark(DEFAULT_ZMQ_SNDHWM), batch_size(DEFAULT_ZMQ_BATCH), replay_size(DEFAULT_ZMQ_REPLAY) { }
     virtual ~CZMQAbstractNotifier();
 
     template <typename T>
@@ -36,18 +44,41 @@ public:
             outbound_message_high_water_mark = sndhwm;
         }
     }
+    int GetBatchSize() const { return batch_size; }
+    void SetBatchSize(const int n) {
+        if (n >= 1) {
+            batch_size = n;
+        }
+    }
+    int GetReplaySize() const { return replay_size; }
+    void SetReplaySize(const int n) {
+        if (n >= 0) {
+            replay_size = n;
+        }
+    }
 
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    //! Notifies the new tip. block is the tip's block if it is still in memory.
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block);
+    //! Notifies a transaction added to the mempool or included in a connected or disconnected block
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyBlockConnect(const CBlockIndex *pindex);
+    virtual bool NotifyBlockDisconnect(const CBlockIndex *pindex);
+    virtual bool NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence);
+    virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
+    //! Sends messages held back for batching, if the oldest of them waited at
+    //! least max_age microseconds
+    virtual bool Flush(int64_t max_age = 0);
 
 protected:
     void *psocket;
     std::string type;
     std::string address;
     int outbound_message_high_water_mark; // aka SNDHWM
+    int batch_size; //!< number of notifications sent in one message
+    int replay_size; //!< number of recent messages kept for replay
 };
 
 #endif // BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
@@ -5,6 +5,8 @@
 #include <zmq/zmqnotificationinterface.h>
 #include <zmq/zmqpublishnotifier.h>
 
+#include <primitives/block.h>
+#include <txmempool.h>
 #include <validation.h>
 #include <util/system.h>
 
@@ -29,6 +31,7 @@ CZMQNotificationInterface::~CZMQNotificationInterface()
 
 std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotifiers() const
 {
+    LOCK(m_notifiers_mutex);
     std::list<const CZMQAbstractNotifier*> result;
     for (const auto* n : notifiers) {
         result.push_back(n);
@@ -36,6 +39,18 @@ std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotif
     return result;
 }
 
+bool CZMQNotificationInterface::GetReplay(const std::string& topic, uint32_t start, std::vector<CZMQReplayMessage>& out, bool& available) const
+{
+    LOCK(m_notifiers_mutex);
+    for (const auto* n : notifiers) {
+        if (n->GetType() != "pub" + topic || n->GetReplaySize() == 0) continue;
+        // Every notifier is created by the factories in Create(), all of which publish
+        available = static_cast<const CZMQAbstractPublishNotifier*>(n)->GetReplay(start, out);
+        return true;
+    }
+    return false;
+}
+
 CZMQNotificationInterface* CZMQNotificationInterface::Create()
 {
     CZMQNotificationInterface* notificationInterface = nullptr;
@@ -46,6 +61,9 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubhashstake"] = CZMQAbstractNotifier::Create<CZMQPublishHashStakeNotifier>;
+    factories["pubstakemodifier"] = CZMQAbstractNotifier::Create<CZMQPublishStakeModifierNotifier>;
 
     for (const auto& entry : factories)
     {
@@ -58,6 +76,8 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
             notifier->SetType(entry.first);
             notifier->SetAddress(address);
             notifier->SetOutboundMessageHighWaterMark(static_cast<int>(gArgs.GetArg(arg + "hwm", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM)));
+            notifier->SetBatchSize(static_cast<int>(gArgs.GetArg(arg + "batch", CZMQAbstractNotifier::DEFAULT_ZMQ_BATCH)));
+            notifier->SetReplaySize(static_cast<int>(gArgs.GetArg("-zmqreplay", CZMQAbstractNotifier::DEFAULT_ZMQ_REPLAY)));
             notifiers.push_back(notifier);
         }
     }
@@ -136,15 +156,13 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
-void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+void CZMQNotificationInterface::TryForEachAndRemoveFailed(const std::function<bool(CZMQAbstractNotifier*)>& func, bool flush)
 {
-    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
-        return;
-
+    LOCK(m_notifiers_mutex);
     for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindexNew))
+        if (func(notifier) && (!flush || notifier->Flush()))
         {
             i++;
         }
@@ -156,41 +174,83 @@ void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, co
     }
 }
 
+bool CZMQNotificationInterface::BurstEnded()
+{
+    // Further notifications queued behind this one will flush the batch
+    return GetMainSignals().CallbacksPending() == 0;
+}
+
+void CZMQNotificationInterface::FlushBatches()
+{
+    const int64_t max_age = CZMQAbstractNotifier::MAX_ZMQ_BATCH_DELAY * 1000;
+    TryForEachAndRemoveFailed([max_age](CZMQAbstractNotifier* notifier) {
+        return notifier->Flush(max_age);
+    }, false);
+}
+
+void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    std::shared_ptr<const CBlock> block;
+    block.swap(m_last_connected_block);
+    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
+        return;
+
+    if (block && block->GetHash() != pindexNew->GetBlockHash()) {
+        block.reset();
+    }
+    TryForEachAndRemoveFailed([pindexNew, &block](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlock(pindexNew, block);
+    });
+}
+
 void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx)
 {
-    // Used by BlockConnected and BlockDisconnected as well, because they're
-    // all the same external callback.
     const CTransaction& tx = *ptx;
+    const uint64_t mempool_sequence = ++m_mempool_sequence;
 
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(tx))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    TryForEachAndRemoveFailed([&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransaction(tx) && notifier->NotifyTransactionAcceptance(tx, mempool_sequence);
+    }, BurstEnded());
+}
+
+void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransactionRef& ptx, MemPoolRemovalReason reason)
+{
+    // Called for all non-block inclusion reasons
+    const CTransaction& tx = *ptx;
+    const uint64_t mempool_sequence = ++m_mempool_sequence;
+
+    TryForEachAndRemoveFailed([&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransactionRemoval(tx, mempool_sequence);
+    }, BurstEnded());
 }
 
 void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected)
 {
-    for (const CTransactionRef& ptx : pblock->vtx) {
-        // Do a normal notify for each transaction added in the block
-        TransactionAddedToMempool(ptx);
-    }
+    m_last_connected_block = pblock;
+    TryForEachAndRemoveFailed([&pblock](CZMQAbstractNotifier* notifier) {
+        for (const CTransactionRef& ptx : pblock->vtx) {
+            // Do a normal notify for each transaction added in the block
+            if (!notifier->NotifyTransaction(*ptx)) return false;
+        }
+        return true;
+    });
+    TryForEachAndRemoveFailed([pindexConnected](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockConnect(pindexConnected);
+    });
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
 {
-    for (const CTransactionRef& ptx : pblock->vtx) {
-        // Do a normal notify for each transaction removed in block disconnection
-        TransactionAddedToMempool(ptx);
-    }
+    TryForEachAndRemoveFailed([&pblock](CZMQAbstractNotifier* notifier) {
+        for (const CTransactionRef& ptx : pblock->vtx) {
+            // Do a normal notify for each transaction removed in block disconnection
+            if (!notifier->NotifyTransaction(*ptx)) return false;
+        }
+        return true;
+    });
+    TryForEachAndRemoveFailed([pindexDisconnected](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockDisconnect(pindexDisconnected);
+    });
 }
 
 CZMQNotificationInterface* g_zmq_notification_interface = nullptr;
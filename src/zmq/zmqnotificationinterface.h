@@ -5,11 +5,17 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include <sync.h>
 #include <validationinterface.h>
+
+#include <functional>
 #include <list>
+#include <memory>
+#include <vector>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
+struct CZMQReplayMessage;
 
 class CZMQNotificationInterface final : public CValidationInterface
 {
@@ -18,14 +24,24 @@ public:
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
+    /** Look up the messages published on topic from sequence number start on.
+     *  Returns false if no notifier publishes the topic; available is set to
+     *  false if the requested messages are no longer kept. */
+    bool GetReplay(const std::string& topic, uint32_t start, std::vector<CZMQReplayMessage>& out, bool& available) const;
+
     static CZMQNotificationInterface* Create();
 
+    /** Send the partial batches held back for longer than MAX_ZMQ_BATCH_DELAY,
+     *  called periodically by the scheduler */
+    void FlushBatches();
+
 protected:
     bool Initialize();
     void Shutdown();
 
     // CValidationInterface
     void TransactionAddedToMempool(const CTransactionRef& tx) override;
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason) override;
     void BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected) override;
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected) override;
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
@@ -33,8 +49,21 @@ protected:
 private:
     CZMQNotificationInterface();
 
+    /** Call func on every notifier, shutting down and dropping the ones that
+     *  fail, then send any batched messages if flush is set */
+    void TryForEachAndRemoveFailed(const std::function<bool(CZMQAbstractNotifier*)>& func, bool flush = true);
+    /** Whether mempool notifications should be sent now rather than batched
+     *  with the ones about to follow */
+    static bool BurstEnded();
+
     void *pcontext;
+    //! Guards the notifiers list against concurrent replay lookups
+    mutable Mutex m_notifiers_mutex;
     std::list<CZMQAbstractNotifier*> notifiers;
+    //! Last connected block, handed to UpdatedBlockTip so it is not read back from disk
+    std::shared_ptr<const CBlock> m_last_connected_block;
+    //! Counts mempool additions and removals, published by the sequence topic
+    uint64_t m_mempool_sequence{0};
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <crypto/common.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
@@ -16,6 +17,9 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_HASHSTAKE = "hashstake";
+static const char *MSG_STAKEMODIFIER = "stakemodifier";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -152,13 +156,69 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* d
     if (rc == -1)
         return false;
 
+    if (replay_size > 0) {
+        LOCK(m_replay_mutex);
+        m_replay.push_back({nSequence, std::string(static_cast<const char*>(data), size)});
+        m_replay_bytes += size;
+        m_replay_next = nSequence + 1;
+        while (m_replay.size() > (size_t)replay_size || m_replay_bytes > MAX_ZMQ_REPLAY_BYTES) {
+            m_replay_bytes -= m_replay.front().body.size();
+            m_replay.pop_front();
+        }
+    }
+
     /* increment memory only sequence number after sending */
     nSequence++;
 
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQAbstractPublishNotifier::SendBatchedMessage(const char *command, const void* data, size_t size)
+{
+    if (batch_size <= 1) {
+        return SendMessage(command, data, size);
+    }
+    m_batch_command = command;
+    if (m_batch_count == 0) m_batch_time = GetTimeMicros();
+    m_batch.append(static_cast<const char*>(data), size);
+    if (++m_batch_count < batch_size) {
+        return true;
+    }
+    return Flush();
+}
+
+bool CZMQAbstractPublishNotifier::Flush(int64_t max_age)
+{
+    if (m_batch_count == 0 || GetTimeMicros() - m_batch_time < max_age) {
+        return true;
+    }
+    const bool ret = SendMessage(m_batch_command, m_batch.data(), m_batch.size());
+    m_batch.clear();
+    m_batch_count = 0;
+    return ret;
+}
+
+bool CZMQAbstractPublishNotifier::GetReplay(uint32_t start, std::vector<CZMQReplayMessage>& out) const
+{
+    LOCK(m_replay_mutex);
+    if (start >= m_replay_next) {
+        return true;
+    }
+    if (m_replay.empty() || start < m_replay.front().sequence) {
+        return false;
+    }
+    out.insert(out.end(), m_replay.begin() + (start - m_replay.front().sequence), m_replay.end());
+    return true;
+}
+
+/** Block hashes and txids are sent in the byte order of their hex representation */
+static void AppendReversedHash(std::string& out, const uint256& hash)
+{
+    out.append(hash.begin(), hash.end());
+    std::reverse(out.end() - hash.size(), out.end());
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& /*block*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s\n", hash.GetHex());
@@ -175,25 +235,27 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     char data[32];
     for (unsigned int i = 0; i < 32; i++)
         data[31 - i] = hash.begin()[i];
-    return SendMessage(MSG_HASHTX, data, 32);
+    return SendBatchedMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
+    if (block) {
+        // The block was just connected, no need to read it back from disk
+        ss << *block;
+    } else {
+        const Consensus::Params& consensusParams = Params().GetConsensus();
+        CBlock block_from_disk;
+        if(!ReadBlockFromDisk(block_from_disk, pindex, consensusParams))
         {
             zmqError("Can't read block from disk");
             return false;
         }
 
-        ss << block;
+        ss << block_from_disk;
     }
 
     return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
@@ -205,5 +267,79 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &tr
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s\n", hash.GetHex());
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
     ss << transaction;
-    return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    return SendBatchedMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+}
+
+/* sequence body: 32 byte hash, 1 byte label and for mempool events the 8 byte LE mempool sequence number */
+static bool SendSequenceMessage(CZMQAbstractPublishNotifier& notifier, const uint256& hash, char label, const uint64_t* mempool_sequence = nullptr)
+{
+    std::string data;
+    AppendReversedHash(data, hash);
+    data.push_back(label);
+    if (mempool_sequence) {
+        unsigned char seq[sizeof(uint64_t)];
+        WriteLE64(seq, *mempool_sequence);
+        data.append((const char*)seq, sizeof(seq));
+    }
+    return notifier.SendMessage(MSG_SEQUENCE, data.data(), data.size());
+}
+
+bool CZMQPublishSequenceNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence block connect %s\n", pindex->GetBlockHash().GetHex());
+    return SendSequenceMessage(*this, pindex->GetBlockHash(), 'C');
+}
+
+bool CZMQPublishSequenceNotifier::NotifyBlockDisconnect(const CBlockIndex *pindex)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence block disconnect %s\n", pindex->GetBlockHash().GetHex());
+    return SendSequenceMessage(*this, pindex->GetBlockHash(), 'D');
+}
+
+bool CZMQPublishSequenceNotifier::NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence mempool acceptance %s\n", transaction.GetHash().GetHex());
+    return SendSequenceMessage(*this, transaction.GetHash(), 'A', &mempool_sequence);
+}
+
+bool CZMQPublishSequenceNotifier::NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish sequence mempool removal %s\n", transaction.GetHash().GetHex());
+    return SendSequenceMessage(*this, transaction.GetHash(), 'R', &mempool_sequence);
+}
+
+bool CZMQPublishHashStakeNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& /*block*/)
+{
+    if (!pindex->IsProofOfStake()) {
+        return true;
+    }
+    LogPrint(BCLog::ZMQ, "zmq: Publish hashstake %s\n", pindex->GetBlockHash().GetHex());
+
+    /* block hash, proof-of-stake hash, staked outpoint and stake time */
+    std::string data;
+    AppendReversedHash(data, pindex->GetBlockHash());
+    AppendReversedHash(data, pindex->hashProofOfStake);
+    AppendReversedHash(data, pindex->prevoutStake.hash);
+    unsigned char buf[sizeof(uint32_t)];
+    WriteLE32(buf, pindex->prevoutStake.n);
+    data.append((const char*)buf, sizeof(buf));
+    WriteLE32(buf, pindex->nStakeTime);
+    data.append((const char*)buf, sizeof(buf));
+    return SendMessage(MSG_HASHSTAKE, data.data(), data.size());
+}
+
+bool CZMQPublishStakeModifierNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& /*block*/)
+{
+    if (!pindex->GeneratedStakeModifier()) {
+        return true;
+    }
+    LogPrint(BCLog::ZMQ, "zmq: Publish stakemodifier %016x at %s\n", pindex->nStakeModifier, pindex->GetBlockHash().GetHex());
+
+    /* block hash and the stake modifier it generated */
+    std::string data;
+    AppendReversedHash(data, pindex->GetBlockHash());
+    unsigned char buf[sizeof(uint64_t)];
+    WriteLE64(buf, pindex->nStakeModifier);
+    data.append((const char*)buf, sizeof(buf));
+    return SendMessage(MSG_STAKEMODIFIER, data.data(), data.size());
 }
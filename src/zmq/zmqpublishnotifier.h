@@ -7,14 +7,41 @@
 
 #include <zmq/zmqabstractnotifier.h>
 
+#include <sync.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
 class CBlockIndex;
 
+/** A message kept after publishing, for subscribers to recover from gaps */
+struct CZMQReplayMessage
+{
+    uint32_t sequence;
+    std::string body;
+};
+
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
     uint32_t nSequence {0U}; //!< upcounting per message sequence number
 
+    //! Notifications held back until batch_size of them can be sent together
+    std::string m_batch;
+    int m_batch_count{0};
+    const char* m_batch_command{nullptr};
+    //! Time the first notification of the batch was held back, in microseconds
+    int64_t m_batch_time{0};
+
+    mutable Mutex m_replay_mutex;
+    std::deque<CZMQReplayMessage> m_replay GUARDED_BY(m_replay_mutex);
+    size_t m_replay_bytes GUARDED_BY(m_replay_mutex){0};
+    uint32_t m_replay_next GUARDED_BY(m_replay_mutex){0}; //!< sequence number of the next message
+
 public:
+    //! Upper bound of the memory used by the replay buffer of one notifier
+    static const size_t MAX_ZMQ_REPLAY_BYTES = 32 * 1024 * 1024;
 
     /* send zmq multipart message
        parts:
@@ -24,14 +51,22 @@ public:
     */
     bool SendMessage(const char *command, const void* data, size_t size);
 
+    /* send a message, or append it to the current batch if batching is enabled */
+    bool SendBatchedMessage(const char *command, const void* data, size_t size);
+
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
+    bool Flush(int64_t max_age = 0) override;
+
+    /** Copy the kept messages with sequence numbers from start on to out.
+     *  Returns false if messages from start on have already been dropped. */
+    bool GetReplay(uint32_t start, std::vector<CZMQReplayMessage>& out) const;
 };
 
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -43,7 +78,7 @@ public:
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
@@ -52,4 +87,25 @@ public:
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
+class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnect(const CBlockIndex *pindex) override;
+    bool NotifyBlockDisconnect(const CBlockIndex *pindex) override;
+    bool NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence) override;
+    bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
+};
+
+class CZMQPublishHashStakeNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
+};
+
+class CZMQPublishStakeModifierNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) override;
+};
+
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
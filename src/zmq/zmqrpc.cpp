@@ -26,6 +26,8 @@ UniValue getzmqnotifications(const JSONRPCRequest& request)
                             {RPCResult::Type::STR, "type", "Type of notification"},
                             {RPCResult::Type::STR, "address", "Address of the publisher"},
                             {RPCResult::Type::NUM, "hwm", "Outbound message high water mark"},
+                            {RPCResult::Type::NUM, "batch", "Maximum number of notifications per message"},
+                            {RPCResult::Type::NUM, "replay", "Number of recent messages kept for replay over REST"},
                         }},
                     }
                 },
@@ -42,6 +44,8 @@ UniValue getzmqnotifications(const JSONRPCRequest& request)
             obj.pushKV("type", n->GetType());
             obj.pushKV("address", n->GetAddress());
             obj.pushKV("hwm", n->GetOutboundMessageHighWaterMark());
+            obj.pushKV("batch", n->GetBatchSize());
+            obj.pushKV("replay", n->GetReplaySize());
             result.push_back(obj);
         }
     }
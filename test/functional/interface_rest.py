@@ -265,6 +265,22 @@ class RESTTest (BitcoinTestFramework):
         assert_equal(resp.read().decode('utf-8').rstrip(), "Invalid height: -1")
         self.test_rest_request("/blockhashbyheight/", ret_type=RetType.OBJ, status=400)
 
+        self.log.info("Test the /blockrange URI")
+        height = block_json_obj['height']
+        resp_bytes = self.test_rest_request("/blockrange/{}/2/undo".format(height - 1), req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        offset = 0
+        for block_height in [height - 1, height]:
+            for expected in [self.nodes[0].getblock(self.nodes[0].getblockhash(block_height), 0), None]:
+                size = int.from_bytes(resp_bytes[offset:offset + 4], 'little')
+                offset += 4
+                if expected is not None:
+                    assert_equal(resp_bytes[offset:offset + size].hex(), expected)
+                offset += size
+        assert_equal(offset, len(resp_bytes))
+        self.test_rest_request("/blockrange/{}/1".format(height + 1), req_type=ReqType.BIN, ret_type=RetType.OBJ, status=404)
+        self.test_rest_request("/blockrange/0/0", req_type=ReqType.BIN, ret_type=RetType.OBJ, status=400)
+        self.test_rest_request("/blockrange/0/1", ret_type=RetType.OBJ, status=404)
+
         # Compare with json block header
         json_obj = self.test_rest_request("/headers/1/{}".format(bb_hash))
         assert_equal(len(json_obj), 1)  # ensure that there is one header in the json response
@@ -27,12 +27,18 @@ class RPCInterfaceTest(BitcoinTestFramework):
     def test_getrpcinfo(self):
         self.log.info("Testing getrpcinfo...")
 
+        self.nodes[0].getblockcount()
         info = self.nodes[0].getrpcinfo()
         assert_equal(len(info['active_commands']), 1)
 
         command = info['active_commands'][0]
         assert_equal(command['method'], 'getrpcinfo')
         assert_greater_than_or_equal(command['duration'], 0)
+        assert_greater_than_or_equal(info['methods']['getblockcount']['calls'], 1)
+        work_queue = info['work_queue']
+        assert_greater_than_or_equal(work_queue['threads'], work_queue['min_threads'])
+        assert_greater_than_or_equal(work_queue['max_threads'], work_queue['threads'])
+        assert_equal(sorted(work_queue['lanes'].keys()), ['high', 'low', 'normal'])
         assert_equal(info['logpath'], os.path.join(self.nodes[0].datadir, self.chain, 'debug.log'))
 
     def test_batch_request(self):
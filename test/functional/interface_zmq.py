@@ -3,7 +3,10 @@
 # Distributed under the MIT software license, see the accompanying
 # file COPYING or http://www.opensource.org/licenses/mit-license.php.
 """Test the ZMQ notification interface."""
+import http.client
+import json
 import struct
+import urllib.parse
 
 from test_framework.address import ADDRESS_BCRT1_UNSPENDABLE
 from test_framework.test_framework import BitcoinTestFramework
@@ -48,6 +51,7 @@ class ZMQTest (BitcoinTestFramework):
         try:
             self.test_basic()
             self.test_reorg()
+            self.test_sequence()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -122,10 +126,10 @@ class ZMQTest (BitcoinTestFramework):
 
         self.log.info("Test the getzmqnotifications RPC")
         assert_equal(self.nodes[0].getzmqnotifications(), [
-            {"type": "pubhashblock", "address": address, "hwm": 1000},
-            {"type": "pubhashtx", "address": address, "hwm": 1000},
-            {"type": "pubrawblock", "address": address, "hwm": 1000},
-            {"type": "pubrawtx", "address": address, "hwm": 1000},
+            {"type": "pubhashblock", "address": address, "hwm": 1000, "batch": 1, "replay": 1000},
+            {"type": "pubhashtx", "address": address, "hwm": 1000, "batch": 1, "replay": 1000},
+            {"type": "pubrawblock", "address": address, "hwm": 1000, "batch": 1, "replay": 1000},
+            {"type": "pubrawtx", "address": address, "hwm": 1000, "batch": 1, "replay": 1000},
         ])
 
         assert_equal(self.nodes[1].getzmqnotifications(), [])
@@ -156,5 +160,46 @@ class ZMQTest (BitcoinTestFramework):
         # Should receive nodes[1] tip
         assert_equal(self.nodes[1].getbestblockhash(), hashblock.receive().hex())
 
+    def test_sequence(self):
+        import zmq
+        address = 'tcp://127.0.0.1:28334'
+        socket = self.ctx.socket(zmq.SUB)
+        socket.set(zmq.RCVTIMEO, 60000)
+        seq = ZMQSubscriber(socket, b'sequence')
+
+        self.restart_node(0, ['-zmqpub%s=%s' % (seq.topic.decode(), address), '-rest'])
+        socket.connect(address)
+        # Relax so that the subscriber is ready before publishing zmq messages
+        sleep(0.2)
+
+        self.log.info("Test block connect sequence notifications")
+        blockhash = self.nodes[0].generatetoaddress(1, ADDRESS_BCRT1_UNSPENDABLE)[0]
+        assert_equal(seq.receive(), bytes.fromhex(blockhash) + b'C')
+
+        mempool_sequence = 0
+        if self.is_wallet_compiled():
+            self.log.info("Test mempool acceptance sequence notifications")
+            txid = self.nodes[0].sendtoaddress(self.nodes[0].getnewaddress(), 1.0)
+            mempool_sequence += 1
+            assert_equal(seq.receive(), bytes.fromhex(txid) + b'A' + struct.pack('<Q', mempool_sequence))
+
+        self.log.info("Test replay of missed messages over REST")
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', '/rest/zmq/sequence/0.json')
+        resp = conn.getresponse()
+        assert_equal(resp.status, 200)
+        replay = json.loads(resp.read().decode('utf-8'))
+        assert_equal(replay[0], {"sequence": 0, "hex": blockhash + b'C'.hex()})
+        assert_equal(len(replay), seq.sequence)
+        conn.request('GET', '/rest/zmq/sequence/%d.json' % seq.sequence)
+        resp = conn.getresponse()
+        assert_equal(resp.status, 200)
+        assert_equal(json.loads(resp.read().decode('utf-8')), [])
+        conn.request('GET', '/rest/zmq/hashtx/0.json')
+        resp = conn.getresponse()
+        assert_equal(resp.status, 404)
+        resp.read()
+
 if __name__ == '__main__':
     ZMQTest().main()
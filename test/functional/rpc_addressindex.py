@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the address index and the getaddresshistory and getaddressutxos RPCs."""
+import http.client
+import json
+import urllib.parse
+
+from test_framework.authproxy import JSONRPCException
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    connect_nodes,
+    disconnect_nodes,
+    wait_until,
+)
+
+
+class AddressIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [["-rest"], []]
+
+    def history(self, address, start=None, end=None):
+        args = [address] + ([start, end] if start is not None else [])
+        return self.nodes[0].getaddresshistory(*args)
+
+    def run_test(self):
+        address = self.nodes[1].get_deterministic_priv_key().address
+        other = self.nodes[0].get_deterministic_priv_key().address
+
+        self.log.info("Mine blocks to an address, deep enough to be indexed in parallel on restart")
+        self.nodes[1].generatetoaddress(5, address)
+        self.nodes[1].generatetoaddress(150, other)
+        self.sync_all()
+        self.restart_node(0, extra_args=["-addressindex", "-rest"])
+        connect_nodes(self.nodes[0], 1)
+        wait_until(self.index_ready, timeout=60)
+
+        history = self.history(address)
+        assert_equal(len(history["outputs"]), 5)
+        assert_equal([o["height"] for o in history["outputs"]], [1, 2, 3, 4, 5])
+        for output in history["outputs"]:
+            assert_equal(output["txid"], self.nodes[0].getblock(self.nodes[0].getblockhash(output["height"]))["tx"][0])
+            assert "spent" not in output
+        assert_equal(history["spends"], [])
+        assert_equal(len(self.history(address, 2, 3)["outputs"]), 2)
+        assert_equal(self.history(address, 6, 10)["outputs"], [])
+
+        utxos = self.nodes[0].getaddressutxos(address)
+        assert_equal(len(utxos["utxos"]), 5)
+        assert_equal(utxos["balance"], sum(o["amount"] for o in history["outputs"]))
+
+        self.log.info("New blocks are indexed as they are connected")
+        self.nodes[0].generatetoaddress(1, address)
+        self.nodes[0].syncwithvalidationinterfacequeue()
+        assert_equal(len(self.history(address)["outputs"]), 6)
+
+        self.log.info("Disconnected blocks are removed from the index")
+        disconnect_nodes(self.nodes[0], 1)
+        self.nodes[0].invalidateblock(self.nodes[0].getbestblockhash())
+        self.nodes[0].syncwithvalidationinterfacequeue()
+        assert_equal(len(self.history(address)["outputs"]), 5)
+
+        self.log.info("Query the history over REST")
+        url = urllib.parse.urlparse(self.nodes[0].url)
+        conn = http.client.HTTPConnection(url.hostname, url.port)
+        conn.request('GET', '/rest/addresshistory/%s/2/4.json' % address)
+        resp = conn.getresponse()
+        assert_equal(resp.status, 200)
+        assert_equal(json.loads(resp.read().decode('utf-8')), self.history(address, 2, 4))
+        conn.request('GET', '/rest/addresshistory/%s/4/2.json' % address)
+        resp = conn.getresponse()
+        assert_equal(resp.status, 400)
+        resp.read()
+
+        self.log.info("Check errors")
+        assert_raises_rpc_error(-5, "Invalid address or script", self.nodes[0].getaddresshistory, "notanaddress")
+        assert_raises_rpc_error(-8, "Invalid height range", self.nodes[0].getaddresshistory, address, 5, 1)
+        assert_raises_rpc_error(-1, "Address index is not enabled", self.nodes[1].getaddresshistory, address)
+
+    def index_ready(self):
+        try:
+            self.history(self.nodes[1].get_deterministic_priv_key().address)
+            return True
+        except JSONRPCException:
+            return False
+
+
+if __name__ == '__main__':
+    AddressIndexTest().main()
@@ -160,6 +160,24 @@ class GetblockstatsTest(BitcoinTestFramework):
         assert_raises_rpc_error(-1, 'getblockstats hash_or_height ( stats )', self.nodes[0].getblockstats, '00', 1, 2)
         assert_raises_rpc_error(-1, 'getblockstats hash_or_height ( stats )', self.nodes[0].getblockstats)
 
+        self.log.info('Test ranges of blocks')
+        tip = self.start_height + self.max_stat_pos
+        assert_equal(self.nodes[0].getblockstatsrange(self.start_height, tip), self.expected_stats)
+        assert_equal(self.nodes[0].getblockstatsrange(tip, tip, ['height', 'totalfee']),
+                     [{'height': tip, 'totalfee': self.expected_stats[-1]['totalfee']}])
+        first_time = self.expected_stats[0]['time']
+        last_time = self.expected_stats[-1]['time']
+        assert_equal([s['height'] for s in self.nodes[0].getblockstatsrange(first_time, last_time, ['height'], True)
+                      if s['height'] >= self.start_height], list(range(self.start_height, tip + 1)))
+        assert_equal(self.nodes[0].getblockstatsrange(last_time + 1, last_time + 1000, [], True), [])
+        assert_raises_rpc_error(-8, 'Invalid range', self.nodes[0].getblockstatsrange, 2, 1)
+        assert_raises_rpc_error(-8, 'Block height out of range', self.nodes[0].getblockstatsrange, 0, tip + 1)
+
+        self.log.info('Test the block stats index gives the same results')
+        self.restart_node(0, extra_args=['-blockstatsindex'])
+        assert_equal(self.get_stats(), self.expected_stats)
+        assert_equal(self.nodes[0].getblockstatsrange(self.start_height, tip), self.expected_stats)
+
 
 if __name__ == '__main__':
     GetblockstatsTest().main()
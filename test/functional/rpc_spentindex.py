@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test the spent index, the getspentinfo RPC and input values in getblock and getrawtransaction."""
+from decimal import Decimal
+
+from test_framework.authproxy import JSONRPCException
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    connect_nodes,
+    disconnect_nodes,
+    wait_until,
+)
+
+
+class SpentIndexTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+
+    def run_test(self):
+        key = self.nodes[1].get_deterministic_priv_key()
+
+        self.log.info("Spend a coinbase, deep enough to be indexed in parallel on restart")
+        self.nodes[1].generatetoaddress(151, key.address)
+        prevtx = self.nodes[1].getblock(self.nodes[1].getblockhash(1), 2)['tx'][0]
+        value = prevtx['vout'][0]['value']
+        fee = Decimal("0.001")
+        rawtx = self.nodes[1].createrawtransaction(
+            inputs=[{'txid': prevtx['txid'], 'vout': 0}],
+            outputs=[{key.address: value - fee}],
+        )
+        sigtx = self.nodes[1].signrawtransactionwithkey(
+            hexstring=rawtx,
+            privkeys=[key.key],
+            prevtxs=[{
+                'txid': prevtx['txid'],
+                'vout': 0,
+                'scriptPubKey': prevtx['vout'][0]['scriptPubKey']['hex'],
+            }],
+        )['hex']
+        txid = self.nodes[1].sendrawtransaction(sigtx)
+        spend_hash = self.nodes[1].generatetoaddress(1, key.address)[0]
+        self.nodes[1].generatetoaddress(100, key.address)
+        self.sync_all()
+        self.restart_node(0, extra_args=["-spentindex"])
+        connect_nodes(self.nodes[0], 1)
+        wait_until(lambda: self.index_ready(prevtx['txid']), timeout=60)
+
+        info = self.nodes[0].getspentinfo(prevtx['txid'], 0)
+        assert_equal(info['txid'], txid)
+        assert_equal(info['vin'], 0)
+        assert_equal(info['height'], 152)
+        assert_equal(info['prevout']['generated'], True)
+        assert_equal(info['prevout']['height'], 1)
+        assert_equal(info['prevout']['value'], value)
+        assert_equal(info['prevout']['scriptPubKey']['hex'], prevtx['vout'][0]['scriptPubKey']['hex'])
+
+        self.log.info("Input values and fees are reported by getblock and getrawtransaction")
+        block = self.nodes[0].getblock(spend_hash, 2)
+        assert 'fee' not in block['tx'][0]
+        assert_equal(block['tx'][1]['fee'], fee)
+        assert_equal(block['tx'][1]['vin'][0]['prevout']['value'], value)
+        tx = self.nodes[0].getrawtransaction(txid, True)
+        assert_equal(tx['fee'], fee)
+        assert_equal(tx['vin'][0]['prevout'], info['prevout'])
+        assert 'fee' not in self.nodes[1].getrawtransaction(txid, True)
+
+        self.log.info("Disconnected blocks are removed from the index")
+        disconnect_nodes(self.nodes[0], 1)
+        self.nodes[0].invalidateblock(spend_hash)
+        self.nodes[0].syncwithvalidationinterfacequeue()
+        assert_raises_rpc_error(-5, "Output is unspent", self.nodes[0].getspentinfo, prevtx['txid'], 0)
+        self.nodes[0].reconsiderblock(spend_hash)
+        self.nodes[0].syncwithvalidationinterfacequeue()
+        assert_equal(self.nodes[0].getspentinfo(prevtx['txid'], 0)['txid'], txid)
+
+        self.log.info("Check errors")
+        assert_raises_rpc_error(-5, "Output is unspent", self.nodes[0].getspentinfo, txid, 0)
+        assert_raises_rpc_error(-1, "Spent index is not enabled", self.nodes[1].getspentinfo, txid, 0)
+
+    def index_ready(self, txid):
+        try:
+            self.nodes[0].getspentinfo(txid, 0)
+            return True
+        except JSONRPCException:
+            return False
+
+
+if __name__ == '__main__':
+    SpentIndexTest().main()
@@ -83,6 +83,7 @@ BASE_SCRIPTS = [
     'feature_block.py',
     'rpc_fundrawtransaction.py',
     'p2p_compactblocks.py',
+    'p2p_blockfilters.py',
     'feature_segwit.py',
     # vv Tests less than 2m vv
     'wallet_basic.py',
@@ -164,6 +165,8 @@ BASE_SCRIPTS = [
     'wallet_txn_clone.py --mineblock',
     'feature_notifications.py',
     'rpc_getblockfilter.py',
+    'rpc_addressindex.py',
+    'rpc_spentindex.py',
     'rpc_invalidateblock.py',
     'mempool_packages.py',
     'mempool_package_onemore.py',
@@ -178,6 +181,8 @@ BASE_SCRIPTS = [
     'mempool_accept.py',
     'mempool_expiry.py',
     'wallet_import_rescan.py',
+    'wallet_fast_rescan.py',
+    'wallet_staking.py',
     'wallet_import_with_label.py',
     'rpc_bind.py --ipv4',
     'rpc_bind.py --ipv6',
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that wallet rescans skipping blocks by their filters find the same transactions."""
+from decimal import Decimal
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    connect_nodes,
+    disconnect_nodes,
+    wait_until,
+)
+
+NUM_ADDRESSES = 6
+EMPTY_BLOCKS_BETWEEN = 20
+
+
+class WalletFastRescanTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [["-blockfilterindex=1"], []]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.generatetoaddress(151, node.getnewaddress())
+
+        self.log.info("Receive coins to wallet addresses with empty blocks in between")
+        receiver = self.nodes[1]
+        keys = []
+        for i in range(NUM_ADDRESSES):
+            address = receiver.getnewaddress()
+            keys.append(receiver.dumpprivkey(address))
+            node.sendtoaddress(address, i + 1)
+            node.generatetoaddress(EMPTY_BLOCKS_BETWEEN, node.getnewaddress())
+        # Spend from the receiving wallet too, so the rescan must find inputs
+        receiver.sendtoaddress(node.getnewaddress(), 1)
+        node.generatetoaddress(EMPTY_BLOCKS_BETWEEN, node.getnewaddress())
+        self.sync_all()
+        expected_txids = self.get_txids(receiver)
+        assert_equal(len(expected_txids), NUM_ADDRESSES + 1)
+
+        tip = node.getbestblockhash()
+        wait_until(lambda: self.filter_indexed(node, tip), timeout=60)
+
+        self.log.info("Rescan using block filters")
+        node.createwallet(wallet_name="fast")
+        fast = node.get_wallet_rpc("fast")
+        for key in keys:
+            fast.importprivkey(key, "", False)
+        fast.rescanblockchain()
+        assert_equal(self.get_txids(fast), expected_txids)
+
+        self.log.info("Rescan without block filters")
+        receiver.createwallet(wallet_name="slow")
+        slow = receiver.get_wallet_rpc("slow")
+        for key in keys:
+            slow.importprivkey(key, "", False)
+        slow.rescanblockchain()
+        assert_equal(self.get_txids(slow), expected_txids)
+
+        self.log.info("Rescan using block filters after importing keys with rescan")
+        node.createwallet(wallet_name="import")
+        imported = node.get_wallet_rpc("import")
+        for key in keys:
+            imported.importprivkey(key)
+        assert_equal(self.get_txids(imported), expected_txids)
+
+        self.log.info("Rescan a block conflicting through an input the wallet does not know of")
+        self.test_foreign_conflict("conflict", own_payee=False)
+
+        self.log.info("Rescan a block conflicting through the payee output of a wallet transaction")
+        self.test_foreign_conflict("conflict_payee", own_payee=True)
+
+    def test_foreign_conflict(self, wallet_name, own_payee):
+        node = self.nodes[0]
+        receiver = self.nodes[1]
+        node.createwallet(wallet_name=wallet_name)
+        conflict = node.get_wallet_rpc(wallet_name)
+        default = node.get_wallet_rpc("")
+        default.sendtoaddress(conflict.getnewaddress(), 2)
+        node.generatetoaddress(1, default.getnewaddress())
+        if own_payee:
+            # The wallet knows the transaction of the coin, but the coin is not its own
+            payment_txid = conflict.sendtoaddress(default.getnewaddress(), 1)
+            node.generatetoaddress(1, default.getnewaddress())
+            foreign = next(u for u in default.listunspent() if u["txid"] == payment_txid)
+        else:
+            foreign = default.listunspent()[0]
+        self.sync_all()
+        coin = conflict.listunspent()[0]
+        fee = Decimal("0.001")
+
+        # The wallet transaction spends its own coin and a coin of the default wallet
+        spend = default.createrawtransaction(
+            [{"txid": coin["txid"], "vout": coin["vout"]}, {"txid": foreign["txid"], "vout": foreign["vout"]}],
+            {default.getnewaddress(): coin["amount"] + foreign["amount"] - fee})
+        spend = conflict.signrawtransactionwithwallet(spend)["hex"]
+        spend = default.signrawtransactionwithwallet(spend)["hex"]
+        # Only the default wallet coin is spent by the conflict, which pays no wallet script
+        double_spend = default.createrawtransaction(
+            [{"txid": foreign["txid"], "vout": foreign["vout"]}],
+            {default.getnewaddress(): foreign["amount"] - fee})
+        double_spend = default.signrawtransactionwithwallet(double_spend)["hex"]
+
+        disconnect_nodes(node, 1)
+        spend_txid = node.sendrawtransaction(spend)
+        assert_equal(conflict.gettransaction(spend_txid)["confirmations"], 0)
+        node.unloadwallet(wallet_name)
+        receiver.sendrawtransaction(double_spend)
+        receiver.generatetoaddress(1, default.getnewaddress())
+        connect_nodes(node, 1)
+        self.sync_all()
+
+        tip = node.getbestblockhash()
+        wait_until(lambda: self.filter_indexed(node, tip), timeout=60)
+        node.loadwallet(wallet_name)
+        assert_equal(conflict.gettransaction(spend_txid)["confirmations"], -1)
+        # The coin of the wallet is spendable again
+        assert coin["txid"] in [u["txid"] for u in conflict.listunspent()]
+
+    def get_txids(self, wallet):
+        return sorted(set(tx['txid'] for tx in wallet.listtransactions("*", 1000) if tx['category'] in ("receive", "send")))
+
+    def filter_indexed(self, node, block_hash):
+        try:
+            node.getblockfilter(block_hash)
+            return True
+        except Exception:
+            return False
+
+
+if __name__ == '__main__':
+    WalletFastRescanTest().main()
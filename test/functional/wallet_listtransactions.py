@@ -11,6 +11,7 @@ from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
     assert_array_result,
     assert_equal,
+    connect_nodes,
     hex_str_to_bytes,
 )
 
@@ -42,13 +43,18 @@ class ListTransactionsTest(BitcoinTestFramework):
         # mine a block, confirmations should change:
         blockhash = self.nodes[0].generate(1)[0]
         blockheight = self.nodes[0].getblockheader(blockhash)['height']
+        blocktime = self.nodes[0].getblockheader(blockhash)['time']
         self.sync_all()
         assert_array_result(self.nodes[0].listtransactions(),
                             {"txid": txid},
-                            {"category": "send", "amount": Decimal("-0.1"), "confirmations": 1, "blockhash": blockhash, "blockheight": blockheight})
+                            {"category": "send", "amount": Decimal("-0.1"), "confirmations": 1, "blockhash": blockhash, "blockheight": blockheight, "blocktime": blocktime})
         assert_array_result(self.nodes[1].listtransactions(),
                             {"txid": txid},
-                            {"category": "receive", "amount": Decimal("0.1"), "confirmations": 1, "blockhash": blockhash, "blockheight": blockheight})
+                            {"category": "receive", "amount": Decimal("0.1"), "confirmations": 1, "blockhash": blockhash, "blockheight": blockheight, "blocktime": blocktime})
+        # the block time is restored when the wallet is loaded
+        self.restart_node(1)
+        connect_nodes(self.nodes[0], 1)
+        assert_equal(self.nodes[1].gettransaction(txid)["blocktime"], blocktime)
 
         # send-to-self:
         txid = self.nodes[0].sendtoaddress(self.nodes[0].getnewaddress(), 0.2)
@@ -102,5 +108,13 @@ class ListTransactionsTest(BitcoinTestFramework):
                             {"category": "receive", "amount": Decimal("0.1")},
                             {"txid": txid, "label": "watchonly"})
 
+        self.log.info("Test paging through the transaction history")
+        full = self.nodes[0].listtransactions(count=1000)
+        assert len(full) > 10
+        for skip in (0, 1, 3, len(full) - 2, len(full), len(full) + 5):
+            for count in (0, 1, 4):
+                end = len(full) - skip
+                assert_equal(self.nodes[0].listtransactions(count=count, skip=skip), full[max(0, end - count):max(0, end)])
+
 if __name__ == '__main__':
     ListTransactionsTest().main()
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# Copyright (c) 2020 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that the staker only searches the coins of wallets with staking enabled."""
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import (
+    assert_equal,
+    assert_raises_rpc_error,
+    wait_until,
+)
+
+
+class WalletStakingTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def run_test(self):
+        node = self.nodes[0]
+
+        self.log.info("Staking needs a loaded wallet")
+        node.unloadwallet(self.default_wallet_name)
+        assert_raises_rpc_error(-18, "No wallet is loaded", node.stakingstart)
+        node.loadwallet(self.default_wallet_name)
+        default = node.get_wallet_rpc(self.default_wallet_name)
+        default.setstaking(False)
+
+        self.log.info("Fund two wallets and disable staking in one of them")
+        node.createwallet("staking")
+        node.createwallet("idle")
+        staking = node.get_wallet_rpc("staking")
+        idle = node.get_wallet_rpc("idle")
+        default.generatetoaddress(101, default.getnewaddress())
+        default.sendtoaddress(staking.getnewaddress(), 10)
+        default.sendtoaddress(idle.getnewaddress(), 10)
+        default.generatetoaddress(100, default.getnewaddress())
+
+        assert_equal(idle.setstaking(False)["enabled"], False)
+        assert_equal(idle.getwalletinfo()["staking_enabled"], False)
+        assert_equal(staking.setstaking()["enabled"], True)
+        assert_equal(staking.getwalletinfo()["staking_enabled"], True)
+
+        self.log.info("Only the wallet with staking enabled is searched")
+        assert_equal(node.stakingstart()["status"], "active")
+        wait_until(lambda: staking.setstaking()["searches"] > 0, timeout=60)
+        assert_equal(node.stakingstatus()["status"], "active")
+        node.stakingstop()
+        for wallet in (idle, default):
+            state = wallet.setstaking()
+            assert_equal(state["searches"], 0)
+            assert_equal(state["found"], 0)
+            assert_equal(wallet.getwalletinfo()["stake_searches"], 0)
+
+        self.log.info("Staking is enabled again when the wallet is reloaded")
+        node.unloadwallet("idle")
+        node.loadwallet("idle")
+        assert_equal(idle.setstaking()["enabled"], True)
+        assert_equal(idle.getwalletinfo()["staking_enabled"], True)
+
+
+if __name__ == '__main__':
+    WalletStakingTest().main()